@@ -48,6 +48,14 @@ static void cell_destroy (GtsObject * object)
   }
   g_assert (c->volumes == NULL);
 
+  /*a pool cell does the work of the tetrahedron destroy method and
+    goes back to its pool rather than to the heap*/
+  if ( c->pool != NULL ) {
+    tetrahedron_disconnect(GTV_TETRAHEDRON(c)) ;
+    object_pool_release(c->pool, object) ;
+    return ;
+  }
+
   /* do not forget to call destroy method of the parent */
   (* GTS_OBJECT_CLASS (gtv_cell_class ())->parent_class->destroy) 
     (object);
@@ -62,6 +70,8 @@ static void gtv_cell_class_init (GtvCellClass * klass)
 static void gtv_cell_init (GtvCell * object)
 {
   /* initialize object here */
+  object->neighbours[0] = object->neighbours[1] = 
+    object->neighbours[2] = object->neighbours[3] = NULL ;
 }
 
 /** 
@@ -121,6 +131,24 @@ GtvCell * gtv_cell_new (GtvCellClass * klass,
   return object;
 }
 
+GtvCell *volume_cell_new(GtvVolume *v, GtvCellClass *klass,
+			 GtvFacet *f1, GtvFacet *f2,
+			 GtvFacet *f3, GtvFacet *f4)
+
+{
+  GtvCell *c ;
+
+  if ( v == NULL ||
+       (c = GTV_CELL(object_pool_alloc(v->cell_pool,
+				       GTS_OBJECT_CLASS(klass)))) == NULL )
+    return gtv_cell_new(klass, f1, f2, f3, f4) ;
+
+  c->pool = v->cell_pool ;
+  gtv_tetrahedron_set(GTV_TETRAHEDRON(c), f1, f2, f3, f4) ;
+
+  return c ;
+}
+
 /** 
  * Find the neighbours of a ::GtvCell.
  * 
@@ -142,6 +170,14 @@ GSList *gtv_cell_neighbours(GtvCell *c, GtvVolume *v)
   if ( v != NULL ) 
     g_return_val_if_fail(GTV_IS_VOLUME(v), NULL) ;
 
+  if ( v != NULL && cell_has_single_volume(c) && c->volumes->data == v ) {
+    gint k ;
+    for ( k = 0 ; k < 4 ; k ++ ) 
+      if ( c->neighbours[k] != NULL ) 
+	n = g_slist_prepend(n, c->neighbours[k]) ;
+    return n ;
+  }
+
   f[0] = GTV_TETRAHEDRON(c)->f1 ;
   f[1] = GTV_TETRAHEDRON(c)->f2 ;
   f[2] = GTV_TETRAHEDRON(c)->f3 ;
@@ -163,6 +199,61 @@ GSList *gtv_cell_neighbours(GtvCell *c, GtvVolume *v)
   return n ;
 }
 
+/** 
+ * Find the neighbour of a ::GtvCell across one of its facets, in the
+ * ::GtvVolume containing the cell. The neighbours of a cell are set
+ * when it is added to a volume, and cleared when it is removed, so
+ * this is a constant-time operation. If a cell belongs to more than
+ * one volume, the neighbour is found from the cells using \a f and is
+ * a cell which shares a volume with \a c.
+ * 
+ * @param c a ::GtvCell;
+ * @param f a ::GtvFacet of \a c.
+ * 
+ * @return the ::GtvCell sharing \a f with \a c, or NULL if \a f is on
+ * the boundary of the volume or \a c is not in a volume.
+ */
+
+GtvCell *gtv_cell_neighbour(GtvCell *c, GtvFacet *f)
+
+{
+  g_return_val_if_fail(c != NULL, NULL) ;
+  g_return_val_if_fail(GTV_IS_CELL(c), NULL) ;
+  g_return_val_if_fail(f != NULL, NULL) ;
+  g_return_val_if_fail(gtv_tetrahedron_has_facet(GTV_TETRAHEDRON(c), f),
+		       NULL) ;
+
+  return cell_neighbour(c, NULL,
+			tetrahedron_facet_slot(GTV_TETRAHEDRON(c), f)) ;
+}
+
+GtvCell *cell_neighbour_scan(GtvCell *c, GtvVolume *v, gint k)
+
+/*
+  the cell of v using the facet in slot k of c, other than c, found
+  from the tetrahedra of the facet; if v is NULL, a cell sharing a
+  volume with c
+*/
+
+{
+  GSList *i, *j ;
+  GtvCell *n ;
+
+  for ( i = tetrahedron_facet(GTV_TETRAHEDRON(c), k)->tetrahedra ; i != NULL ;
+	i = i->next ) {
+    n = i->data ;
+    if ( n == c || !GTV_IS_CELL(n) ) continue ;
+    if ( v != NULL ) {
+      if ( gtv_cell_has_parent_volume(n, v) ) return n ;
+      continue ;
+    }
+    for ( j = c->volumes ; j != NULL ; j = j->next )
+      if ( gtv_cell_has_parent_volume(n, j->data) ) return n ;
+  }
+
+  return NULL ;
+}
+
 /** 
  * Generate a new ::GtvCell from four ::GtsVertex's, making use of any
  * existing ::GtvFacet's which connect them.
@@ -187,9 +278,6 @@ GtvCell *gtv_cell_new_from_vertices(GtvCellClass *klass,
 				    GtsVertex *v4)
 
 {
-  GtvCell *c ;
-  GtvFacet *f1, *f2, *f3, *f4 ;
-
   g_return_val_if_fail(klass != NULL, NULL) ;
   g_return_val_if_fail(klass == 
 		       gts_object_class_is_from_class(klass, 
@@ -214,23 +302,43 @@ GtvCell *gtv_cell_new_from_vertices(GtvCellClass *klass,
   g_return_val_if_fail(v4 != NULL, NULL) ;
   g_return_val_if_fail(GTS_IS_VERTEX(v4), NULL) ;
   
+  return cell_new_from_vertices(NULL, klass, facet_class, edge_class,
+				v1, v2, v3, v4) ;
+}
+
+GtvCell *cell_new_from_vertices(GtvVolume *v,
+				GtvCellClass *klass,
+				GtvFacetClass *facet_class,
+				GtsEdgeClass *edge_class,
+				GtsVertex *v1, GtsVertex *v2,
+				GtsVertex *v3, GtsVertex *v4)
+
+/*
+  as gtv_cell_new_from_vertices, without the argument checks, taking
+  the new cell and facets from the pools of v if it is not NULL
+*/
+
+{
+  GtvCell *c ;
+  GtvFacet *f1, *f2, *f3, *f4 ;
+
   g_return_val_if_fail(v1 != v2 && v1 != v3 && v1 != v4 && 
 		       v2 != v3 && v2 != v4 && v3 != v4, NULL) ;  
   
   if ( (f1 = GTV_FACET(triangle_from_vertices(v2, v3, v4))) == NULL )
-    f1 = facet_new_from_vertices(facet_class, edge_class, v2, v3, v4) ;
+    f1 = facet_new_from_vertices(v, facet_class, edge_class, v2, v3, v4) ;
 
   if ( (f2 = GTV_FACET(triangle_from_vertices(v3, v4, v1))) == NULL )
-    f2 = facet_new_from_vertices(facet_class, edge_class, v3, v4, v1) ;
+    f2 = facet_new_from_vertices(v, facet_class, edge_class, v3, v4, v1) ;
 
   if ( (f3 = GTV_FACET(triangle_from_vertices(v4, v1, v2))) == NULL )
-    f3 = facet_new_from_vertices(facet_class, edge_class, v4, v1, v2) ;
+    f3 = facet_new_from_vertices(v, facet_class, edge_class, v4, v1, v2) ;
 
   if ( (f4 = GTV_FACET(triangle_from_vertices(v1, v2, v3))) == NULL )
-    f4 = facet_new_from_vertices(facet_class, edge_class, v1, v2, v3) ;
+    f4 = facet_new_from_vertices(v, facet_class, edge_class, v1, v2, v3) ;
 
   if ( (c = GTV_CELL(gtv_tetrahedron_from_facets(f1, f2, f3, f4))) == NULL )
-    c = gtv_cell_new(klass, f1, f2, f3, f4) ;
+    c = volume_cell_new(v, klass, f1, f2, f3, f4) ;
   else 
     g_debug("%s: vertices %p, %p, %p, %p already form cell %p", 
 	    __FUNCTION__, v1, v2, v3, v4, c) ;
@@ -36,6 +36,8 @@
  * 
  */
 
+gboolean gtv_delaunay_cavity_insertion = FALSE ;
+
 static inline gboolean flippable23(GtvCell *tau, GtvCell *tau1)
      /*Ledoux's method of checking convexity of intersection*/
 {
@@ -56,26 +58,66 @@ static inline gboolean flippable23(GtvCell *tau, GtvCell *tau1)
 	  != NULL) ;
 }
 
-static gint foreach_cell_check(GtvCell *t, GtvCell **c)
+static void cells_sphere_test(GtvCell **c, GtsPoint **p, gint n,
+			      gdouble *isp)
+
+/*
+  gtv_point_in_tetrahedron_sphere(p[i], c[i]) for up to four cells,
+  using the batched predicates
+*/
 
 {
-  g_debug("%s: cell %p volume %lg", __FUNCTION__, t,
-	  gtv_tetrahedron_volume(GTV_TETRAHEDRON(t))) ;
+  gdouble *a[4], *b[4], *d[4], *e[4], *x[4], o[4] ;
+  GtsVertex *v1, *v2, *v3, *v4 ;
+  gint i ;
 
-  if ( !gtv_facet_is_regular(GTV_TETRAHEDRON(t)->f1) ) {
-    *c = t ; return GTV_SUCCESS ;
+  for ( i = 0 ; i < n ; i ++ ) {
+    gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c[i]), &v1, &v2, &v3, &v4) ;
+    a[i] = &(GTS_POINT(v1)->x) ; b[i] = &(GTS_POINT(v2)->x) ;
+    d[i] = &(GTS_POINT(v3)->x) ; e[i] = &(GTS_POINT(v4)->x) ;
+    x[i] = &(p[i]->x) ;
   }
 
-  if ( !gtv_facet_is_regular(GTV_TETRAHEDRON(t)->f2) ) {
-    *c = t ; return GTV_SUCCESS ;
-  }
+  gtv_orient3d_many(a, b, d, e, n, o) ;
+  gtv_insphere_many(a, b, d, e, x, n, isp) ;
+  for ( i = 0 ; i < n ; i ++ ) if ( o[i] < 0.0 ) isp[i] = -isp[i] ;
+
+  return ;
+}
 
-  if ( !gtv_facet_is_regular(GTV_TETRAHEDRON(t)->f3) ) {
-    *c = t ; return GTV_SUCCESS ;
+static gint foreach_cell_check(GtvCell *t, gpointer data[])
+
+/*
+  t is non-Delaunay if the vertex of a neighbour opposite their
+  common facet lies inside its circumsphere; the four tests are made
+  together
+*/
+
+{
+  GtvVolume *v = data[0] ;
+  GtvCell **c = data[1] ;
+  GtvCell *cells[4], *tau ;
+  GtsPoint *p[4] ;
+  GtvFacet *f[4] ;
+  gdouble isp[4] ;
+  gint k, n ;
+
+  g_debug("%s: cell %p volume %lg", __FUNCTION__, t,
+	  gtv_tetrahedron_volume(GTV_TETRAHEDRON(t))) ;
+
+  f[0] = GTV_TETRAHEDRON(t)->f1 ; f[1] = GTV_TETRAHEDRON(t)->f2 ;
+  f[2] = GTV_TETRAHEDRON(t)->f3 ; f[3] = GTV_TETRAHEDRON(t)->f4 ;
+  for ( (k = 0), (n = 0) ; k < 4 ; k ++ ) {
+    if ( (tau = cell_neighbour(t, v, k)) == NULL ) continue ;
+    cells[n] = t ;
+    p[n] = GTS_POINT(gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau),
+						     f[k])) ;
+    n ++ ;
   }
 
-  if ( !gtv_facet_is_regular(GTV_TETRAHEDRON(t)->f4) ) {
-    *c = t ; return GTV_SUCCESS ;
+  cells_sphere_test(cells, p, n, isp) ;
+  for ( k = 0 ; k < n ; k ++ ) {
+    if ( isp[k] > 0.0 ) { *c = t ; return GTV_SUCCESS ; }
   }
 
   return GTV_SUCCESS ;
@@ -94,14 +136,17 @@ GtvCell *gtv_delaunay_check(GtvVolume *v)
 
 {
   GtvCell *c = NULL ;
+  gpointer data[2] ;
 
-  gtv_volume_foreach_cell(v, (GtsFunc)foreach_cell_check, &c) ;
+  data[0] = v ; data[1] = &c ;
+  gtv_volume_foreach_cell(v, (GtsFunc)foreach_cell_check, data) ;
 
   return c ;
 }
 
 static inline void edge_split(GtvCell *tau, GtsVertex *p, 
 			      GtsEdge *e, GSList **cells,
+			      GtvVolume *v,
 			      GtvCellClass *cell_class,
 			      GtvFacetClass *facet_class,
 			      GtsEdgeClass *edge_class)
@@ -122,12 +167,12 @@ static inline void edge_split(GtvCell *tau, GtsVertex *p,
 
   g_assert(a != b && a != c && a != d &&  b != c && b != d && c != d) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   b, a, d, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       b, a, d, p) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   c, b, d, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       c, b, d, p) ;
   *cells = g_slist_prepend(*cells, new) ;
   
   return ;
@@ -163,7 +208,7 @@ static inline void flipcell12(GtvCell *tau, GtsVertex *p, GtsEdge *e,
 
   for ( j = edge_cells ; j != NULL ; j = j->next ) {
     edge_split(GTV_CELL(j->data), p, e, cells,
-	       cell_class, facet_class, edge_class) ;
+	       v, cell_class, facet_class, edge_class) ;
     *remove = g_slist_prepend(*remove, j->data) ;
   }
 
@@ -198,16 +243,16 @@ static inline void flipcell13(GtvCell *tau, GtsVertex *p,
 
   d = gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau), f) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   a, b, d, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       a, b, d, p) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   b, c, d, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       b, c, d, p) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   c, d, a, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       c, d, a, p) ;
   *cells = g_slist_prepend(*cells, new) ;
 
   *remove = g_slist_prepend(*remove, tau) ;
@@ -216,16 +261,16 @@ static inline void flipcell13(GtvCell *tau, GtsVertex *p,
 
   d = gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau1), f) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   a, b, d, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       a, b, d, p) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   b, c, d, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       b, c, d, p) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   c, d, a, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       c, d, a, p) ;
   *cells = g_slist_prepend(*cells, new) ;
     
   *remove = g_slist_prepend(*remove, tau1) ;
@@ -233,7 +278,8 @@ static inline void flipcell13(GtvCell *tau, GtsVertex *p,
   return ;
 }
 
-static inline void flipcell14(GtvCell *c, GtsVertex *v, 
+static inline void flipcell14(GtvCell *c, GtsVertex *p, 
+			      GtvVolume *v,
 			      GtvCellClass *cell_class,
 			      GtvFacetClass *facet_class,
 			      GtsEdgeClass *edge_class,
@@ -246,22 +292,22 @@ static inline void flipcell14(GtvCell *c, GtsVertex *v,
   g_debug("%s:", __FUNCTION__) ;
   gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &v1, &v2, &v3, &v4) ;
 
-  g_assert(g_slist_length(gts_vertex_triangles(v, NULL))==0) ;
+  g_assert(g_slist_length(gts_vertex_triangles(p, NULL))==0) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				  v, v1, v3, v2) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       p, v1, v3, v2) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				  v, v2, v3, v4) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       p, v2, v3, v4) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				  v, v3, v1, v4) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       p, v3, v1, v4) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				  v, v4, v1, v2) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       p, v4, v1, v2) ;
   *cells = g_slist_prepend(*cells, new) ;
 
   *remove = g_slist_prepend(*remove, c) ;
@@ -271,6 +317,7 @@ static inline void flipcell14(GtvCell *c, GtsVertex *v,
 
 static inline void flipcell23(GtvCell *tau, GtvCell *tau1,
 			      GtvFacet *f,
+			      GtvVolume *v,
 			      GtvCellClass *cell_class,
 			      GtvFacetClass *facet_class,
 			      GtsEdgeClass *edge_class,
@@ -287,16 +334,16 @@ static inline void flipcell23(GtvCell *tau, GtvCell *tau1,
   p = gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau), f) ;
   d = gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau1), f) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   d, a, p, b) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       d, a, p, b) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   d, c, b, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       d, c, b, p) ;
   *cells = g_slist_prepend(*cells, new) ;			   
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   d, a, c, p) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       d, a, c, p) ;
   *cells = g_slist_prepend(*cells, new) ;
   
   *remove = g_slist_prepend(*remove, tau) ;
@@ -307,6 +354,7 @@ static inline void flipcell23(GtvCell *tau, GtvCell *tau1,
 
 static inline void flipcell32(GtvCell *tau, GtvCell *tau1, GtvCell *tau2,
 			      GtvFacet *f,
+			      GtvVolume *v,
 			      GtvCellClass *cell_class,
 			      GtvFacetClass *facet_class,
 			      GtsEdgeClass *edge_class,
@@ -340,12 +388,12 @@ static inline void flipcell32(GtvCell *tau, GtvCell *tau1, GtvCell *tau2,
   }
   g_assert(g == h) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   c, p, d, b) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       c, p, d, b) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   p, c, d, a) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       p, c, d, a) ;
   *cells = g_slist_prepend(*cells, new) ;			   
   
   *remove = g_slist_prepend(*remove, tau) ;
@@ -358,6 +406,7 @@ static inline void flipcell32(GtvCell *tau, GtvCell *tau1, GtvCell *tau2,
 static inline void flipcell41(GtvCell *tau, GtvCell *tau1, 
 			      GtvCell *tau2, GtvCell *tau3, 
 			      GtsVertex *p,
+			      GtvVolume *v,
 			      GtvCellClass *cell_class,
 			      GtvFacetClass *facet_class,
 			      GtsEdgeClass *edge_class,
@@ -384,8 +433,8 @@ static inline void flipcell41(GtvCell *tau, GtvCell *tau1,
 
   g_assert(a != b && a != c && a != d && b != c && b != d && c != d) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   a, b, c, d) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       a, b, c, d) ;
   *cells = g_slist_prepend(*cells, new) ;
 
   *remove = g_slist_prepend(*remove, tau) ;
@@ -398,6 +447,7 @@ static inline void flipcell41(GtvCell *tau, GtvCell *tau1,
 
 static inline void flipcell44(GtvCell *tau, GtvCell *tau1, 
 			      GtvCell *tau2, GtvCell *tau3,
+			      GtvVolume *v,
 			      GtvCellClass *cell_class,
 			      GtvFacetClass *facet_class,
 			      GtsEdgeClass *edge_class,
@@ -433,31 +483,31 @@ static inline void flipcell44(GtvCell *tau, GtvCell *tau1,
   g_assert(b == gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau3), t)) ;
   g_debug("%s: orientation of %p %p %p %p is %lg", 
 	  __FUNCTION__, b, c, d, e,
-	  gts_point_orientation_3d(GTS_POINT(b), 
+	  gtv_point_orientation_3d(GTS_POINT(b), 
 				   GTS_POINT(c), 
 				   GTS_POINT(d), 
 				   GTS_POINT(e))) ;
 	  
-  g_assert(gts_point_orientation_3d(GTS_POINT(b), 
+  g_assert(gtv_point_orientation_3d(GTS_POINT(b), 
 				    GTS_POINT(c), 
 				    GTS_POINT(d), 
 				    GTS_POINT(e)) == 0.0) ;
 #endif /*GTV_DEVELOPER_DEBUG*/
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   a, b, e, d) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       a, b, e, d) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   a, b, e, c) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       a, b, e, c) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   b, c, f, e) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       b, c, f, e) ;
   *cells = g_slist_prepend(*cells, new) ;
 
-  new = gtv_cell_new_from_vertices(cell_class, facet_class, edge_class,
-				   b, d, e, f) ;
+  new = cell_new_from_vertices(v, cell_class, facet_class, edge_class,
+			       b, d, e, f) ;
   *cells = g_slist_prepend(*cells, new) ;
 
   *remove = g_slist_prepend(*remove, tau) ;
@@ -469,6 +519,7 @@ static inline void flipcell44(GtvCell *tau, GtvCell *tau1,
 }
 
 static inline void flipcells(GtvCell *tau, GtvCell *tau1,
+			     GtvVolume *v,
 			     GtvCellClass *cell_class,
 			     GtvFacetClass *facet_class,
 			     GtsEdgeClass *edge_class,
@@ -494,7 +545,7 @@ static inline void flipcells(GtvCell *tau, GtvCell *tau1,
 
   if ( flippable23(tau, tau1) ) {
     flipcell23(tau, tau1, f,
-	       cell_class, facet_class, edge_class,
+	       v, cell_class, facet_class, edge_class,
 	       cells, remove) ;
     return ;
   }
@@ -502,14 +553,14 @@ static inline void flipcells(GtvCell *tau, GtvCell *tau1,
   tau2 = GTV_CELL(gtv_tetrahedra_wedge_neighbour(GTV_TETRAHEDRON(tau),
 						 GTV_TETRAHEDRON(tau1))) ;
   if ( tau2 != NULL ) {
-    flipcell32(tau, tau1, tau2, f, cell_class, facet_class, edge_class,
+    flipcell32(tau, tau1, tau2, f, v, cell_class, facet_class, edge_class,
 	       cells, remove) ;
     return ;
   }
 
   gts_triangle_vertices(GTS_TRIANGLE(f), &a, &b, &c) ;
   for ( i = 0 ; i < 3 ; i ++ ) {
-    if ( (orient = gts_point_orientation_3d(GTS_POINT(a), 
+    if ( (orient = gtv_point_orientation_3d(GTS_POINT(a), 
 					    GTS_POINT(b), 
 					    GTS_POINT(p), 
 					    GTS_POINT(d))) == 0.0 ) {
@@ -524,7 +575,7 @@ static inline void flipcells(GtvCell *tau, GtvCell *tau1,
 	   gtv_tetrahedra_common_facet(GTV_TETRAHEDRON(tau2), 
 				       GTV_TETRAHEDRON(tau3)) != NULL ) {
 	flipcell44(tau, tau1, tau2, tau3, 
-		   cell_class, facet_class, edge_class,
+		   v, cell_class, facet_class, edge_class,
 		   cells, remove) ;
 	return ;
       }
@@ -535,7 +586,7 @@ static inline void flipcells(GtvCell *tau, GtvCell *tau1,
   if ( gtv_tetrahedron_volume(GTV_TETRAHEDRON(tau)) == 0.0 ) {
     g_debug("%s: zero-volume tetrahedron", __FUNCTION__) ;
     flipcell23(tau, tau1, f,
-	       cell_class, facet_class, edge_class,
+	       v, cell_class, facet_class, edge_class,
 	       cells, remove) ;
     return ;
   }
@@ -631,7 +682,7 @@ gint gtv_delaunay_add_vertex_to_cell(GtvVolume *v,
   edge_class = v->edge_class ;
 
   if ( inter == GTV_IN ) flipcell14(c, p, 
-				    cell_class, facet_class, edge_class,
+				    v, cell_class, facet_class, edge_class,
 				    &remove, &cells) ;
   if ( inter == GTV_ON_FACET ) flipcell13(c, p, f, v, 
 					  cell_class, facet_class, edge_class,
@@ -672,7 +723,7 @@ gint gtv_delaunay_add_vertex_to_cell(GtvVolume *v,
       if ( gtv_point_in_tetrahedron_sphere(GTS_POINT(d),
 					   GTV_TETRAHEDRON(tau)) > 0.0 ) {
 	remove = NULL ; new = NULL ;
-	flipcells(tau, tau1, cell_class, facet_class, edge_class,
+	flipcells(tau, tau1, v, cell_class, facet_class, edge_class,
 		  &new, &remove) ;
 	for ( j = remove ; j != NULL ; j = j->next ) {
 	  gtv_volume_remove_cell(v, GTV_CELL(j->data)) ;
@@ -691,9 +742,241 @@ gint gtv_delaunay_add_vertex_to_cell(GtvVolume *v,
   return GTV_SUCCESS ;
 }
 
+static gboolean cavity_facet_is_flat(GtvFacet *f, GtsVertex *p)
+
+{
+  GtsVertex *a, *b, *c ;
+
+  gts_triangle_vertices(GTS_TRIANGLE(f), &a, &b, &c) ;
+
+  return (gtv_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
+				   GTS_POINT(c), GTS_POINT(p)) == 0.0) ;
+}
+
+static void cavity_boundary_prune(GtvVolume *v, GHashTable *cavity,
+				  GSList **boundary, GSList **outer)
+
+/*
+  remove from the boundary of a cavity the facets which have cavity
+  cells on both sides: a neighbour rejected across one facet can
+  still enter the cavity through another, leaving the first facet
+  inside it
+*/
+
+{
+  GSList *i, *j, *ni, *nj ;
+  GtvCell *tau, *tau1 ;
+  GtvFacet *f ;
+
+  for ( (i = *boundary), (j = *outer) ; i != NULL ; (i = ni), (j = nj) ) {
+    ni = i->next ; nj = j->next ;
+    f = GTV_FACET(i->data) ; tau = GTV_CELL(j->data) ;
+    tau1 = cell_neighbour(tau, v,
+			  tetrahedron_facet_slot(GTV_TETRAHEDRON(tau), f)) ;
+    if ( tau1 == NULL || g_hash_table_lookup(cavity, tau1) == NULL )
+      continue ;
+    *boundary = g_slist_delete_link(*boundary, i) ;
+    *outer = g_slist_delete_link(*outer, j) ;
+  }
+
+  return ;
+}
+
+gint delaunay_cavity_grow(GtvVolume *v, GtsVertex *p, GtvCell *c,
+			 gboolean (*lock)(GtvCell *c, gpointer data),
+			 gpointer data,
+			 GSList **cells, GSList **boundary, GSList **outer)
+
+/*
+  find the cells of v whose circumspheres contain p, starting from c
+  which contains it; boundary facets of the cavity are returned with the
+  cavity cell on their inner side in outer. If lock is not NULL, it is
+  called on each neighbour before it is examined and the search is
+  abandoned, returning GTV_FAILURE, if lock returns FALSE
+*/
+
+{
+  GHashTable *cavity ;
+  GSList *queue ;
+  GtvCell *tau, *tau1, *cells_k[4] ;
+  GtvFacet *f[4] ;
+  GtsPoint *x[4] ;
+  gdouble isp[4] ;
+  gint k, j, n, slot[4] ;
+
+  cavity = g_hash_table_new(NULL, NULL) ;
+  g_hash_table_insert(cavity, c, c) ;
+  queue = g_slist_prepend(NULL, c) ;
+  *cells = *boundary = *outer = NULL ;
+  while ( queue != NULL ) {
+    tau = GTV_CELL(queue->data) ;
+    queue = g_slist_delete_link(queue, queue) ;
+    *cells = g_slist_prepend(*cells, tau) ;
+
+    f[0] = GTV_TETRAHEDRON(tau)->f1 ; f[1] = GTV_TETRAHEDRON(tau)->f2 ;
+    f[2] = GTV_TETRAHEDRON(tau)->f3 ; f[3] = GTV_TETRAHEDRON(tau)->f4 ;
+    /*lock the unvisited neighbours, then test them together*/
+    for ( (k = 0), (n = 0) ; k < 4 ; k ++ ) {
+      tau1 = cell_neighbour(tau, v, k) ;
+      if ( tau1 != NULL && g_hash_table_lookup(cavity, tau1) != NULL )
+	continue ;
+      if ( tau1 != NULL && lock != NULL && !lock(tau1, data) ) {
+	g_slist_free(queue) ; g_slist_free(*cells) ;
+	g_slist_free(*boundary) ; g_slist_free(*outer) ;
+	*cells = *boundary = *outer = NULL ;
+	g_hash_table_destroy(cavity) ;
+	return GTV_FAILURE ;
+      }
+      slot[n] = k ; cells_k[n] = tau1 ; x[n] = GTS_POINT(p) ;
+      if ( tau1 != NULL ) n ++ ;
+      else {
+	*boundary = g_slist_prepend(*boundary, f[k]) ;
+	*outer = g_slist_prepend(*outer, tau) ;
+      }
+    }
+    cells_sphere_test(cells_k, x, n, isp) ;
+    for ( j = 0 ; j < n ; j ++ ) {
+      k = slot[j] ; tau1 = cells_k[j] ;
+      /*a neighbour whose facet is coplanar with p goes into the
+	cavity too, so that no flat cells are created*/
+      if ( isp[j] > 0.0 || cavity_facet_is_flat(f[k], p) ) {
+	g_hash_table_insert(cavity, tau1, tau1) ;
+	queue = g_slist_prepend(queue, tau1) ;
+	continue ;
+      }
+      *boundary = g_slist_prepend(*boundary, f[k]) ;
+      *outer = g_slist_prepend(*outer, tau) ;
+    }
+  }
+  cavity_boundary_prune(v, cavity, boundary, outer) ;
+  g_hash_table_destroy(cavity) ;
+
+  g_debug("%s: cavity of %d cells, %d boundary facets", __FUNCTION__,
+	  g_slist_length(*cells), g_slist_length(*boundary)) ;
+
+  return GTV_SUCCESS ;
+}
+
+GSList *delaunay_cavity_fill(GtvVolume *v, GtsVertex *p,
+			     GSList *boundary, GSList *outer)
+
+/*
+  join p to the boundary facets of a cavity, replacing the vertex of
+  the cavity cell opposite each facet so as to keep its orientation;
+  the new cells are returned but not added to v
+*/
+
+{
+  GSList *new, *i, *j ;
+  GtvCell *tau ;
+  GtsVertex *w[4], *d ;
+  gint k ;
+
+  new = NULL ;
+  for ( (i = boundary), (j = outer) ; i != NULL ;
+	(i = i->next), (j = j->next) ) {
+    tau = GTV_CELL(j->data) ;
+    d = gtv_tetrahedron_vertex_opposite(GTV_TETRAHEDRON(tau),
+					GTV_FACET(i->data)) ;
+    gtv_tetrahedron_vertices(GTV_TETRAHEDRON(tau),
+			     &w[0], &w[1], &w[2], &w[3]) ;
+    for ( k = 0 ; k < 4 ; k ++ ) if ( w[k] == d ) w[k] = p ;
+    new = g_slist_prepend(new,
+			  cell_new_from_vertices(v, v->cell_class,
+						 v->facet_class,
+						 v->edge_class,
+						 w[0], w[1], w[2], w[3])) ;
+  }
+
+  return new ;
+}
+
+/**
+ * Add a ::GtsVertex to a ::GtvCell of a ::GtvVolume, restoring the
+ * Delaunay property of the volume, using the method of Bowyer, A.,
+ * Computer Journal 24:162--166, 1981 and Watson, D. F., Computer
+ * Journal 24:167--172, 1981. The cells whose circumspheres contain \a
+ * p are found by growing a cavity out from \a c and the cavity is
+ * then filled in a single pass with cells joining \a p to its
+ * boundary facets, which are reused. Unlike
+ * ::gtv_delaunay_add_vertex_to_cell, no transient cells are created.
+ *
+ * @param v a ::GtvVolume;
+ * @param p a ::GtsVertex to add to \a v;
+ * @param c a ::GtvCell containing \a p.
+ *
+ * @return ::GTV_SUCCESS on success, non-zero if \a p is already part
+ * of \a c or coincides with a vertex of \a c.
+ */
+
+gint gtv_delaunay_add_vertex_to_cavity(GtvVolume *v,
+				       GtsVertex *p,
+				       GtvCell *c)
+
+{
+  GSList *cells, *boundary, *outer, *new, *i ;
+  GtsVertex *w[4] ;
+  GtvIntersect inter ;
+  gpointer s ;
+
+  g_debug("%s: vertex %p (%lg, %lg, %lg)", __FUNCTION__, p,
+	  GTS_POINT(p)->x, GTS_POINT(p)->y, GTS_POINT(p)->z) ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(p != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTS_IS_VERTEX(p), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(c != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_CELL(c), GTV_WRONG_TYPE) ;
+
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &w[0], &w[1], &w[2], &w[3]) ;
+  if ( p == w[0] || p == w[1] || p == w[2] || p == w[3] )
+    return GTV_VERTEX_PRESENT ;
+
+  inter = gtv_point_in_tetrahedron(GTS_POINT(p), GTV_TETRAHEDRON(c), &s) ;
+  if ( inter == GTV_OUT ) return GTV_VERTEX_NOT_IN_CELL ;
+  if ( inter == GTV_ON_VERTEX ) return GTV_COINCIDENT_VERTEX ;
+  if ( inter == GTV_ON_FACET && gtv_facet_is_boundary(GTV_FACET(s), v) )
+    return GTV_VERTEX_ON_HULL ;
+  if ( inter == GTV_ON_EDGE && gtv_edge_is_boundary(GTS_EDGE(s), v) )
+    return GTV_VERTEX_ON_HULL ;
+
+  delaunay_cavity_grow(v, p, c, NULL, NULL, &cells, &boundary, &outer) ;
+  new = delaunay_cavity_fill(v, p, boundary, outer) ;
+  g_slist_free(boundary) ; g_slist_free(outer) ;
+
+  /*the new cells hold the boundary facets, so that only the interior
+    of the cavity is destroyed with the old cells*/
+  for ( i = cells ; i != NULL ; i = i->next )
+    gtv_volume_remove_cell(v, GTV_CELL(i->data)) ;
+  g_slist_free(cells) ;
+
+  for ( i = new ; i != NULL ; i = i->next )
+    gtv_volume_add_cell(v, GTV_CELL(i->data)) ;
+  g_slist_free(new) ;
+
+  return GTV_SUCCESS ;
+}
+
+static gint delaunay_insert_vertex(GtvVolume *v, GtsVertex *p, GtvCell *c,
+				   gboolean cavity)
+
+/*
+  insert p, which lies in cell c, into v by the cavity method if
+  cavity is TRUE, otherwise by flips from the cell containing it
+*/
+
+{
+  if ( cavity ) return gtv_delaunay_add_vertex_to_cavity(v, p, c) ;
+
+  return gtv_delaunay_add_vertex_to_cell(v, p, c) ;
+}
+
 /** 
  * Add a ::GtsVertex to a ::GtvVolume, preserving the Delaunay
- * property. 
+ * property. If ::gtv_delaunay_cavity_insertion is TRUE, the vertex
+ * is inserted with ::gtv_delaunay_add_vertex_to_cavity, otherwise
+ * with ::gtv_delaunay_add_vertex_to_cell.
  * 
  * @param v a ::GtvVolume;
  * @param p a ::GtsVertex to be added to \a v;
@@ -720,7 +1003,197 @@ gint gtv_delaunay_add_vertex(GtvVolume *v, GtsVertex *p, GtvCell *c)
 
   if ( add == NULL ) return GTV_VERTEX_NOT_IN_VOLUME ;
 
-  return gtv_delaunay_add_vertex_to_cell(v, p, add) ;
+  return delaunay_insert_vertex(v, p, add, gtv_delaunay_cavity_insertion) ;
+}
+
+guint64 hilbert_key(guint32 x[])
+
+/*
+  Hilbert index of a point on a 2^HILBERT_BITS grid, using the
+  transpose method of Skilling, J., `Programming the Hilbert curve',
+  AIP Conference Proceedings 707:381--387, 2004
+*/
+
+{
+  guint32 M, P, Q, t ;
+  guint64 key ;
+  gint i, b ;
+
+  M = 1 << (HILBERT_BITS-1) ;
+
+  /*inverse undo*/
+  for ( Q = M ; Q > 1 ; Q >>= 1 ) {
+    P = Q - 1 ;
+    for ( i = 0 ; i < 3 ; i ++ ) {
+      if ( x[i] & Q ) x[0] ^= P ;
+      else {
+	t = (x[0] ^ x[i]) & P ; x[0] ^= t ; x[i] ^= t ;
+      }
+    }
+  }
+
+  /*Gray encode*/
+  x[1] ^= x[0] ; x[2] ^= x[1] ;
+  for ( (t = 0), (Q = M) ; Q > 1 ; Q >>= 1 ) if ( x[2] & Q ) t ^= Q - 1 ;
+  x[0] ^= t ; x[1] ^= t ; x[2] ^= t ;
+
+  /*interleave the transposed bits into a single index*/
+  for ( (key = 0), (b = HILBERT_BITS-1) ; b >= 0 ; b -- )
+    for ( i = 0 ; i < 3 ; i ++ )
+      key = (key << 1) | ((x[i] >> b) & 1) ;
+
+  return key ;
+}
+
+static gint brio_compare(gconstpointer a, gconstpointer b)
+
+{
+  const brio_entry_t *e1 = a, *e2 = b ;
+
+  if ( e1->round < e2->round ) return -1 ;
+  if ( e1->round > e2->round ) return  1 ;
+  if ( e1->key < e2->key ) return -1 ;
+  if ( e1->key > e2->key ) return  1 ;
+
+  return 0 ;
+}
+
+brio_entry_t *brio_order(GPtrArray *vertices)
+
+/*
+  biased randomized insertion order (Amenta, N., Choi, S. and Rote,
+  G., `Incremental constructions con BRIO', SoCG 2003): each vertex
+  goes into the last round with probability 1/2, the one before with
+  probability 1/4 and so on, and each round is sorted along a Hilbert
+  curve
+*/
+
+{
+  brio_entry_t *e ;
+  gdouble xmin[3], xmax[3], scale ;
+  guint32 x[3] ;
+  GtsPoint *p ;
+  GRand *rand ;
+  gint i, j, nr ;
+
+  e = g_new(brio_entry_t, vertices->len) ;
+
+  xmin[0] = xmin[1] = xmin[2] =  G_MAXDOUBLE ;
+  xmax[0] = xmax[1] = xmax[2] = -G_MAXDOUBLE ;
+  for ( i = 0 ; i < vertices->len ; i ++ ) {
+    p = GTS_POINT(g_ptr_array_index(vertices, i)) ;
+    xmin[0] = MIN(xmin[0], p->x) ; xmax[0] = MAX(xmax[0], p->x) ;
+    xmin[1] = MIN(xmin[1], p->y) ; xmax[1] = MAX(xmax[1], p->y) ;
+    xmin[2] = MIN(xmin[2], p->z) ; xmax[2] = MAX(xmax[2], p->z) ;
+  }
+  scale = MAX(xmax[0]-xmin[0], MAX(xmax[1]-xmin[1], xmax[2]-xmin[2])) ;
+  if ( scale > 0.0 ) scale = ((1 << HILBERT_BITS) - 1)/scale ;
+
+  /*number of rounds, so that the first holds a handful of vertices*/
+  for ( (nr = 1), (j = vertices->len) ; j > 32 ; j >>= 1 ) nr ++ ;
+
+  /*fixed seed so that the tetrahedralization is reproducible*/
+  rand = g_rand_new_with_seed(0) ;
+  for ( i = 0 ; i < vertices->len ; i ++ ) {
+    p = GTS_POINT(g_ptr_array_index(vertices, i)) ;
+    e[i].p = GTS_VERTEX(p) ;
+    x[0] = (guint32)((p->x - xmin[0])*scale) ;
+    x[1] = (guint32)((p->y - xmin[1])*scale) ;
+    x[2] = (guint32)((p->z - xmin[2])*scale) ;
+    e[i].key = hilbert_key(x) ;
+    e[i].round = nr - 1 ;
+    while ( e[i].round > 0 && g_rand_boolean(rand) ) e[i].round -- ;
+  }
+  g_rand_free(rand) ;
+
+  qsort(e, vertices->len, sizeof(brio_entry_t), brio_compare) ;
+
+  return e ;
+}
+
+static GtvCell *vertex_cell(GtsVertex *p, GtvVolume *v)
+
+{
+  GtsEdge *e ;
+  GtvFacet *f ;
+
+  if ( (e = gtv_vertex_has_parent_volume(p, v)) == NULL ) return NULL ;
+  if ( (f = gtv_edge_has_parent_volume(e, v)) == NULL ) return NULL ;
+
+  return gtv_facet_has_parent_volume(f, v) ;
+}
+
+gint delaunay_insert_sorted(GtvVolume *v, brio_entry_t *e, gint i0, gint i1,
+			   gboolean cavity, GtvCell **guess)
+
+/*
+  serial insertion of vertices e[i0], ..., e[i1-1], starting the
+  location of each from a cell of the previous one, by the cavity
+  method if cavity is TRUE
+*/
+
+{
+  GtvCell *c ;
+  GtsVertex *p ;
+  gint i, status, ret ;
+
+  ret = GTV_SUCCESS ;
+  for ( i = i0 ; i < i1 ; i ++ ) {
+    p = e[i].p ;
+    c = gtv_point_locate(GTS_POINT(p), v, *guess) ;
+    if ( c == NULL ) {
+      g_message("%s: vertex (%lg,%lg,%lg) not inside convex hull",
+		__FUNCTION__,
+		GTS_POINT(p)->x, GTS_POINT(p)->y, GTS_POINT(p)->z) ;
+      ret = GTV_VERTEX_NOT_IN_VOLUME ;
+      continue ;
+    }
+    status = delaunay_insert_vertex(v, p, c, cavity) ;
+    if ( status == GTV_SUCCESS ) *guess = vertex_cell(p, v) ;
+  }
+
+  return ret ;
+}
+
+/**
+ * Add an array of ::GtsVertex to a ::GtvVolume, preserving the
+ * Delaunay property. The vertices are inserted in a biased randomized
+ * order, with each round sorted along a Hilbert curve, and the
+ * location of each vertex starts from a cell of the previously
+ * inserted vertex, so that the point location walks are short. Each
+ * vertex is inserted as in ::gtv_delaunay_add_vertex. The order of \a
+ * vertices is not changed.
+ *
+ * @param v a ::GtvVolume;
+ * @param vertices a GPtrArray of ::GtsVertex to be added to \a v.
+ *
+ * @return GTV_SUCCESS if all of \a vertices were inserted in \a v,
+ * GTV_VERTEX_NOT_IN_VOLUME if any vertex lay outside \a v (the others
+ * are still inserted).
+ */
+
+gint gtv_delaunay_add_vertices(GtvVolume *v, GPtrArray *vertices)
+
+{
+  brio_entry_t *e ;
+  GtvCell *guess ;
+  gint ret ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(vertices != NULL, GTV_NULL_ARGUMENT) ;
+
+  if ( vertices->len == 0 ) return GTV_SUCCESS ;
+
+  e = brio_order(vertices) ;
+
+  guess = NULL ;
+  ret = delaunay_insert_sorted(v, e, 0, vertices->len,
+			       gtv_delaunay_cavity_insertion, &guess) ;
+
+  g_free(e) ;
+
+  return ret ;
 }
 
 /** 
@@ -855,13 +1328,13 @@ static gboolean valid_2ear(GSList *star,
 
   /*for ear to be convex outwards, a and v must lie on the same side
     of bcd*/
-  g_assert(gts_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
+  g_assert(gtv_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
 				    GTS_POINT(d), GTS_POINT(v)) != 0.0) ;
-  g_assert(gts_point_orientation_3d(GTS_POINT(a), GTS_POINT(c),
+  g_assert(gtv_point_orientation_3d(GTS_POINT(a), GTS_POINT(c),
 				    GTS_POINT(d), GTS_POINT(v)) != 0.0) ;
-  o1 = gts_point_orientation_3d(GTS_POINT(b), GTS_POINT(c),
+  o1 = gtv_point_orientation_3d(GTS_POINT(b), GTS_POINT(c),
 				GTS_POINT(d), GTS_POINT(a)) ;
-  o2 = gts_point_orientation_3d(GTS_POINT(b), GTS_POINT(c),
+  o2 = gtv_point_orientation_3d(GTS_POINT(b), GTS_POINT(c),
 				GTS_POINT(d), GTS_POINT(v)) ;
   g_assert(o1 != 0.0 && o2 != 0.0) ;
   if ( ((o1 < 0.0) && (o2 > 0.0)) || ((o1 < 0.0) && (o2 > 0.0)) ) {
@@ -946,9 +1419,9 @@ static gboolean valid_3ear(GSList *star,
 
   /*for ear to be convex outwards, d and v must lie on opposite sides
     of abc*/
-  o1 = gts_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
+  o1 = gtv_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
 				GTS_POINT(c), GTS_POINT(d)) ;
-  o2 = gts_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
+  o2 = gtv_point_orientation_3d(GTS_POINT(a), GTS_POINT(b),
 				GTS_POINT(c), GTS_POINT(v)) ;
   g_assert(o1 != 0.0 && o2 != 0.0) ;
   if ( ((o1 < 0.0) && (o2 < 0.0)) || ((o1 > 0.0) && (o2 > 0.0)) ) {
@@ -1082,10 +1555,10 @@ gint gtv_delaunay_remove_vertex(GtvVolume *v, GtsVertex *p)
       cells = remove = NULL ;
       if ( tau3 == NULL )
 	flipcell23(tau1, tau2, f,
-		   cell_class, facet_class, edge_class, &cells, &remove) ;
+		   v, cell_class, facet_class, edge_class, &cells, &remove) ;
       else
 	flipcell32(tau1, tau2, tau3, f,
-		   cell_class, facet_class, edge_class, &cells, &remove) ;
+		   v, cell_class, facet_class, edge_class, &cells, &remove) ;
       for ( i = remove ; i != NULL ; i = i->next  ) {
 	gtv_volume_remove_cell(v, GTV_CELL(i->data)) ;
 	star = g_slist_remove(star, i->data) ;
@@ -1109,7 +1582,7 @@ gint gtv_delaunay_remove_vertex(GtvVolume *v, GtsVertex *p)
     cells = remove = NULL ;
     flipcell41(star->data, star->next->data, star->next->next->data, 
 	       star->next->next->next->data, p,
-	       cell_class, facet_class, edge_class, &cells, &remove) ;
+	       v, cell_class, facet_class, edge_class, &cells, &remove) ;
 
     for ( i = remove ; i != NULL ; i = i->next  )
       gtv_volume_remove_cell(v, GTV_CELL(i->data)) ;
@@ -36,6 +36,19 @@ gboolean gtv_allow_floating_facets = FALSE ;
  * 
  */
 
+static void triangle_disconnect(GtsTriangle *t, GtsEdge *e)
+
+/*detach t from e as the GtsTriangle destroy method does*/
+
+{
+  e->triangles = g_slist_remove(e->triangles, t) ;
+  if ( !GTS_OBJECT_DESTROYED(e) &&
+       !gts_allow_floating_edges && e->triangles == NULL )
+    gts_object_destroy(GTS_OBJECT(e)) ;
+
+  return ;
+}
+
 static void facet_destroy (GtsObject * object)
 {
   GtvFacet *f = GTV_FACET(object) ;
@@ -49,6 +62,16 @@ static void facet_destroy (GtsObject * object)
   }
   g_assert (f->tetrahedra == NULL) ;
 
+  /*a pool facet is detached from its edges here, since the GtsTriangle
+    destroy method would free it, and goes back to its pool*/
+  if ( f->pool != NULL ) {
+    triangle_disconnect(GTS_TRIANGLE(f), GTS_TRIANGLE(f)->e1) ;
+    triangle_disconnect(GTS_TRIANGLE(f), GTS_TRIANGLE(f)->e2) ;
+    triangle_disconnect(GTS_TRIANGLE(f), GTS_TRIANGLE(f)->e3) ;
+    object_pool_release(f->pool, object) ;
+    return ;
+  }
+
   /* do not forget to call destroy method of the parent */
   (* GTS_OBJECT_CLASS (gtv_facet_class ())->parent_class->destroy) 
     (object);
@@ -114,6 +137,23 @@ GtvFacet * gtv_facet_new (GtvFacetClass * klass,
   return object;
 }
 
+GtvFacet *volume_facet_new(GtvVolume *v, GtvFacetClass *klass,
+			   GtsEdge *e1, GtsEdge *e2, GtsEdge *e3)
+
+{
+  GtvFacet *f ;
+
+  if ( v == NULL ||
+       (f = GTV_FACET(object_pool_alloc(v->facet_pool,
+					GTS_OBJECT_CLASS(klass)))) == NULL )
+    return gtv_facet_new(klass, e1, e2, e3) ;
+
+  f->pool = v->facet_pool ;
+  gts_triangle_set(GTS_TRIANGLE(f), e1, e2, e3) ;
+
+  return f ;
+}
+
 /** 
  * Check if a ::GtvFacet lies on the boundary of a ::GtvVolume.
  * 
@@ -194,6 +234,7 @@ gint gtv_facet_replace(GtvFacet *f, GtvFacet *with)
     if ( t->f2 == f ) t->f2 = with ;
     if ( t->f3 == f ) t->f3 = with ;
     if ( t->f4 == f ) t->f4 = with ;
+    tetrahedron_vertices_cache(t) ;
     if (!g_slist_find (with->tetrahedra, t))
       with->tetrahedra = g_slist_prepend (with->tetrahedra, t);  
     i = i->next ;
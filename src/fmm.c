@@ -0,0 +1,1077 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @defgroup fmm Fast multipole evaluation of volume potentials
+ *
+ * A ::GtvFMM evaluates the volume potential
+ * \f[
+ * \phi(\mathbf{x}) = \int_{V}\frac{\sigma(\mathbf{y})}
+ * {|\mathbf{x}-\mathbf{y}|}\,\mathrm{d}V(\mathbf{y})
+ * \f]
+ * and its gradient, over the cells of a ::GtvOctTree, with a density
+ * \f$\sigma\f$ which is constant on each cell. Each box of the tree
+ * holds, in its \a Imnk array, the Cartesian moments
+ * \f[
+ * I_{mnk} = \int_{B}\sigma(\mathbf{y})
+ * (y_{1}-x_{c1})^{m}(y_{2}-x_{c2})^{n}(y_{3}-x_{c3})^{k}
+ * \,\mathrm{d}V(\mathbf{y}),\quad m+n+k\leq p
+ * \f]
+ * of its cells about its centre \a xc, indexed with ::gtv_fmm_index.
+ * The moments of leaves are found by quadrature over their cells and
+ * those of other boxes are shifted up from their children.
+ *
+ * The potential at a point is found by descending the tree from the
+ * root. A box of radius \f$R\f$ (the largest distance from \a xc to
+ * a corner of its bounding box) at distance \f$r\f$ from the point is
+ * in the far field if \f$R<\theta r\f$, and its contribution is
+ * found from its moments and the Taylor coefficients of
+ * \f$1/|\mathbf{x}-\mathbf{y}|\f$, computed by recursion. Otherwise
+ * the box is opened, and leaves in the near field are handed to a
+ * ::GtvFMMNearFunc, which is given the list of cells in the box and
+ * their densities. The default near-field function evaluates the
+ * integrals over the cells exactly (see ::gtv_tetrahedron_potential);
+ * ::gtv_fmm_near_field_quadrature, which uses the quadrature rule of
+ * the moment calculation, is a cheaper alternative for points which
+ * are not close to any cell.
+ *
+ * Many points can be evaluated at once with ::gtv_fmm_evaluate_points,
+ * which hands each near-field leaf, once, to a ::GtvFMMNearBatchFunc
+ * with all of the points in its near field, so that near-field
+ * kernels can work on a block of cells and a block of points at a
+ * time, and which spreads the work over several threads.
+ *
+ * @{
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <gts.h>
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+const gdouble GTV_BINOMIALS[] = {
+  1.0,
+  1.0, 1.0,
+  1.0, 2.0, 1.0,
+  1.0, 3.0, 3.0, 1.0,
+  1.0, 4.0, 6.0, 4.0, 1.0,
+  1.0, 5.0, 10.0, 10.0, 5.0, 1.0,
+  1.0, 6.0, 15.0, 20.0, 15.0, 6.0, 1.0,
+  1.0, 7.0, 21.0, 35.0, 35.0, 21.0, 7.0, 1.0,
+  1.0, 8.0, 28.0, 56.0, 70.0, 56.0, 28.0, 8.0, 1.0,
+  1.0, 9.0, 36.0, 84.0, 126.0, 126.0, 84.0, 36.0, 9.0, 1.0,
+  1.0, 10.0, 45.0, 120.0, 210.0, 252.0, 210.0, 120.0, 45.0, 10.0, 1.0,
+  1.0, 11.0, 55.0, 165.0, 330.0, 462.0, 462.0, 330.0, 165.0, 55.0, 11.0, 1.0,
+  1.0, 12.0, 66.0, 220.0, 495.0, 792.0, 924.0, 792.0, 495.0, 220.0, 66.0, 12.0, 1.0,
+  1.0, 13.0, 78.0, 286.0, 715.0, 1287.0, 1716.0, 1716.0, 1287.0, 715.0, 286.0, 78.0, 13.0, 1.0,
+  1.0, 14.0, 91.0, 364.0, 1001.0, 2002.0, 3003.0, 3432.0, 3003.0, 2002.0, 1001.0, 364.0, 91.0, 14.0, 1.0,
+  1.0, 15.0, 105.0, 455.0, 1365.0, 3003.0, 5005.0, 6435.0, 6435.0, 5005.0, 3003.0, 1365.0, 455.0, 105.0, 15.0, 1.0,
+  1.0, 16.0, 120.0, 560.0, 1820.0, 4368.0, 8008.0, 11440.0, 12870.0, 11440.0, 8008.0, 4368.0, 1820.0, 560.0, 120.0, 16.0, 1.0
+} ;
+
+const gdouble GTV_FACTORIALS[] = {
+  1.0,
+  1.0,
+  2.0,
+  6.0,
+  24.0,
+  120.0,
+  720.0,
+  5040.0,
+  40320.0,
+  362880.0,
+  3628800.0,
+  39916800.0,
+  479001600.0,
+  6227020800.0,
+  87178291200.0,
+  1307674368000.0,
+  20922789888000.0
+} ;
+
+static void gauss_legendre(gint n, gdouble *x, gdouble *w)
+
+/*n point Gauss-Legendre rule on [0,1]*/
+
+{
+  gdouble z, z1, p1, p2, p3, pp ;
+  gint i, j ;
+
+  for ( i = 0 ; i < (n+1)/2 ; i ++ ) {
+    z = cos(M_PI*(i+0.75)/(n+0.5)) ;
+    do {
+      p1 = 1.0 ; p2 = 0.0 ;
+      for ( j = 0 ; j < n ; j ++ ) {
+	p3 = p2 ; p2 = p1 ;
+	p1 = ((2.0*j+1.0)*z*p2 - j*p3)/(j+1) ;
+      }
+      pp = n*(z*p1 - p2)/(z*z - 1.0) ;
+      z1 = z ; z = z1 - p1/pp ;
+    } while ( fabs(z - z1) > 1e-15 ) ;
+    x[i] = 0.5*(1.0 - z) ; x[n-1-i] = 0.5*(1.0 + z) ;
+    w[i] = w[n-1-i] = 1.0/((1.0 - z*z)*pp*pp) ;
+  }
+
+  return ;
+}
+
+static void fmm_rule_init(GtvFMM *f)
+
+/*
+  conical product rule on the reference tetrahedron, from the Duffy
+  map of the unit cube, exact for polynomials of degree 2*nq-3
+*/
+
+{
+  gdouble *x, *w, u, v, *r ;
+  gint i, j, k ;
+
+  x = g_new(gdouble, 2*f->nq) ; w = &(x[f->nq]) ;
+  gauss_legendre(f->nq, x, w) ;
+
+  f->nr = f->nq*f->nq*f->nq ;
+  r = f->rule = g_new(gdouble, 4*f->nr) ;
+  for ( i = 0 ; i < f->nq ; i ++ ) {
+    u = x[i] ;
+    for ( j = 0 ; j < f->nq ; j ++ ) {
+      v = x[j] ;
+      for ( k = 0 ; k < f->nq ; k ++ ) {
+	r[0] = u ;
+	r[1] = (1.0 - u)*v ;
+	r[2] = (1.0 - u)*(1.0 - v)*x[k] ;
+	r[3] = w[i]*w[j]*w[k]*(1.0 - u)*(1.0 - u)*(1.0 - v) ;
+	r += 4 ;
+      }
+    }
+  }
+
+  g_free(x) ;
+
+  return ;
+}
+
+static void cell_frame(GtvCell *c, gdouble *x0, gdouble *J)
+
+/*vertex and edge vectors of a cell, returning |det J|*/
+
+{
+  GtsVertex *v[4] ;
+  gint i ;
+
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c),
+			   &(v[0]), &(v[1]), &(v[2]), &(v[3])) ;
+  x0[0] = GTS_POINT(v[0])->x ;
+  x0[1] = GTS_POINT(v[0])->y ;
+  x0[2] = GTS_POINT(v[0])->z ;
+  for ( i = 0 ; i < 3 ; i ++ ) {
+    J[3*i+0] = GTS_POINT(v[i+1])->x - x0[0] ;
+    J[3*i+1] = GTS_POINT(v[i+1])->y - x0[1] ;
+    J[3*i+2] = GTS_POINT(v[i+1])->z - x0[2] ;
+  }
+
+  J[9] = fabs(J[0]*(J[4]*J[8] - J[5]*J[7]) -
+	      J[1]*(J[3]*J[8] - J[5]*J[6]) +
+	      J[2]*(J[3]*J[7] - J[4]*J[6])) ;
+
+  return ;
+}
+
+#define rule_point(_y,_x0,_J,_r)					\
+  ((_y)[0] = (_x0)[0] + (_r)[0]*(_J)[0] + (_r)[1]*(_J)[3] + (_r)[2]*(_J)[6], \
+   (_y)[1] = (_x0)[1] + (_r)[0]*(_J)[1] + (_r)[1]*(_J)[4] + (_r)[2]*(_J)[7], \
+   (_y)[2] = (_x0)[2] + (_r)[0]*(_J)[2] + (_r)[1]*(_J)[5] + (_r)[2]*(_J)[8])
+
+static void monomials(gdouble *x, gint p, gdouble *P)
+
+/*x^m y^n z^k for m+n+k <= p, in the order of gtv_fmm_index*/
+
+{
+  gint s, j, m, n, k, i ;
+
+  P[0] = 1.0 ; i = 1 ;
+  for ( s = 1 ; s <= p ; s ++ ) {
+    for ( j = 0 ; j <= s ; j ++ ) {
+      for ( k = 0 ; k <= j ; k ++ ) {
+	n = j - k ; m = s - j ;
+	if ( m > 0 ) 
+	  P[i] = P[gtv_fmm_index(m-1,n,k)]*x[0] ;
+	else if ( n > 0 ) 
+	  P[i] = P[gtv_fmm_index(m,n-1,k)]*x[1] ;
+	else
+	  P[i] = P[gtv_fmm_index(m,n,k-1)]*x[2] ;
+	i ++ ;
+      }
+    }
+  }
+
+  return ;
+}
+
+static void taylor_coefficients(gdouble *d, gint p, gdouble *a)
+
+/*
+  Taylor coefficients a_{mnk} = D_{y}^{mnk}(1/|x-y|)/(m!n!k!) at
+  x-y = d for m+n+k <= p, by the recursion of Lindsay and Krasny
+*/
+
+{
+  gdouble r2, s1, s2 ;
+  gint s, j, m, n, k, i ;
+
+  r2 = d[0]*d[0] + d[1]*d[1] + d[2]*d[2] ;
+  a[0] = 1.0/sqrt(r2) ; i = 1 ;
+  for ( s = 1 ; s <= p ; s ++ ) {
+    for ( j = 0 ; j <= s ; j ++ ) {
+      for ( k = 0 ; k <= j ; k ++ ) {
+	n = j - k ; m = s - j ;
+	s1 = s2 = 0.0 ;
+	if ( m > 0 ) s1 += d[0]*a[gtv_fmm_index(m-1,n,k)] ;
+	if ( n > 0 ) s1 += d[1]*a[gtv_fmm_index(m,n-1,k)] ;
+	if ( k > 0 ) s1 += d[2]*a[gtv_fmm_index(m,n,k-1)] ;
+	if ( m > 1 ) s2 += a[gtv_fmm_index(m-2,n,k)] ;
+	if ( n > 1 ) s2 += a[gtv_fmm_index(m,n-2,k)] ;
+	if ( k > 1 ) s2 += a[gtv_fmm_index(m,n,k-2)] ;
+	a[i] = ((2*s-1)*s1 - (s-1)*s2)/(s*r2) ;
+	i ++ ;
+      }
+    }
+  }
+
+  return ;
+}
+
+static void fmm_leaf_moments(GtvFMM *f, GtvOctTreeBox *b)
+
+{
+  GtvOctTree *t = f->tree ;
+  gdouble x0[3], J[10], y[3], P[GTV_FMM_COEFFICIENT_NUMBER_MAX], *I, *r, w ;
+  guint i ;
+  gint j, k ;
+
+  I = (gdouble *)(b->Imnk->data) ;
+  for ( i = b->first ; i < b->first + b->n ; i ++ ) {
+    if ( f->sigma[i] == 0.0 ) continue ;
+    cell_frame(t->cells[i], x0, J) ;
+    for ( j = 0 ; j < f->nr ; j ++ ) {
+      r = &(f->rule[4*j]) ;
+      rule_point(y, x0, J, r) ;
+      y[0] -= b->xc->x ; y[1] -= b->xc->y ; y[2] -= b->xc->z ;
+      w = f->sigma[i]*r[3]*J[9] ;
+      monomials(y, f->order, P) ;
+      for ( k = 0 ; k < b->stride ; k ++ ) I[k] += w*P[k] ;
+    }
+  }
+
+  return ;
+}
+
+static void fmm_shift_moments(GtvFMM *f, GtvOctTreeBox *c,
+			      GtvOctTreeBox *b)
+
+/*add the moments of box c, shifted to the centre of b, to those of b*/
+
+{
+  gdouble d[3], Dx[GTV_FMM_ORDER_MAX+1], Dy[GTV_FMM_ORDER_MAX+1],
+    Dz[GTV_FMM_ORDER_MAX+1], *Ic, *Ib, s ;
+  gint m, n, k, i, j, l, p = f->order ;
+
+  d[0] = c->xc->x - b->xc->x ;
+  d[1] = c->xc->y - b->xc->y ;
+  d[2] = c->xc->z - b->xc->z ;
+  Dx[0] = Dy[0] = Dz[0] = 1.0 ;
+  for ( i = 1 ; i <= p ; i ++ ) {
+    Dx[i] = Dx[i-1]*d[0] ; Dy[i] = Dy[i-1]*d[1] ; Dz[i] = Dz[i-1]*d[2] ;
+  }
+
+  Ic = (gdouble *)(c->Imnk->data) ; Ib = (gdouble *)(b->Imnk->data) ;
+  for ( m = 0 ; m <= p ; m ++ ) {
+    for ( n = 0 ; m + n <= p ; n ++ ) {
+      for ( k = 0 ; m + n + k <= p ; k ++ ) {
+	s = 0.0 ;
+	for ( i = 0 ; i <= m ; i ++ )
+	  for ( j = 0 ; j <= n ; j ++ )
+	    for ( l = 0 ; l <= k ; l ++ )
+	      s += gtv_binomial(m,i)*gtv_binomial(n,j)*gtv_binomial(k,l)*
+		Dx[m-i]*Dy[n-j]*Dz[k-l]*Ic[gtv_fmm_index(i,j,l)] ;
+	Ib[gtv_fmm_index(m,n,k)] += s ;
+      }
+    }
+  }
+
+  return ;
+}
+
+static gdouble box_radius(GtvOctTreeBox *b)
+
+/*distance from the centre of a box to the furthest corner of its
+  bounding box*/
+
+{
+  GtsBBox *bb = GTS_BBOX(b) ;
+  gdouble dx, dy, dz ;
+
+  dx = MAX(fabs(bb->x1 - b->xc->x), fabs(bb->x2 - b->xc->x)) ;
+  dy = MAX(fabs(bb->y1 - b->xc->y), fabs(bb->y2 - b->xc->y)) ;
+  dz = MAX(fabs(bb->z1 - b->xc->z), fabs(bb->z2 - b->xc->z)) ;
+
+  return sqrt(dx*dx + dy*dy + dz*dz) ;
+}
+
+/**
+ * Near-field function for a ::GtvFMM which evaluates the
+ * potential and gradient of a list of cells by the quadrature rule of
+ * the ::GtvFMM. The rule is not adapted to the singularity of the
+ * kernel, so the result is only approximate for points inside or close
+ * to a cell, and no quadrature point may coincide with \a x.
+ *
+ * @param cells the ::GtvCell's of an octree box;
+ * @param sigma density on each of \a cells;
+ * @param n number of cells;
+ * @param x evaluation point;
+ * @param phi potential, to which the contribution of \a cells is added;
+ * @param grad gradient of potential, to which the contribution of \a
+ * cells is added, if it is not NULL;
+ * @param data the ::GtvFMM.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_near_field_quadrature(GtvCell **cells, gdouble *sigma, guint n,
+				   GtsPoint *x, gdouble *phi, gdouble *grad,
+				   gpointer data)
+
+{
+  GtvFMM *f = (GtvFMM *)data ;
+  gdouble x0[3], J[10], y[3], *r, w, R ;
+  guint i ;
+  gint j ;
+
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  for ( i = 0 ; i < n ; i ++ ) {
+    if ( sigma[i] == 0.0 ) continue ;
+    cell_frame(cells[i], x0, J) ;
+    for ( j = 0 ; j < f->nr ; j ++ ) {
+      r = &(f->rule[4*j]) ;
+      rule_point(y, x0, J, r) ;
+      y[0] = x->x - y[0] ; y[1] = x->y - y[1] ; y[2] = x->z - y[2] ;
+      R = sqrt(y[0]*y[0] + y[1]*y[1] + y[2]*y[2]) ;
+      w = sigma[i]*r[3]*J[9]/R ;
+      *phi += w ;
+      if ( grad == NULL ) continue ;
+      w /= R*R ;
+      grad[0] -= w*y[0] ; grad[1] -= w*y[1] ; grad[2] -= w*y[2] ;
+    }
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Default near-field function for a ::GtvFMM, which evaluates the
+ * potential and gradient of a list of cells in closed form, using
+ * ::gtv_tetrahedron_potential, so that it is exact for points inside
+ * or close to the cells.
+ *
+ * @param cells the ::GtvCell's of an octree box;
+ * @param sigma density on each of \a cells;
+ * @param n number of cells;
+ * @param x evaluation point;
+ * @param phi potential, to which the contribution of \a cells is added;
+ * @param grad gradient of potential, to which the contribution of \a
+ * cells is added, if it is not NULL;
+ * @param data not used.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_near_field_analytic(GtvCell **cells, gdouble *sigma, guint n,
+				 GtsPoint *x, gdouble *phi, gdouble *grad,
+				 gpointer data)
+
+{
+  gdouble p, g[3] ;
+  guint i ;
+
+  for ( i = 0 ; i < n ; i ++ ) {
+    if ( sigma[i] == 0.0 ) continue ;
+    gtv_tetrahedron_potential(GTV_TETRAHEDRON(cells[i]), x, &p,
+			      (grad == NULL ? NULL : g)) ;
+    *phi += sigma[i]*p ;
+    if ( grad == NULL ) continue ;
+    grad[0] += sigma[i]*g[0] ;
+    grad[1] += sigma[i]*g[1] ;
+    grad[2] += sigma[i]*g[2] ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Set up a ::GtvFMM on an octree. The density is zero until it is set
+ * with ::gtv_fmm_set_density.
+ *
+ * @param t a ::GtvOctTree;
+ * @param order order of the multipole expansions (at most
+ * ::GTV_FMM_ORDER_MAX);
+ * @param theta opening parameter: a box is in the far field of a
+ * point if its radius is less than \a theta times its distance from
+ * the point.
+ *
+ * @return a new ::GtvFMM, or NULL on error.
+ */
+
+GtvFMM *gtv_fmm_new(GtvOctTree *t, gint order, gdouble theta)
+
+{
+  GtvFMM *f ;
+
+  g_return_val_if_fail(t != NULL, NULL) ;
+  g_return_val_if_fail(order >= 0 && order <= GTV_FMM_ORDER_MAX, NULL) ;
+  g_return_val_if_fail(theta > 0.0 && theta < 1.0, NULL) ;
+
+  f = g_new0(GtvFMM, 1) ;
+  f->tree = t ; f->order = order ; f->theta = theta ;
+  f->sigma = g_new0(gdouble, t->ncells) ;
+  /*exact for the monomials of the moments, and at least four points*/
+  f->nq = MAX(4, (order+4)/2) ;
+  fmm_rule_init(f) ;
+  f->near = gtv_fmm_near_field_analytic ; f->near_data = NULL ;
+  f->near_batch = gtv_fmm_near_field_analytic_batch ;
+  f->near_batch_data = NULL ;
+
+  return f ;
+}
+
+/**
+ * Free a ::GtvFMM and the expansion data it has placed on the boxes
+ * of its octree. The octree itself is not freed.
+ *
+ * @param f a ::GtvFMM.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_free(GtvFMM *f)
+
+{
+  GtvOctTreeBox *b ;
+  gint i ;
+
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  for ( i = 0 ; i < f->tree->nboxes ; i ++ ) {
+    b = gtv_oct_tree_box(f->tree, i) ;
+    if ( b->Imnk != NULL ) g_array_free(b->Imnk, TRUE) ;
+    b->Imnk = NULL ; b->order = b->stride = 0 ;
+  }
+
+  g_free(f->sigma) ; g_free(f->rule) ;
+  g_free(f) ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Set the near-field function of a ::GtvFMM, which is called for each
+ * leaf of the octree which is too close to an evaluation point to use
+ * its multipole expansion.
+ *
+ * @param f a ::GtvFMM;
+ * @param func a ::GtvFMMNearFunc, or NULL to restore the default
+ * ::gtv_fmm_near_field_analytic;
+ * @param data user data passed to \a func.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_set_near_field(GtvFMM *f, GtvFMMNearFunc func, gpointer data)
+
+{
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  if ( func == NULL ) {
+    f->near = gtv_fmm_near_field_analytic ; f->near_data = NULL ;
+    return GTV_SUCCESS ;
+  }
+
+  f->near = func ; f->near_data = data ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Set the density on the cells of a ::GtvFMM and compute the multipole
+ * moments of the boxes of its octree.
+ *
+ * @param f a ::GtvFMM;
+ * @param func a ::GtvFMMDensityFunc, called once for each cell;
+ * @param data user data passed to \a func.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_set_density(GtvFMM *f, GtvFMMDensityFunc func, gpointer data)
+
+{
+  GtvOctTree *t ;
+  GtvOctTreeBox *b ;
+  guint i ;
+  gint j, k ;
+
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(func != NULL, GTV_NULL_ARGUMENT) ;
+
+  t = f->tree ;
+  for ( i = 0 ; i < t->ncells ; i ++ )
+    f->sigma[i] = func(t->cells[i], data) ;
+
+  /*children follow their parents, so a reverse sweep finds the
+    moments of all children before those of their parent*/
+  for ( j = t->nboxes - 1 ; j >= 0 ; j -- ) {
+    b = gtv_oct_tree_box(t, j) ;
+    if ( b->Imnk != NULL ) g_array_free(b->Imnk, TRUE) ;
+    b->Imnk = NULL ; b->order = b->stride = 0 ;
+    if ( b->n == 0 ) continue ;
+    b->order = f->order ;
+    b->stride = gtv_fmm_coefficient_number(f->order) ;
+    b->Imnk = g_array_sized_new(FALSE, TRUE, sizeof(gdouble), b->stride) ;
+    g_array_set_size(b->Imnk, b->stride) ;
+    if ( gtv_oct_tree_box_is_leaf(b) ) {
+      fmm_leaf_moments(f, b) ;
+      continue ;
+    }
+    for ( k = 0 ; k < 8 ; k ++ ) {
+      if ( gtv_oct_tree_box(t, b->child+k)->n == 0 ) continue ;
+      fmm_shift_moments(f, gtv_oct_tree_box(t, b->child+k), b) ;
+    }
+  }
+
+  return GTV_SUCCESS ;
+}
+
+static void fmm_traverse(GtvFMM *f, gdouble *x, gdouble *phi, gdouble *grad,
+			 GArray *near)
+
+/*
+  add the far-field potential (and gradient) at x to phi (and grad),
+  and append the indices of the leaves in its near field to near
+*/
+
+{
+  GtvOctTree *t = f->tree ;
+  GtvOctTreeBox *b ;
+  gdouble d[3], r, a[GTV_FMM_COEFFICIENT_NUMBER_MAX+
+		     (GTV_FMM_ORDER_MAX+2)*(GTV_FMM_ORDER_MAX+3)/2], *I ;
+  gint stack[8*(OCT_TREE_DEPTH_MAX+1)], n, i, j, s, m, nn, k, p, bi ;
+
+  p = f->order ;
+  stack[0] = 0 ; n = 1 ;
+  while ( n > 0 ) {
+    bi = stack[--n] ;
+    b = gtv_oct_tree_box(t, bi) ;
+    if ( b->n == 0 ) continue ;
+    d[0] = x[0] - b->xc->x ; d[1] = x[1] - b->xc->y ; d[2] = x[2] - b->xc->z ;
+    r = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]) ;
+    if ( box_radius(b) < f->theta*r ) {
+      /*far field: the gradient needs coefficients of one order higher*/
+      taylor_coefficients(d, (grad == NULL ? p : p+1), a) ;
+      I = (gdouble *)(b->Imnk->data) ;
+      for ( i = 0 ; i < b->stride ; i ++ ) *phi += a[i]*I[i] ;
+      if ( grad == NULL ) continue ;
+      i = 0 ;
+      for ( s = 0 ; s <= p ; s ++ ) {
+	for ( j = 0 ; j <= s ; j ++ ) {
+	  for ( k = 0 ; k <= j ; k ++ ) {
+	    nn = j - k ; m = s - j ;
+	    grad[0] -= (m+1)*a[gtv_fmm_index(m+1,nn,k)]*I[i] ;
+	    grad[1] -= (nn+1)*a[gtv_fmm_index(m,nn+1,k)]*I[i] ;
+	    grad[2] -= (k+1)*a[gtv_fmm_index(m,nn,k+1)]*I[i] ;
+	    i ++ ;
+	  }
+	}
+      }
+      continue ;
+    }
+    if ( !gtv_oct_tree_box_is_leaf(b) ) {
+      for ( i = 0 ; i < 8 ; i ++ ) stack[n++] = b->child + i ;
+      continue ;
+    }
+    g_array_append_val(near, bi) ;
+  }
+
+  return ;
+}
+
+/**
+ * Evaluate the potential of a ::GtvFMM, and optionally its gradient,
+ * at a point.
+ *
+ * @param f a ::GtvFMM whose density has been set;
+ * @param x evaluation point;
+ * @param phi on exit, the potential at \a x;
+ * @param grad if not NULL, on exit the gradient of the potential at \a
+ * x.
+ *
+ * @return GTV_SUCCESS on success, or the error code returned by the
+ * near-field function.
+ */
+
+gint gtv_fmm_evaluate(GtvFMM *f, GtsPoint *x, gdouble *phi, gdouble *grad)
+
+{
+  GtvOctTree *t ;
+  GtvOctTreeBox *b ;
+  GArray *near ;
+  gdouble y[3] ;
+  gint i, status ;
+
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(x != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(phi != NULL, GTV_NULL_ARGUMENT) ;
+
+  t = f->tree ;
+  *phi = 0.0 ;
+  if ( grad != NULL ) grad[0] = grad[1] = grad[2] = 0.0 ;
+  if ( t->nboxes == 0 ) return GTV_SUCCESS ;
+
+  near = g_array_new(FALSE, FALSE, sizeof(gint)) ;
+  y[0] = x->x ; y[1] = x->y ; y[2] = x->z ;
+  fmm_traverse(f, y, phi, grad, near) ;
+
+  status = GTV_SUCCESS ;
+  for ( i = 0 ; i < near->len && status == GTV_SUCCESS ; i ++ ) {
+    b = gtv_oct_tree_box(t, g_array_index(near, gint, i)) ;
+    status = f->near(&(t->cells[b->first]), &(f->sigma[b->first]), b->n,
+		     x, phi, grad, f->near_data) ;
+  }
+
+  g_array_free(near, TRUE) ;
+
+  return status ;
+}
+
+/**
+ * Batched near-field function for a ::GtvFMM which evaluates
+ * the potential and gradient of a list of cells at a batch of points
+ * by the quadrature rule of the ::GtvFMM, with the loop over points
+ * innermost. The same caveats apply as for
+ * ::gtv_fmm_near_field_quadrature.
+ *
+ * @param cells the ::GtvCell's of an octree leaf;
+ * @param sigma density on each of \a cells;
+ * @param n number of cells;
+ * @param x evaluation points, three coordinates per point;
+ * @param nx number of points;
+ * @param phi potential at each point, to which the contribution of \a
+ * cells is added;
+ * @param grad gradient of potential, three components per point, to
+ * which the contribution of \a cells is added, if it is not NULL;
+ * @param data the ::GtvFMM.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_near_field_quadrature_batch(GtvCell **cells, gdouble *sigma,
+					 guint n, gdouble *x, gint nx,
+					 gdouble *phi, gdouble *grad,
+					 gpointer data)
+
+{
+  GtvFMM *f = (GtvFMM *)data ;
+  gdouble x0[3], J[10], y[3], *r, w, R, d[3], g ;
+  guint i ;
+  gint j, k ;
+
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  for ( i = 0 ; i < n ; i ++ ) {
+    if ( sigma[i] == 0.0 ) continue ;
+    cell_frame(cells[i], x0, J) ;
+    for ( j = 0 ; j < f->nr ; j ++ ) {
+      r = &(f->rule[4*j]) ;
+      rule_point(y, x0, J, r) ;
+      w = sigma[i]*r[3]*J[9] ;
+      if ( grad == NULL ) {
+	for ( k = 0 ; k < nx ; k ++ ) {
+	  d[0] = x[3*k+0] - y[0] ;
+	  d[1] = x[3*k+1] - y[1] ;
+	  d[2] = x[3*k+2] - y[2] ;
+	  phi[k] += w/sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]) ;
+	}
+	continue ;
+      }
+      for ( k = 0 ; k < nx ; k ++ ) {
+	d[0] = x[3*k+0] - y[0] ;
+	d[1] = x[3*k+1] - y[1] ;
+	d[2] = x[3*k+2] - y[2] ;
+	R = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]) ;
+	phi[k] += w/R ;
+	g = w/R/R/R ;
+	grad[3*k+0] -= g*d[0] ;
+	grad[3*k+1] -= g*d[1] ;
+	grad[3*k+2] -= g*d[2] ;
+      }
+    }
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Default batched near-field function for a ::GtvFMM, which packs the
+ * vertices of a list of cells and evaluates their potential and
+ * gradient at a batch of points in closed form with
+ * ::gtv_tetrahedra_potentials.
+ *
+ * @param cells the ::GtvCell's of an octree leaf;
+ * @param sigma density on each of \a cells;
+ * @param n number of cells;
+ * @param x evaluation points, three coordinates per point;
+ * @param nx number of points;
+ * @param phi potential at each point, to which the contribution of \a
+ * cells is added;
+ * @param grad gradient of potential, three components per point, to
+ * which the contribution of \a cells is added, if it is not NULL;
+ * @param data not used.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_near_field_analytic_batch(GtvCell **cells, gdouble *sigma,
+				       guint n, gdouble *x, gint nx,
+				       gdouble *phi, gdouble *grad,
+				       gpointer data)
+
+{
+  GtsVertex *v[4] ;
+  gdouble *y ;
+  guint i ;
+  gint j, status ;
+
+  y = g_new(gdouble, 12*n) ;
+  for ( i = 0 ; i < n ; i ++ ) {
+    gtv_tetrahedron_vertices(GTV_TETRAHEDRON(cells[i]),
+			     &(v[0]), &(v[1]), &(v[2]), &(v[3])) ;
+    for ( j = 0 ; j < 4 ; j ++ ) {
+      y[12*i+3*j+0] = GTS_POINT(v[j])->x ;
+      y[12*i+3*j+1] = GTS_POINT(v[j])->y ;
+      y[12*i+3*j+2] = GTS_POINT(v[j])->z ;
+    }
+  }
+
+  status = gtv_tetrahedra_potentials(y, sigma, 1, n, x, nx, phi, grad) ;
+
+  g_free(y) ;
+
+  return status ;
+}
+
+/**
+ * Set the batched near-field function of a ::GtvFMM, used by
+ * ::gtv_fmm_evaluate_points, which is called once for each leaf of the
+ * octree with all of the evaluation points in its near field. If the
+ * evaluation uses more than one thread, \a func must be safe to call
+ * from several threads at once.
+ *
+ * @param f a ::GtvFMM;
+ * @param func a ::GtvFMMNearBatchFunc, or NULL to restore the default
+ * ::gtv_fmm_near_field_analytic_batch;
+ * @param data user data passed to \a func.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_fmm_set_near_field_batch(GtvFMM *f, GtvFMMNearBatchFunc func,
+				  gpointer data)
+
+{
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  if ( func == NULL ) {
+    f->near_batch = gtv_fmm_near_field_analytic_batch ;
+    f->near_batch_data = NULL ;
+    return GTV_SUCCESS ;
+  }
+
+  f->near_batch = func ; f->near_batch_data = data ;
+
+  return GTV_SUCCESS ;
+}
+
+/*a leaf in the near field of a target point*/
+typedef struct {
+  gint box ;
+  gint target ;
+} fmm_pair_t ;
+
+typedef struct {
+  GtvFMM *f ;
+  gdouble *x, *phi, *grad ;
+  gint xstr, i0, i1 ;
+  /*near-field pairs of the thread's targets, in target order*/
+  GArray *pairs ;
+  /*all pairs, their order sorted by leaf, the first sorted pair of
+    each leaf, and results for each pair*/
+  fmm_pair_t *all ;
+  gint *order, *first, *leaves, nleaves, *next ;
+  gdouble *res ;
+  gint ret ;
+} fmm_batch_t ;
+
+static gpointer fmm_far_field_thread(fmm_batch_t *d)
+
+/*far field and near-field pairs of targets i0 to i1-1*/
+
+{
+  GArray *near ;
+  fmm_pair_t pair ;
+  gint i, j ;
+
+  near = g_array_new(FALSE, FALSE, sizeof(gint)) ;
+  for ( i = d->i0 ; i < d->i1 ; i ++ ) {
+    g_array_set_size(near, 0) ;
+    fmm_traverse(d->f, &(d->x[i*d->xstr]), &(d->phi[i]),
+		 (d->grad == NULL ? NULL : &(d->grad[3*i])), near) ;
+    pair.target = i ;
+    for ( j = 0 ; j < near->len ; j ++ ) {
+      pair.box = g_array_index(near, gint, j) ;
+      g_array_append_val(d->pairs, pair) ;
+    }
+  }
+  g_array_free(near, TRUE) ;
+
+  return NULL ;
+}
+
+static gpointer fmm_near_field_thread(fmm_batch_t *d)
+
+/*
+  near field of leaves taken in turn from the shared counter d->next,
+  with the results for each pair written to its own slot of d->res
+*/
+
+{
+  GtvFMM *f = d->f ;
+  GtvOctTree *t = f->tree ;
+  GtvOctTreeBox *b ;
+  gdouble *x, *phi, *grad ;
+  gint l, i, j, k, nx, nmax, status ;
+
+  nmax = 0 ; x = phi = grad = NULL ;
+  while ( TRUE ) {
+#if GLIB_CHECK_VERSION(2,32,0)
+    l = g_atomic_int_add(d->next, 1) ;
+#else
+    l = (*(d->next)) ++ ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+    if ( l >= d->nleaves ) break ;
+    b = gtv_oct_tree_box(t, d->leaves[l]) ;
+    nx = d->first[l+1] - d->first[l] ;
+    if ( nx > nmax ) {
+      nmax = nx ;
+      x = g_renew(gdouble, x, 3*nmax) ;
+      phi = g_renew(gdouble, phi, nmax) ;
+      grad = g_renew(gdouble, grad, 3*nmax) ;
+    }
+    for ( i = 0 ; i < nx ; i ++ ) {
+      j = d->all[d->order[d->first[l]+i]].target ;
+      for ( k = 0 ; k < 3 ; k ++ ) x[3*i+k] = d->x[j*d->xstr+k] ;
+      phi[i] = grad[3*i+0] = grad[3*i+1] = grad[3*i+2] = 0.0 ;
+    }
+    status = f->near_batch(&(t->cells[b->first]), &(f->sigma[b->first]),
+			   b->n, x, nx, phi,
+			   (d->grad == NULL ? NULL : grad), f->near_batch_data) ;
+    if ( status != GTV_SUCCESS ) d->ret = status ;
+    for ( i = 0 ; i < nx ; i ++ ) {
+      j = d->order[d->first[l]+i] ;
+      d->res[4*j+0] = phi[i] ;
+      d->res[4*j+1] = grad[3*i+0] ;
+      d->res[4*j+2] = grad[3*i+1] ;
+      d->res[4*j+3] = grad[3*i+2] ;
+    }
+  }
+
+  g_free(x) ; g_free(phi) ; g_free(grad) ;
+
+  return NULL ;
+}
+
+/**
+ * Evaluate the potential of a ::GtvFMM, and optionally its gradient,
+ * at many points, using a number of threads. The far field of each
+ * point is found as in ::gtv_fmm_evaluate, with the points split
+ * evenly between the threads. The near field is then found leaf by
+ * leaf: each leaf is passed once to the batched near-field function
+ * (see ::gtv_fmm_set_near_field_batch), with all of the points in its
+ * near field, and the leaves are shared out between the threads as
+ * they become free. The results are added to \a phi and \a grad, in the
+ * same order whatever the number of threads. If GLib is older than
+ * 2.32, the evaluation is serial.
+ *
+ * @param f a ::GtvFMM whose density has been set;
+ * @param x evaluation points, point \a i at x[i*xstr], x[i*xstr+1],
+ * x[i*xstr+2];
+ * @param xstr stride between points in \a x (at least 3);
+ * @param nx number of points;
+ * @param phi potential at each point, to which the result is added;
+ * @param grad if not NULL, gradient of potential, three components
+ * per point, to which the result is added;
+ * @param n_threads number of threads to use.
+ *
+ * @return GTV_SUCCESS on success, or an error code returned by the
+ * near-field function.
+ */
+
+gint gtv_fmm_evaluate_points(GtvFMM *f, gdouble *x, gint xstr, gint nx,
+			     gdouble *phi, gdouble *grad, gint n_threads)
+
+{
+  GtvOctTree *t ;
+  fmm_batch_t *data ;
+  fmm_pair_t *all ;
+  gint *order, *first, *leaves, *count, i, j, k, np, nl, next, ret ;
+  gdouble *res ;
+#if GLIB_CHECK_VERSION(2,32,0)
+  GThread **threads ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(x != NULL || nx == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(phi != NULL || nx == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(xstr >= 3, GTV_ARGUMENT_OUT_OF_RANGE) ;
+  g_return_val_if_fail(nx >= 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+  g_return_val_if_fail(n_threads > 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+  t = f->tree ;
+  if ( nx == 0 || t->nboxes == 0 ) return GTV_SUCCESS ;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  n_threads = MIN(n_threads, nx) ;
+  threads = g_new(GThread *, n_threads) ;
+#else
+  n_threads = 1 ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  data = g_new0(fmm_batch_t, n_threads) ;
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    data[j].f = f ; data[j].x = x ; data[j].xstr = xstr ;
+    data[j].phi = phi ; data[j].grad = grad ;
+    data[j].i0 = (gint)((gint64)nx*j/n_threads) ;
+    data[j].i1 = (gint)((gint64)nx*(j+1)/n_threads) ;
+    data[j].pairs = g_array_new(FALSE, FALSE, sizeof(fmm_pair_t)) ;
+    data[j].ret = GTV_SUCCESS ;
+  }
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  for ( j = 1 ; j < n_threads ; j ++ )
+    threads[j] = g_thread_new(NULL, (GThreadFunc)fmm_far_field_thread,
+			      &(data[j])) ;
+  fmm_far_field_thread(&(data[0])) ;
+  for ( j = 1 ; j < n_threads ; j ++ ) g_thread_join(threads[j]) ;
+#else
+  fmm_far_field_thread(&(data[0])) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  /*gather the pairs, which are then in target order, and sort them
+    by leaf*/
+  for ( (np = 0), (j = 0) ; j < n_threads ; j ++ ) np += data[j].pairs->len ;
+  all = g_new(fmm_pair_t, np) ;
+  for ( (np = 0), (j = 0) ; j < n_threads ; j ++ ) {
+    memcpy(&(all[np]), data[j].pairs->data,
+	   data[j].pairs->len*sizeof(fmm_pair_t)) ;
+    np += data[j].pairs->len ;
+    g_array_free(data[j].pairs, TRUE) ;
+  }
+
+  count = g_new0(gint, t->nboxes+1) ;
+  for ( i = 0 ; i < np ; i ++ ) count[all[i].box+1] ++ ;
+  for ( (nl = 0), (i = 0) ; i < t->nboxes ; i ++ ) {
+    if ( count[i+1] != 0 ) nl ++ ;
+    count[i+1] += count[i] ;
+  }
+  order = g_new(gint, np) ;
+  leaves = g_new(gint, nl) ; first = g_new(gint, nl+1) ;
+  for ( (nl = 0), (i = 0) ; i < t->nboxes ; i ++ ) {
+    if ( count[i+1] == count[i] ) continue ;
+    leaves[nl] = i ; first[nl] = count[i] ; nl ++ ;
+  }
+  first[nl] = np ;
+  for ( i = 0 ; i < np ; i ++ ) order[count[all[i].box] ++] = i ;
+  g_free(count) ;
+
+  res = g_new(gdouble, 4*np) ;
+  next = 0 ;
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    data[j].all = all ; data[j].order = order ;
+    data[j].first = first ; data[j].leaves = leaves ; data[j].nleaves = nl ;
+    data[j].next = &next ; data[j].res = res ;
+  }
+
+  g_debug("%s: %d near-field pairs over %d leaves on %d threads",
+	  __FUNCTION__, np, nl, n_threads) ;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  for ( j = 1 ; j < n_threads ; j ++ )
+    threads[j] = g_thread_new(NULL, (GThreadFunc)fmm_near_field_thread,
+			      &(data[j])) ;
+  fmm_near_field_thread(&(data[0])) ;
+  for ( j = 1 ; j < n_threads ; j ++ ) g_thread_join(threads[j]) ;
+  g_free(threads) ;
+#else
+  fmm_near_field_thread(&(data[0])) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  /*pairs are in target order, so the sum for each target is always
+    taken in the same order*/
+  for ( i = 0 ; i < np ; i ++ ) {
+    k = all[i].target ;
+    phi[k] += res[4*i+0] ;
+    if ( grad == NULL ) continue ;
+    grad[3*k+0] += res[4*i+1] ;
+    grad[3*k+1] += res[4*i+2] ;
+    grad[3*k+2] += res[4*i+3] ;
+  }
+
+  ret = GTV_SUCCESS ;
+  for ( j = 0 ; j < n_threads ; j ++ )
+    if ( data[j].ret != GTV_SUCCESS ) ret = data[j].ret ;
+
+  g_free(data) ; g_free(all) ; g_free(order) ;
+  g_free(leaves) ; g_free(first) ; g_free(res) ;
+
+  return ret ;
+}
+
+/**
+ * @}
+ *
+ */
@@ -31,6 +31,309 @@
 #include "gtv.h"
 #include "gtv-private.h"
 
+/*counts of filtered predicate evaluations settled by the filter,
+  passed to the adaptive predicates and reaching exact arithmetic, for
+  orient3d (0) and insphere (1), at index count_index(pred,stage). Each
+  thread counts into its own block, so that counting does not
+  serialize threaded code; the blocks of running threads are listed
+  and summed on reading, and those of exited threads are added to
+  predicate_counts_retired. The lock only guards the list and the
+  retired counts*/
+#define count_index(_i,_s) (3*(_i)+(_s))
+static guint64 predicate_counts_retired[6] = {0, 0, 0, 0, 0, 0} ;
+static GSList *predicate_counts_live = NULL ;
+#if GLIB_CHECK_VERSION(2,32,0)
+static void counts_retire(gpointer counts) ;
+static GMutex predicate_counts_mutex ;
+static GPrivate predicate_counts_key = G_PRIVATE_INIT(counts_retire) ;
+#define counts_lock()   g_mutex_lock(&predicate_counts_mutex)
+#define counts_unlock() g_mutex_unlock(&predicate_counts_mutex)
+#else
+#define counts_lock()
+#define counts_unlock()
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+#define count_stage(_i,_s)						\
+  if ( predicates_counting ) counts_thread()[count_index((_i),(_s))] ++
+
+#if GLIB_CHECK_VERSION(2,32,0)
+static void counts_retire(gpointer counts)
+
+/*fold the counts of an exiting thread into the retired counts*/
+
+{
+  guint64 *n = (guint64 *)counts ;
+  gint i ;
+
+  counts_lock() ;
+  for ( i = 0 ; i < 6 ; i ++ ) predicate_counts_retired[i] += n[i] ;
+  predicate_counts_live = g_slist_remove(predicate_counts_live, n) ;
+  counts_unlock() ;
+  g_free(n) ;
+
+  return ;
+}
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+static guint64 *counts_thread(void)
+
+/*block of counts of the calling thread, made on its first use*/
+
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+  guint64 *n ;
+
+  if ( (n = g_private_get(&predicate_counts_key)) != NULL ) return n ;
+
+  n = g_new0(guint64, 6) ;
+  g_private_set(&predicate_counts_key, n) ;
+  counts_lock() ;
+  predicate_counts_live = g_slist_prepend(predicate_counts_live, n) ;
+  counts_unlock() ;
+
+  return n ;
+#else
+  return predicate_counts_retired ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+}
+
+void predicate_count_add(int pred, int stage, int n)
+
+/*add n evaluations of predicate pred resolved at stage*/
+
+{
+  counts_thread()[count_index(pred, stage)] += n ;
+
+  return ;
+}
+
+/*coefficients of the filter error bounds and the ranges of box sizes
+  over which they are valid*/
+#define ORIENT3D_FILTER_COEFFICIENT 5.1107127829973299e-15
+#define ORIENT3D_FILTER_MIN 1e-97
+#define ORIENT3D_FILTER_MAX 1e102
+#define INSPHERE_FILTER_COEFFICIENT 1.3e-13
+#define INSPHERE_FILTER_MIN 1e-58
+#define INSPHERE_FILTER_MAX 1e61
+
+/*number of predicates evaluated together by the batched kernels*/
+#define PREDICATE_BLOCK 8
+
+static void points_extent(gdouble **x, gint n, gdouble *d)
+
+/*side lengths of the bounding box of n points*/
+
+{
+  gdouble xmin[3], xmax[3] ;
+  gint i, j ;
+
+  for ( j = 0 ; j < 3 ; j ++ ) xmin[j] = xmax[j] = x[0][j] ;
+  for ( i = 1 ; i < n ; i ++ ) {
+    for ( j = 0 ; j < 3 ; j ++ ) {
+      xmin[j] = MIN(xmin[j], x[i][j]) ;
+      xmax[j] = MAX(xmax[j], x[i][j]) ;
+    }
+  }
+
+  for ( j = 0 ; j < 3 ; j ++ ) d[j] = xmax[j] - xmin[j] ;
+
+  return ;
+}
+
+gdouble orient3d_filter_bound(gdouble dx, gdouble dy, gdouble dz)
+
+/*
+  bound on the rounding error of the floating point orient3d
+  determinant of points lying in a box of sides dx, dy, dz: 6 times
+  Shewchuk's first stage bound on the permanent, rounded up. Returns
+  G_MAXDOUBLE, so that the adaptive predicate is always used, where
+  the bound could underflow or the determinant overflow
+*/
+
+{
+  gdouble m, M ;
+
+  m = MIN(dx, MIN(dy, dz)) ; M = MAX(dx, MAX(dy, dz)) ;
+  if ( m < ORIENT3D_FILTER_MIN || M > ORIENT3D_FILTER_MAX )
+    return G_MAXDOUBLE ;
+
+  return ORIENT3D_FILTER_COEFFICIENT*dx*dy*dz ;
+}
+
+gdouble insphere_filter_bound(gdouble dx, gdouble dy, gdouble dz)
+
+/*as orient3d_filter_bound, for insphere (72 times Shewchuk's bound)*/
+
+{
+  gdouble m, M ;
+
+  m = MIN(dx, MIN(dy, dz)) ; M = MAX(dx, MAX(dy, dz)) ;
+  if ( m < INSPHERE_FILTER_MIN || M > INSPHERE_FILTER_MAX )
+    return G_MAXDOUBLE ;
+
+  return INSPHERE_FILTER_COEFFICIENT*dx*dy*dz*M*M ;
+}
+
+gdouble orient3d_filtered(gdouble *pa, gdouble *pb, gdouble *pc,
+			  gdouble *pd, gdouble eps)
+
+/*
+  orient3d(pa, pb, pc, pd) using the error bound eps from
+  orient3d_filter_bound, falling back to the adaptive predicate if
+  the sign is not certain
+*/
+
+{
+  gdouble adx, bdx, cdx, ady, bdy, cdy, adz, bdz, cdz, det ;
+
+  adx = pa[0] - pd[0] ; bdx = pb[0] - pd[0] ; cdx = pc[0] - pd[0] ;
+  ady = pa[1] - pd[1] ; bdy = pb[1] - pd[1] ; cdy = pc[1] - pd[1] ;
+  adz = pa[2] - pd[2] ; bdz = pb[2] - pd[2] ; cdz = pc[2] - pd[2] ;
+
+  det = adz*(bdx*cdy - cdx*bdy) + bdz*(cdx*ady - adx*cdy) +
+    cdz*(adx*bdy - bdx*ady) ;
+
+  if ( det > eps || -det > eps ) {
+    count_stage(0, GTV_PREDICATE_FILTER) ;
+    return det ;
+  }
+
+  count_stage(0, GTV_PREDICATE_ADAPTIVE) ;
+
+  return orient3d(pa, pb, pc, pd) ;
+}
+
+gdouble insphere_filtered(gdouble *pa, gdouble *pb, gdouble *pc,
+			  gdouble *pd, gdouble *pe, gdouble eps)
+
+/*as orient3d_filtered, for insphere(pa, pb, pc, pd, pe)*/
+
+{
+  gdouble aex, bex, cex, dex, aey, bey, cey, dey, aez, bez, cez, dez ;
+  gdouble ab, bc, cd, da, ac, bd, abc, bcd, cda, dab ;
+  gdouble alift, blift, clift, dlift, det ;
+
+  aex = pa[0] - pe[0] ; bex = pb[0] - pe[0] ;
+  cex = pc[0] - pe[0] ; dex = pd[0] - pe[0] ;
+  aey = pa[1] - pe[1] ; bey = pb[1] - pe[1] ;
+  cey = pc[1] - pe[1] ; dey = pd[1] - pe[1] ;
+  aez = pa[2] - pe[2] ; bez = pb[2] - pe[2] ;
+  cez = pc[2] - pe[2] ; dez = pd[2] - pe[2] ;
+
+  ab = aex*bey - bex*aey ; bc = bex*cey - cex*bey ;
+  cd = cex*dey - dex*cey ; da = dex*aey - aex*dey ;
+  ac = aex*cey - cex*aey ; bd = bex*dey - dex*bey ;
+
+  abc = aez*bc - bez*ac + cez*ab ;
+  bcd = bez*cd - cez*bd + dez*bc ;
+  cda = cez*da + dez*ac + aez*cd ;
+  dab = dez*ab + aez*bd + bez*da ;
+
+  alift = aex*aex + aey*aey + aez*aez ;
+  blift = bex*bex + bey*bey + bez*bez ;
+  clift = cex*cex + cey*cey + cez*cez ;
+  dlift = dex*dex + dey*dey + dez*dez ;
+
+  det = (dlift*abc - clift*dab) + (blift*cda - alift*bcd) ;
+
+  if ( det > eps || -det > eps ) {
+    count_stage(1, GTV_PREDICATE_FILTER) ;
+    return det ;
+  }
+
+  count_stage(1, GTV_PREDICATE_ADAPTIVE) ;
+
+  return insphere(pa, pb, pc, pd, pe) ;
+}
+
+GTV_TARGET_CLONES
+static void orient3d_block(gdouble **a, gdouble **b, gdouble **c,
+			   gdouble **d, gint n, gdouble *o, gdouble *eps)
+
+/*
+  floating point orient3d determinants and their error bounds for up
+  to PREDICATE_BLOCK sets of points, written without branches so that
+  the loop can be vectorized; the bounds use the largest coordinate
+  differences, which are no larger than the box sides of
+  orient3d_filter_bound
+*/
+
+{
+  gdouble adx, bdx, cdx, ady, bdy, cdy, adz, bdz, cdz ;
+  gdouble ex, ey, ez, m, M ;
+  gint i ;
+
+  for ( i = 0 ; i < n ; i ++ ) {
+    adx = a[i][0] - d[i][0] ; bdx = b[i][0] - d[i][0] ;
+    cdx = c[i][0] - d[i][0] ;
+    ady = a[i][1] - d[i][1] ; bdy = b[i][1] - d[i][1] ;
+    cdy = c[i][1] - d[i][1] ;
+    adz = a[i][2] - d[i][2] ; bdz = b[i][2] - d[i][2] ;
+    cdz = c[i][2] - d[i][2] ;
+
+    o[i] = adz*(bdx*cdy - cdx*bdy) + bdz*(cdx*ady - adx*cdy) +
+      cdz*(adx*bdy - bdx*ady) ;
+
+    ex = MAX(ABS(adx), MAX(ABS(bdx), ABS(cdx))) ;
+    ey = MAX(ABS(ady), MAX(ABS(bdy), ABS(cdy))) ;
+    ez = MAX(ABS(adz), MAX(ABS(bdz), ABS(cdz))) ;
+    m = MIN(ex, MIN(ey, ez)) ; M = MAX(ex, MAX(ey, ez)) ;
+    eps[i] = ( m < ORIENT3D_FILTER_MIN || M > ORIENT3D_FILTER_MAX ) ?
+      G_MAXDOUBLE : ORIENT3D_FILTER_COEFFICIENT*ex*ey*ez ;
+  }
+
+  return ;
+}
+
+GTV_TARGET_CLONES
+static void insphere_block(gdouble **a, gdouble **b, gdouble **c,
+			   gdouble **d, gdouble **e, gint n,
+			   gdouble *o, gdouble *eps)
+
+/*as orient3d_block, for insphere*/
+
+{
+  gdouble aex, bex, cex, dex, aey, bey, cey, dey, aez, bez, cez, dez ;
+  gdouble ab, bc, cd, da, ac, bd, abc, bcd, cda, dab ;
+  gdouble alift, blift, clift, dlift ;
+  gdouble ex, ey, ez, m, M ;
+  gint i ;
+
+  for ( i = 0 ; i < n ; i ++ ) {
+    aex = a[i][0] - e[i][0] ; bex = b[i][0] - e[i][0] ;
+    cex = c[i][0] - e[i][0] ; dex = d[i][0] - e[i][0] ;
+    aey = a[i][1] - e[i][1] ; bey = b[i][1] - e[i][1] ;
+    cey = c[i][1] - e[i][1] ; dey = d[i][1] - e[i][1] ;
+    aez = a[i][2] - e[i][2] ; bez = b[i][2] - e[i][2] ;
+    cez = c[i][2] - e[i][2] ; dez = d[i][2] - e[i][2] ;
+
+    ab = aex*bey - bex*aey ; bc = bex*cey - cex*bey ;
+    cd = cex*dey - dex*cey ; da = dex*aey - aex*dey ;
+    ac = aex*cey - cex*aey ; bd = bex*dey - dex*bey ;
+
+    abc = aez*bc - bez*ac + cez*ab ;
+    bcd = bez*cd - cez*bd + dez*bc ;
+    cda = cez*da + dez*ac + aez*cd ;
+    dab = dez*ab + aez*bd + bez*da ;
+
+    alift = aex*aex + aey*aey + aez*aez ;
+    blift = bex*bex + bey*bey + bez*bez ;
+    clift = cex*cex + cey*cey + cez*cez ;
+    dlift = dex*dex + dey*dey + dez*dez ;
+
+    o[i] = (dlift*abc - clift*dab) + (blift*cda - alift*bcd) ;
+
+    ex = MAX(MAX(ABS(aex), ABS(bex)), MAX(ABS(cex), ABS(dex))) ;
+    ey = MAX(MAX(ABS(aey), ABS(bey)), MAX(ABS(cey), ABS(dey))) ;
+    ez = MAX(MAX(ABS(aez), ABS(bez)), MAX(ABS(cez), ABS(dez))) ;
+    m = MIN(ex, MIN(ey, ez)) ; M = MAX(ex, MAX(ey, ez)) ;
+    eps[i] = ( m < INSPHERE_FILTER_MIN || M > INSPHERE_FILTER_MAX ) ?
+      G_MAXDOUBLE : INSPHERE_FILTER_COEFFICIENT*ex*ey*ez*M*M ;
+  }
+
+  return ;
+}
+
 /**
  * @defgroup geometry Geometric tests
  * @{
@@ -48,7 +351,8 @@
  * @param p4 a ::GtsPoint;
  * 
  * @return positive value if \a p lies inside the sphere, zero if it
- * lies on the sphere and a negative value if it lies outside.
+ * lies on the sphere and a negative value if it lies outside. The
+ * test is made with filtered predicates, as in ::gtv_insphere.
  */
 
 gdouble gtv_point_in_sphere(GtsPoint *p, 
@@ -58,7 +362,7 @@ gdouble gtv_point_in_sphere(GtsPoint *p,
 			    GtsPoint *p4)
 
 {
-  gdouble isp ;
+  gdouble isp, *x[5], d[3] ;
 
   g_return_val_if_fail(p != NULL, 0.0) ;
   g_return_val_if_fail(GTS_IS_POINT(p), 0.0) ;
@@ -71,16 +375,15 @@ gdouble gtv_point_in_sphere(GtsPoint *p,
   g_return_val_if_fail(p4 != NULL, 0.0) ;
   g_return_val_if_fail(GTS_IS_POINT(p4), 0.0) ;
 
-  isp = insphere((gdouble *)(&(GTS_POINT(p1)->x)),
-		 (gdouble *)(&(GTS_POINT(p2)->x)),
-		 (gdouble *)(&(GTS_POINT(p3)->x)),
-		 (gdouble *)(&(GTS_POINT(p4)->x)),
-		 (gdouble *)(&p->x)) ;
+  x[0] = &(p1->x) ; x[1] = &(p2->x) ; x[2] = &(p3->x) ; x[3] = &(p4->x) ;
+  x[4] = &(p->x) ;
+  points_extent(x, 5, d) ;
 
-  if ( gts_point_orientation_3d(GTS_POINT(p1),
-				GTS_POINT(p2),
-				GTS_POINT(p3),
-				GTS_POINT(p4)) < 0.0 ) 
+  isp = insphere_filtered(x[0], x[1], x[2], x[3], x[4],
+			  insphere_filter_bound(d[0], d[1], d[2])) ;
+
+  if ( orient3d_filtered(x[0], x[1], x[2], x[3],
+			 orient3d_filter_bound(d[0], d[1], d[2])) < 0.0 )
     return (-isp) ;
 
   return isp ;
@@ -124,6 +427,267 @@ gboolean gtv_points_are_collinear(GtsPoint *p1,
   return TRUE ;
 }
 
+/** 
+ * Robust orientation test of four points, with the sign convention
+ * of gts_point_orientation_3d. The determinant is first evaluated in
+ * floating point and checked against an error bound computed from
+ * the bounding box of the points (a semi-static filter). Only if that
+ * check fails is the adaptive precision predicate of Shewchuk called,
+ * which in turn falls back to exact arithmetic if it must.
+ * 
+ * @param a coordinates of a point;
+ * @param b coordinates of a point;
+ * @param c coordinates of a point;
+ * @param d coordinates of a point.
+ * 
+ * @return a positive value if \a d lies below the plane through \a a,
+ * \a b and \a c (\a a, \a b and \a c appearing counterclockwise
+ * from above), a negative value if it lies above, and zero if the
+ * points are coplanar.
+ */
+
+gdouble gtv_orient3d(gdouble *a, gdouble *b, gdouble *c, gdouble *d)
+
+{
+  gdouble *x[4], e[3] ;
+
+  x[0] = a ; x[1] = b ; x[2] = c ; x[3] = d ;
+  points_extent(x, 4, e) ;
+
+  return orient3d_filtered(a, b, c, d,
+			   orient3d_filter_bound(e[0], e[1], e[2])) ;
+}
+
+/** 
+ * Robust orientation test of four GtsPoint's, a replacement for
+ * gts_point_orientation_3d using ::gtv_orient3d, which may be called
+ * from several threads at once.
+ * 
+ * @param p1 a GtsPoint;
+ * @param p2 a GtsPoint;
+ * @param p3 a GtsPoint;
+ * @param p4 a GtsPoint.
+ * 
+ * @return a positive value if \a p4 lies below the plane through \a
+ * p1, \a p2 and \a p3, a negative value if it lies above, and zero
+ * if the points are coplanar.
+ */
+
+gdouble gtv_point_orientation_3d(GtsPoint *p1, GtsPoint *p2,
+				 GtsPoint *p3, GtsPoint *p4)
+
+{
+  return gtv_orient3d(&(p1->x), &(p2->x), &(p3->x), &(p4->x)) ;
+}
+
+/** 
+ * Robust insphere test of five points, with a floating point filter
+ * as in ::gtv_orient3d.
+ * 
+ * @param a coordinates of a point;
+ * @param b coordinates of a point;
+ * @param c coordinates of a point;
+ * @param d coordinates of a point;
+ * @param e coordinates of a point.
+ * 
+ * @return a positive value if \a e lies inside the sphere through \a
+ * a, \a b, \a c and \a d, a negative value if it lies outside and
+ * zero if the five points are cospherical, when \a a, \a b, \a c and
+ * \a d are positively oriented (::gtv_orient3d positive); otherwise
+ * the sign is reversed.
+ */
+
+gdouble gtv_insphere(gdouble *a, gdouble *b, gdouble *c, gdouble *d,
+		     gdouble *e)
+
+{
+  gdouble *x[5], ext[3] ;
+
+  x[0] = a ; x[1] = b ; x[2] = c ; x[3] = d ; x[4] = e ;
+  points_extent(x, 5, ext) ;
+
+  return insphere_filtered(a, b, c, d, e,
+			   insphere_filter_bound(ext[0], ext[1], ext[2])) ;
+}
+
+/** 
+ * Evaluate a batch of orientation tests, as in ::gtv_orient3d. The
+ * floating point determinants and their error bounds are computed
+ * together, in a loop which the compiler can vectorize, and the
+ * adaptive predicate is called only for those tests whose sign is
+ * not settled. Where the compiler supports it, the batch kernel is
+ * built for several instruction sets and the best one for the
+ * processor is selected at run time. Test \a i is of the points \a
+ * a[i], \a b[i], \a c[i] and \a d[i], so that one point can be tested
+ * against many facets, or many points against one facet, by
+ * repeating pointers.
+ * 
+ * @param a array of coordinates of points;
+ * @param b array of coordinates of points;
+ * @param c array of coordinates of points;
+ * @param d array of coordinates of points;
+ * @param n number of tests;
+ * @param o on exit, contains the result of each test.
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_orient3d_many(gdouble **a, gdouble **b, gdouble **c, gdouble **d,
+		       gint n, gdouble *o)
+
+{
+  gdouble eps[PREDICATE_BLOCK] ;
+  guint64 *counts ;
+  gint i, j, nb, na ;
+
+  g_return_val_if_fail(n >= 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+  na = 0 ;
+  for ( i = 0 ; i < n ; i += PREDICATE_BLOCK ) {
+    nb = MIN(PREDICATE_BLOCK, n-i) ;
+    orient3d_block(&(a[i]), &(b[i]), &(c[i]), &(d[i]), nb, &(o[i]), eps) ;
+    for ( j = 0 ; j < nb ; j ++ ) {
+      if ( o[i+j] > eps[j] || -o[i+j] > eps[j] ) continue ;
+      o[i+j] = orient3d(a[i+j], b[i+j], c[i+j], d[i+j]) ;
+      na ++ ;
+    }
+  }
+
+  if ( predicates_counting ) {
+    counts = counts_thread() ;
+    counts[count_index(0, GTV_PREDICATE_FILTER)] += n - na ;
+    counts[count_index(0, GTV_PREDICATE_ADAPTIVE)] += na ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/** 
+ * Evaluate a batch of insphere tests, as in ::gtv_insphere, in the
+ * same way as ::gtv_orient3d_many.
+ * 
+ * @param a array of coordinates of points;
+ * @param b array of coordinates of points;
+ * @param c array of coordinates of points;
+ * @param d array of coordinates of points;
+ * @param e array of coordinates of points;
+ * @param n number of tests;
+ * @param o on exit, contains the result of each test.
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_insphere_many(gdouble **a, gdouble **b, gdouble **c, gdouble **d,
+		       gdouble **e, gint n, gdouble *o)
+
+{
+  gdouble eps[PREDICATE_BLOCK] ;
+  guint64 *counts ;
+  gint i, j, nb, na ;
+
+  g_return_val_if_fail(n >= 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+  na = 0 ;
+  for ( i = 0 ; i < n ; i += PREDICATE_BLOCK ) {
+    nb = MIN(PREDICATE_BLOCK, n-i) ;
+    insphere_block(&(a[i]), &(b[i]), &(c[i]), &(d[i]), &(e[i]), nb,
+		   &(o[i]), eps) ;
+    for ( j = 0 ; j < nb ; j ++ ) {
+      if ( o[i+j] > eps[j] || -o[i+j] > eps[j] ) continue ;
+      o[i+j] = insphere(a[i+j], b[i+j], c[i+j], d[i+j], e[i+j]) ;
+      na ++ ;
+    }
+  }
+
+  if ( predicates_counting ) {
+    counts = counts_thread() ;
+    counts[count_index(1, GTV_PREDICATE_FILTER)] += n - na ;
+    counts[count_index(1, GTV_PREDICATE_ADAPTIVE)] += na ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/** 
+ * Switch on or off the counting of the stages at which the filtered
+ * predicates ::gtv_orient3d and ::gtv_insphere, and the tests built
+ * on them, are resolved. Counting is off by default. Each thread
+ * counts separately and the counts are summed by
+ * ::gtv_predicate_counts.
+ * 
+ * @param count if TRUE, count predicate evaluations.
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_predicate_counting(gboolean count)
+
+{
+  predicates_counting = count ;
+
+  return GTV_SUCCESS ;
+}
+
+/** 
+ * Retrieve the number of filtered predicate evaluations resolved at
+ * each stage since counting was started or last reset (see
+ * ::gtv_predicate_counting). Evaluations counted at
+ * ::GTV_PREDICATE_ADAPTIVE include those which reach
+ * ::GTV_PREDICATE_EXACT. The counts of threads which are still
+ * evaluating predicates are read as they stand, so the totals are
+ * exact only once those threads have finished.
+ * 
+ * @param orient if not NULL, on exit contains the counts for
+ * orientation tests, indexed by ::GtvPredicateStage;
+ * @param insphere if not NULL, on exit contains the counts for
+ * insphere tests, indexed by ::GtvPredicateStage.
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_predicate_counts(guint64 *orient, guint64 *insphere)
+
+{
+  guint64 n[6] ;
+  GSList *i ;
+  gint j ;
+
+  counts_lock() ;
+  for ( j = 0 ; j < 6 ; j ++ ) n[j] = predicate_counts_retired[j] ;
+  for ( i = predicate_counts_live ; i != NULL ; i = i->next )
+    for ( j = 0 ; j < 6 ; j ++ ) n[j] += ((guint64 *)(i->data))[j] ;
+  counts_unlock() ;
+
+  for ( j = 0 ; j < 3 ; j ++ ) {
+    if ( orient != NULL ) orient[j] = n[count_index(0, j)] ;
+    if ( insphere != NULL ) insphere[j] = n[count_index(1, j)] ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/** 
+ * Reset the counts of filtered predicate evaluations (see
+ * ::gtv_predicate_counts).
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_predicate_counts_reset(void)
+
+{
+  GSList *i ;
+  gint j ;
+
+  counts_lock() ;
+  for ( j = 0 ; j < 6 ; j ++ ) predicate_counts_retired[j] = 0 ;
+  for ( i = predicate_counts_live ; i != NULL ; i = i->next )
+    for ( j = 0 ; j < 6 ; j ++ ) ((guint64 *)(i->data))[j] = 0 ;
+  counts_unlock() ;
+
+  return GTV_SUCCESS ;
+}
+
 /**
  * @}
  * 
@@ -72,10 +72,12 @@
 There is ABSOLUTELY NO WARRANTY, not even for MERCHANTABILITY or\n\
 FITNESS FOR A PARTICULAR PURPOSE.\n"
 
+void tetrahedron_vertices_cache(GtvTetrahedron *t) ;
 GtsTriangle *triangle_from_vertices(GtsVertex *v1,
 				    GtsVertex *v2,
 				    GtsVertex *v3) ;
-GtvFacet *facet_new_from_vertices(GtvFacetClass *klass,
+GtvFacet *facet_new_from_vertices(GtvVolume *v,
+				  GtvFacetClass *klass,
 				  GtsEdgeClass *edge_class,
 				  GtsVertex *v1,
 				  GtsVertex *v2,
@@ -86,6 +88,115 @@ GtvFacet *facet_new_from_vertices(GtvFacetClass *klass,
 /* 				    GtsVertex *v3) ; */
 gchar *intersection_status(GtvIntersect status) ;
 
+/*insertion order for Delaunay tetrahedralization*/
+typedef struct {
+  GtsVertex *p ;
+  guint64 key ;
+  gint round ;
+} brio_entry_t ;
+
+/*Hilbert curve keys on a 2^HILBERT_BITS grid, for spatial sorting*/
+#define HILBERT_BITS 21
+guint64 hilbert_key(guint32 x[]) ;
+brio_entry_t *brio_order(GPtrArray *vertices) ;
+gint delaunay_insert_sorted(GtvVolume *v, brio_entry_t *e, gint i0, gint i1,
+			   gboolean cavity, GtvCell **guess) ;
+gint delaunay_cavity_grow(GtvVolume *v, GtsVertex *p, GtvCell *c,
+			 gboolean (*lock)(GtvCell *c, gpointer data),
+			 gpointer data,
+			 GSList **cells, GSList **boundary, GSList **outer) ;
+GSList *delaunay_cavity_fill(GtvVolume *v, GtsVertex *p,
+			     GSList *boundary, GSList *outer) ;
+GtvCell *random_closest_cell(GHashTable *h, GtsPoint *p) ;
+
+/*uniform grid holding one cell of a volume per box, as a starting
+  point for location*/
+typedef struct {
+  gdouble x0[3], h ;
+  gint n[3] ;
+  GtvCell **c ;
+} locate_grid_t ;
+
+void locate_grid_insert(GtvVolume *v, GtvCell *c) ;
+void locate_grid_remove(GtvVolume *v, GtvCell *c) ;
+void locate_grid_free(GtvVolume *v) ;
+GtvCell *locate_start_cell(GtvVolume *v, GtsPoint *p) ;
+
+/*state of a visibility walk towards a point: the volume walked
+  through, the current cell, the
+  coordinates of its vertices, the sign of its orientation, the slot
+  of the facet it was entered through (-1 for none) and the last
+  orientation test made*/
+typedef struct {
+  GtvVolume *volume ;
+  GtvCell *t ;
+  gdouble *x[4], o ;
+  gint sgn, in ;
+} locate_walk_t ;
+
+void locate_walk_init(locate_walk_t *w, GtvVolume *volume, GtvCell *t) ;
+gint locate_walk_step(locate_walk_t *w, GtsPoint *p, gint k0) ;
+void locate_walk_cross(locate_walk_t *w, GtsPoint *p, gint k) ;
+
+/*slab pool of objects of one class, with a free list linked through
+  the reserved word of the released objects*/
+typedef struct {
+  GtsObjectClass *klass ;
+  gsize size ;
+  GSList *slabs ;
+  gpointer free ;
+  gint nslabs, in_use, peak ;
+  gboolean orphan ;
+#if GLIB_CHECK_VERSION(2,32,0)
+  GMutex mutex ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+} object_pool_t ;
+
+/*number of objects in each slab of a pool*/
+#define POOL_SLAB_OBJECTS 1024
+
+object_pool_t *object_pool_new(void) ;
+GtsObject *object_pool_alloc(object_pool_t *p, GtsObjectClass *klass) ;
+void object_pool_release(object_pool_t *p, GtsObject *object) ;
+void object_pool_free(object_pool_t *p) ;
+
+/*cells and facets allocated from the pools of a volume, or from the
+  heap if v is NULL*/
+GtvCell *volume_cell_new(GtvVolume *v, GtvCellClass *klass,
+			 GtvFacet *f1, GtvFacet *f2,
+			 GtvFacet *f3, GtvFacet *f4) ;
+GtvFacet *volume_facet_new(GtvVolume *v, GtvFacetClass *klass,
+			   GtsEdge *e1, GtsEdge *e2, GtsEdge *e3) ;
+GtvCell *cell_new_from_vertices(GtvVolume *v,
+				GtvCellClass *klass,
+				GtvFacetClass *facet_class,
+				GtsEdgeClass *edge_class,
+				GtsVertex *v1, GtsVertex *v2,
+				GtsVertex *v3, GtsVertex *v4) ;
+void tetrahedron_disconnect(GtvTetrahedron *t) ;
+
+/*default seed for the stochastic walk of point location*/
+#define GTV_LOCATE_SEED 0x9e3779b9U
+
+/*filtered geometric predicates, with error bounds for points in a
+  box of given side lengths*/
+gdouble orient3d_filter_bound(gdouble dx, gdouble dy, gdouble dz) ;
+gdouble insphere_filter_bound(gdouble dx, gdouble dy, gdouble dz) ;
+gdouble orient3d_filtered(gdouble *pa, gdouble *pb, gdouble *pc,
+			  gdouble *pd, gdouble eps) ;
+gdouble insphere_filtered(gdouble *pa, gdouble *pb, gdouble *pc,
+			  gdouble *pd, gdouble *pe, gdouble eps) ;
+
+/*build a function for several instruction sets, selected at run
+  time, where the compiler and platform allow it*/
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 6) &&	\
+  defined(__x86_64__) && defined(__linux__)
+#define GTV_TARGET_CLONES \
+  __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#define GTV_TARGET_CLONES
+#endif
+
 /* inline void invert3x3(gdouble *Ai, gdouble *A) ; */
 /* inline void multiply3x1(gdouble y[], gdouble *A, gdouble x[]) ; */
 void invert4x4(gdouble *Ai, gdouble *A) ;
@@ -96,6 +207,38 @@ void invert3x3(gdouble *Ai, gdouble *A) ;
    (_y)[1] = (_A)[3]*(_x)[0] + (_A)[4]*(_x)[1] + (_A)[5]*(_x)[2],	\
    (_y)[2] = (_A)[6]*(_x)[0] + (_A)[7]*(_x)[1] + (_A)[8]*(_x)[2])	
 
+/*the neighbours cached in a cell are those in its volume, and are
+  kept only for a cell which is in a single volume; otherwise the
+  neighbour across the facet in slot _k is found from the facet*/
+#define cell_has_single_volume(_c)					\
+  ((_c)->volumes != NULL && (_c)->volumes->next == NULL)
+#define cell_neighbour(_c,_v,_k)					\
+  (cell_has_single_volume(_c) ? (_c)->neighbours[(_k)] :		\
+   cell_neighbour_scan((_c), (_v), (_k)))
+GtvCell *cell_neighbour_scan(GtvCell *c, GtvVolume *v, gint k) ;
+
+/*index (0--3) of facet _f in tetrahedron _t*/
+#define tetrahedron_facet_slot(_t,_f)					\
+  ((_f) == (_t)->f1 ? 0 : ((_f) == (_t)->f2 ? 1 : ((_f) == (_t)->f3 ? 2 : 3)))
+
+/*facet in slot _k (0--3) of tetrahedron _t*/
+#define tetrahedron_facet(_t,_k)					\
+  ((_k) == 0 ? (_t)->f1 : ((_k) == 1 ? (_t)->f2 :			\
+			   ((_k) == 2 ? (_t)->f3 : (_t)->f4)))
+
+/*traversal stamps for vertices, edges and facets, held in the
+  GtsObject flags above the bits used by GTS*/
+#define GTV_EPOCH_SHIFT 8
+#define GTV_EPOCH_MAX   ((1U << (32 - GTV_EPOCH_SHIFT)) - 1)
+#define object_epoch(_o) (GTS_OBJECT(_o)->flags >> GTV_EPOCH_SHIFT)
+#define object_epoch_set(_o,_e)						\
+  (GTS_OBJECT(_o)->flags = (GTS_OBJECT(_o)->flags &			\
+			     ((1U << GTV_EPOCH_SHIFT) - 1)) |		\
+   ((guint)(_e) << GTV_EPOCH_SHIFT))
+
+/*maximum depth of a GtvOctTree, which bounds the traversal stacks*/
+#define OCT_TREE_DEPTH_MAX 20
+
 #define box_diagonal(box) (sqrt((box->x1-box->x2)*(box->x1-box->x2) + \
 				(box->y1-box->y2)*(box->y1-box->y2) + \
 				(box->z1-box->z2)*(box->z1-box->z2)))
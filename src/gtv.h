@@ -86,6 +86,20 @@ extern "C" {
 		GTV_ON_VERTEX = 4  /// vertex lies on a vertex of tetrahedron
   } GtvIntersect ;
 
+  /**
+   * Stages of evaluation of the filtered geometric predicates
+   * ::gtv_orient3d and ::gtv_insphere, for the counts returned by
+   * ::gtv_predicate_counts.
+   */
+
+  typedef enum {
+		GTV_PREDICATE_FILTER =   0, /**< sign settled by floating point filter */
+		GTV_PREDICATE_ADAPTIVE = 1, /**< passed to adaptive precision predicate */
+		GTV_PREDICATE_EXACT =    2  /**< required exact expansion arithmetic */
+  } GtvPredicateStage ;
+
+#define GTV_PREDICATE_STAGE_NUMBER 3
+
   /**
    * @}
    * 
@@ -227,6 +241,10 @@ extern "C" {
 
       /*< public >*/
       GSList *tetrahedra ;
+
+      /*< private >*/
+      /*pool the facet was allocated from, NULL for the heap*/
+      gpointer pool ;
     };
 
   struct _GtvFacetClass {
@@ -244,6 +262,12 @@ extern "C" {
     GtvFacet *f2 ;
     GtvFacet *f3 ;
     GtvFacet *f4 ;
+
+    /*vertices opposite f1, ..., f4, set from the facets*/
+    GtsVertex *v1 ;
+    GtsVertex *v2 ;
+    GtsVertex *v3 ;
+    GtsVertex *v4 ;
   };
 
   struct _GtvTetrahedronClass {
@@ -256,6 +280,12 @@ extern "C" {
 
     /*< public >*/
     GSList *volumes ;
+    /*cells of the parent volume across f1, ..., f4, NULL on the boundary*/
+    GtvCell *neighbours[4] ;
+
+    /*< private >*/
+    /*pool the cell was allocated from, NULL for the heap*/
+    gpointer pool ;
   };
 
   struct _GtvCellClass {
@@ -275,6 +305,14 @@ extern "C" {
     GtsEdgeClass *edge_class ;
     GtsVertexClass *vertex_class ;
     gboolean keep_cells ;
+    /*numbers of vertices, edges and facets used by the cells*/
+    guint n_vertices, n_edges, n_facets ;
+    /*seed of the random choices made in point location*/
+    guint32 seed ;
+    /*grid of cells for starting point location, if any (private)*/
+    gpointer grid ;
+    /*slab pools for the cells and facets made for the volume (private)*/
+    gpointer cell_pool, facet_pool ;
   };
 
   struct _GtvVolumeClass {
@@ -294,6 +332,11 @@ extern "C" {
       *dImnk, *B ;
     gint stride, order ;
     GtsPoint *xc ;
+    /*position in a ::GtvOctTree: level (0 for the root), index of
+      parent and of first of eight children (-1 if none), and range
+      of the tree cells in the box*/
+    gint level, parent_box, child ;
+    guint first, n ;
   };
 
   struct _GtvOctTreeBoxClass {
@@ -374,8 +417,173 @@ extern "C" {
   } ;
 #endif /*DOXYGEN_BLOCK*/
 
+#ifdef DOXYGEN_BLOCK
+  /**
+   * @struct GtvMesh
+   * @ingroup mesh
+   * Compact index-based tetrahedral mesh
+   *
+   */
+
+  typedef struct {
+    gint32 nv ;          /**< number of vertices */
+    gint32 nc ;          /**< number of cells */
+    gint32 nvmax ;       /**< number of vertices allocated */
+    gint32 ncmax ;       /**< number of cells allocated */
+    gdouble *x ;         /**< vertex coordinates, three per vertex */
+    gint32 *cells ;      /**< cell vertex indices, four per cell */
+    gint32 *neighbours ; /**< index of cell opposite each vertex, or -1 */
+    gint32 na ;          /**< number of attributes per cell */
+    gdouble *attributes ; /**< cell attributes, \a na per cell */
+    gpointer map ;       /**< file mapping of a read-only mesh, or NULL */
+  } GtvMesh ;
+#else
+  typedef struct _GtvMesh      GtvMesh ;
+  struct _GtvMesh {
+    gint32 nv, nc, nvmax, ncmax ;
+    gdouble *x ;
+    gint32 *cells ;
+    gint32 *neighbours ;
+    gint32 na ;
+    gdouble *attributes ;
+    gpointer map ;
+  } ;
+#endif /*DOXYGEN_BLOCK*/
+
+  /**
+   * Version of the binary mesh format written by
+   * ::gtv_mesh_write_binary.
+   * @hideinitializer
+   * @addtogroup mesh
+   */
+
+#define GTV_MESH_BINARY_VERSION 1
+
+#ifdef DOXYGEN_BLOCK
+  /**
+   * @struct GtvOctTree
+   * @ingroup octree
+   * Octree over the cells of a ::GtvVolume
+   *
+   */
+
+  typedef struct {
+    GtvOctTreeBox *boxes ; /**< boxes, root first, with the eight children of a box contiguous */
+    gsize box_size ;       /**< size of each box, which may be of a class derived from ::GtvOctTreeBox */
+    gint nboxes ;          /**< number of boxes */
+    gint depth ;           /**< deepest level in the tree */
+    GtvCell **cells ;      /**< cells, ordered so that those of a box are contiguous */
+    guint ncells ;         /**< number of cells */
+    gdouble *centroids ;   /**< cell centroids, three per cell, in the order of \a cells */
+    gdouble width ;        /**< side length of the root box */
+    GtsPoint *centres ;    /**< storage for the box centres */
+  } GtvOctTree ;
+#else
+  typedef struct _GtvOctTree   GtvOctTree ;
+  struct _GtvOctTree {
+    GtvOctTreeBox *boxes ;
+    gsize box_size ;
+    gint nboxes, depth ;
+    GtvCell **cells ;
+    guint ncells ;
+    gdouble *centroids ;
+    gdouble width ;
+    GtsPoint *centres ;
+  } ;
+#endif /*DOXYGEN_BLOCK*/
+
+  /**
+   * Near-field function for a ::GtvFMM, which adds the potential of a
+   * list of cells, and its gradient if \a grad is not NULL, at a point
+   * \a x to \a phi and \a grad. \a sigma is the density on each
+   * of the \a n cells. It should return GTV_SUCCESS on success.
+   */
+
+  typedef gint (*GtvFMMNearFunc)(GtvCell **cells, gdouble *sigma, guint n,
+				 GtsPoint *x, gdouble *phi, gdouble *grad,
+				 gpointer data) ;
+  /**
+   * Batched near-field function for a ::GtvFMM, which adds the
+   * potential of a list of cells at \a nx points \a x (three
+   * coordinates per point) to \a phi and, if \a grad is not NULL,
+   * its gradient to \a grad (three components per point). \a sigma
+   * is the density on each of the \a n cells. It should return
+   * GTV_SUCCESS on success.
+   */
+
+  typedef gint (*GtvFMMNearBatchFunc)(GtvCell **cells, gdouble *sigma,
+				      guint n, gdouble *x, gint nx,
+				      gdouble *phi, gdouble *grad,
+				      gpointer data) ;
+  /**
+   * Density function for a ::GtvFMM, returning the (constant) density
+   * on a cell.
+   */
+
+  typedef gdouble (*GtvFMMDensityFunc)(GtvCell *c, gpointer data) ;
+
+  /**
+   * Function called by ::gtv_volume_ray_traverse for each cell \a c
+   * crossed by ray number \a ray, which enters \a c at parameter \a
+   * s0 and leaves at \a s1. It should return GTV_SUCCESS to continue
+   * the traversal of the ray.
+   */
+
+  typedef gint (*GtvRayFunc)(GtvCell *c, gint ray, gdouble s0, gdouble s1,
+			     gpointer data) ;
+
+#ifdef DOXYGEN_BLOCK
+  /**
+   * @struct GtvFMM
+   * @ingroup fmm
+   * Multipole evaluation of volume potentials over a ::GtvOctTree
+   *
+   */
+
+  typedef struct {
+    GtvOctTree *tree ;      /**< octree holding the cells and expansions */
+    gint order ;            /**< order of multipole expansions */
+    gdouble theta ;         /**< opening parameter */
+    gdouble *sigma ;        /**< density on each cell, in the order of \a tree cells */
+    gint nq ;               /**< Gauss points per direction in the cell quadrature rule */
+    gint nr ;               /**< number of points in the cell quadrature rule */
+    gdouble *rule ;         /**< cell quadrature rule, three reference coordinates and a weight per point */
+    GtvFMMNearFunc near ;   /**< near-field function */
+    gpointer near_data ;    /**< user data for \a near */
+    GtvFMMNearBatchFunc near_batch ; /**< batched near-field function */
+    gpointer near_batch_data ;       /**< user data for \a near_batch */
+  } GtvFMM ;
+#else
+  typedef struct _GtvFMM   GtvFMM ;
+  struct _GtvFMM {
+    GtvOctTree *tree ;
+    gint order ;
+    gdouble theta ;
+    gdouble *sigma ;
+    gint nq, nr ;
+    gdouble *rule ;
+    GtvFMMNearFunc near ;
+    gpointer near_data ;
+    GtvFMMNearBatchFunc near_batch ;
+    gpointer near_batch_data ;
+  } ;
+#endif /*DOXYGEN_BLOCK*/
+
+  /**
+   * Highest order of multipole expansion in a ::GtvFMM, and of the
+   * tabulated binomial coefficients and factorials.
+   * @hideinitializer
+   * @addtogroup fmm
+   */
+
+#define GTV_FMM_ORDER_MAX 16
+
+  GTV_C_VAR const gdouble GTV_BINOMIALS[] ;
+  GTV_C_VAR const gdouble GTV_FACTORIALS[] ;
+
   GTV_C_VAR gboolean gtv_allow_floating_facets ;
   GTV_C_VAR gboolean gtv_allow_floating_cells ;
+  GTV_C_VAR gboolean gtv_delaunay_cavity_insertion ;
 
 
   /* Facets: facet.c */
@@ -513,6 +721,7 @@ extern "C" {
 			GtvFacet *f3,
 			GtvFacet *f4) ;
   GSList *gtv_cell_neighbours(GtvCell *c, GtvVolume *v) ;
+  GtvCell *gtv_cell_neighbour(GtvCell *c, GtvFacet *f) ;
   GtvCell *gtv_cell_new_from_vertices(GtvCellClass *klass,
 				      GtvFacetClass *facet_class,
 				      GtsEdgeClass *edge_class,
@@ -533,12 +742,15 @@ extern "C" {
 			    GtsEdgeClass *edge_class,
 			    GtsVertexClass *vertex_class) ;
   gint gtv_volume_add_cell(GtvVolume *v, GtvCell *c) ;
+  gint gtv_volume_set_seed(GtvVolume *v, guint32 seed) ;
   gint gtv_volume_remove_cell(GtvVolume *v, GtvCell *c) ;
   gint gtv_volume_write(GtvVolume *v, FILE *f) ;
   guint gtv_volume_read(GtvVolume *v, GtsFile *f) ;
-  guint gtv_volume_read_gmsh(FILE *f, GtvVolume *v) ;
+  guint gtv_volume_read_ascii(GtvVolume *v, FILE *f) ;
+  gint gtv_volume_read_gmsh(FILE *f, GtvVolume *v, guint *line) ;
   gint gtv_volume_write_gmsh(GtvVolume *v, FILE *f) ;
   gint gtv_volume_write_gmsh1(GtvVolume *v, FILE *f) ;
+  gint gtv_volume_write_gmsh_binary(GtvVolume *v, FILE *f) ;
   gint gtv_volume_foreach_cell(GtvVolume *v, GtsFunc func, gpointer data) ;
   gint gtv_volume_foreach_facet(GtvVolume *v, GtsFunc func, gpointer data) ;
   gint gtv_volume_foreach_vertex(GtvVolume *v, GtsFunc func, gpointer data) ;
@@ -546,9 +758,15 @@ extern "C" {
   gint gtv_volume_quality_stats(GtvVolume *v, GtvVolumeQualityStats *s) ;
   gint gtv_volume_stats(GtvVolume *v, GtvVolumeStats *s) ;
   gint gtv_volume_print_stats(GtvVolume *v, FILE *f) ;
+  gint gtv_volume_pool_stats(GtvVolume *v,
+			     gint *cells_in_use, gint *cells_peak,
+			     gint *facets_in_use, gint *facets_peak,
+			     gsize *bytes) ;
   gint gtv_volume_boundary(GtvVolume *v, GtsSurface *s) ;
   gdouble gtv_volume_volume(GtvVolume *v) ;
   guint gtv_volume_vertex_number(GtvVolume *v) ;
+  guint gtv_volume_edge_number(GtvVolume *v) ;
+  guint gtv_volume_facet_number(GtvVolume *v) ;
   guint gtv_volume_cell_number(GtvVolume *v) ;
   GtsVertex *gtv_volume_nearest_vertex(GtvVolume *v, GtsPoint *p) ;
   gint gtv_volume_write_tetgen(GtvVolume *v, gchar *stub) ;
@@ -561,18 +779,188 @@ extern "C" {
   guint gtv_facet_cell_number(GtvFacet *f, GtvVolume *v) ;
   GtsBBox *gtv_bbox_volume(GtsBBoxClass *klass, GtvVolume *v) ;
 
+  /* Compact meshes: mesh.c */
+
+  GtvMesh *gtv_mesh_new(gint32 nv, gint32 nc) ;
+  gint gtv_mesh_free(GtvMesh *m) ;
+  gint32 gtv_mesh_vertex_add(GtvMesh *m, gdouble x, gdouble y, gdouble z) ;
+  gint32 gtv_mesh_cell_add(GtvMesh *m, gint32 v1, gint32 v2, gint32 v3,
+			   gint32 v4) ;
+  gint gtv_mesh_neighbours(GtvMesh *m) ;
+  gint gtv_mesh_attributes_alloc(GtvMesh *m, gint32 na) ;
+  GtvMesh *gtv_mesh_from_volume(GtvVolume *v) ;
+  gint gtv_mesh_to_volume(GtvMesh *m, GtvVolume *v) ;
+  gint gtv_mesh_write_binary(GtvMesh *m, FILE *f) ;
+  GtvMesh *gtv_mesh_map_binary(const gchar *file) ;
+  gint gtv_volume_write_binary(GtvVolume *v, FILE *f) ;
+  gint gtv_volume_read_binary(GtvVolume *v, const gchar *file) ;
+
+  /**
+   * Coordinates of vertex \a i of a ::GtvMesh.
+   * @hideinitializer
+   * @addtogroup mesh
+   */
+
+#define gtv_mesh_vertex(m,i) (&((m)->x[3*(i)]))
+  /**
+   * Vertex indices of cell \a i of a ::GtvMesh.
+   * @hideinitializer
+   * @addtogroup mesh
+   */
+
+#define gtv_mesh_cell(m,i) (&((m)->cells[4*(i)]))
+  /**
+   * Neighbour of cell \a i of a ::GtvMesh opposite its vertex \a j.
+   * @hideinitializer
+   * @addtogroup mesh
+   */
+
+#define gtv_mesh_neighbour(m,i,j) ((m)->neighbours[4*(i)+(j)])
+  /**
+   * Attributes of cell \a i of a ::GtvMesh.
+   * @hideinitializer
+   * @addtogroup mesh
+   */
+
+#define gtv_mesh_cell_attributes(m,i) (&((m)->attributes[(m)->na*(i)]))
+
+  /* Octrees: octree.c */
+
+  GtvOctTreeBoxClass *gtv_oct_tree_box_class(void) ;
+  GtvOctTreeBox *gtv_oct_tree_box_new(GtvOctTreeBoxClass *klass,
+				      gdouble x1, gdouble y1, gdouble z1,
+				      gdouble x2, gdouble y2, gdouble z2) ;
+  GtvOctTree *gtv_oct_tree_new(GtvVolume *v, GtvOctTreeBoxClass *klass,
+			       gint depth, guint leaf) ;
+  gint gtv_oct_tree_free(GtvOctTree *t) ;
+  GtvCell *gtv_oct_tree_point_locate(GtvOctTree *t, GtsPoint *p) ;
+  GSList *gtv_oct_tree_box_cells(GtvOctTree *t, GtsBBox *b) ;
+  gint gtv_oct_tree_nearest_cells(GtvOctTree *t, GtsPoint *p, gint k,
+				  GtvCell **cells, gdouble *r) ;
+
+  /**
+   * Box \a i of a ::GtvOctTree.
+   * @hideinitializer
+   * @addtogroup octree
+   */
+
+#define gtv_oct_tree_box(t,i)					\
+  ((GtvOctTreeBox *)((gchar *)((t)->boxes) + (gsize)(i)*(t)->box_size))
+  /**
+   * Cell \a j of box \a b of a ::GtvOctTree.
+   * @hideinitializer
+   * @addtogroup octree
+   */
+
+#define gtv_oct_tree_box_cell(t,b,j) ((t)->cells[(b)->first+(j)])
+  /**
+   * Side length of box \a b of a ::GtvOctTree.
+   * @hideinitializer
+   * @addtogroup octree
+   */
+
+#define gtv_oct_tree_box_width(t,b) ((t)->width/(gdouble)(1 << (b)->level))
+  /**
+   * TRUE if box \a b of a ::GtvOctTree has no children.
+   * @hideinitializer
+   * @addtogroup octree
+   */
+
+#define gtv_oct_tree_box_is_leaf(b) ((b)->child < 0)
+
+  /* Potential integrals: integrals.c */
+
+  gint gtv_tetrahedron_potential(GtvTetrahedron *t, GtsPoint *x,
+				 gdouble *phi, gdouble *grad) ;
+  gint gtv_tetrahedron_potential_linear(GtvTetrahedron *t, gdouble *sigma,
+					GtsPoint *x, gdouble *phi,
+					gdouble *grad) ;
+  gint gtv_tetrahedra_potentials(gdouble *v, gdouble *sigma, gint ns, gint nt,
+				 gdouble *x, gint nx, gdouble *phi,
+				 gdouble *grad) ;
+
+  /* Multipole evaluation: fmm.c */
+
+  GtvFMM *gtv_fmm_new(GtvOctTree *t, gint order, gdouble theta) ;
+  gint gtv_fmm_free(GtvFMM *f) ;
+  gint gtv_fmm_set_near_field(GtvFMM *f, GtvFMMNearFunc func, gpointer data) ;
+  gint gtv_fmm_set_density(GtvFMM *f, GtvFMMDensityFunc func, gpointer data) ;
+  gint gtv_fmm_evaluate(GtvFMM *f, GtsPoint *x, gdouble *phi, gdouble *grad) ;
+  gint gtv_fmm_near_field_quadrature(GtvCell **cells, gdouble *sigma, guint n,
+				     GtsPoint *x, gdouble *phi, gdouble *grad,
+				     gpointer data) ;
+  gint gtv_fmm_set_near_field_batch(GtvFMM *f, GtvFMMNearBatchFunc func,
+				    gpointer data) ;
+  gint gtv_fmm_evaluate_points(GtvFMM *f, gdouble *x, gint xstr, gint nx,
+			       gdouble *phi, gdouble *grad, gint n_threads) ;
+  gint gtv_fmm_near_field_quadrature_batch(GtvCell **cells, gdouble *sigma,
+					   guint n, gdouble *x, gint nx,
+					   gdouble *phi, gdouble *grad,
+					   gpointer data) ;
+  gint gtv_fmm_near_field_analytic(GtvCell **cells, gdouble *sigma, guint n,
+				   GtsPoint *x, gdouble *phi, gdouble *grad,
+				   gpointer data) ;
+  gint gtv_fmm_near_field_analytic_batch(GtvCell **cells, gdouble *sigma,
+					 guint n, gdouble *x, gint nx,
+					 gdouble *phi, gdouble *grad,
+					 gpointer data) ;
+
+  /**
+   * Number of multipole coefficients \f$I_{mnk}\f$, \f$m+n+k\leq p\f$.
+   * @hideinitializer
+   * @addtogroup fmm
+   */
+
+#define gtv_fmm_coefficient_number(p) (((p)+1)*((p)+2)*((p)+3)/6)
+  /**
+   * Index of coefficient \f$I_{mnk}\f$ in the \a Imnk array of a
+   * ::GtvOctTreeBox: coefficients are ordered by total order
+   * \f$m+n+k\f$, then by \f$n+k\f$, then by \f$k\f$.
+   * @hideinitializer
+   * @addtogroup fmm
+   */
+
+#define gtv_fmm_index(m,n,k)					\
+  (gtv_fmm_coefficient_number((m)+(n)+(k)-1) + ((n)+(k))*((n)+(k)+1)/2 + (k))
+  /**
+   * Size of the largest multipole expansion in a ::GtvFMM.
+   * @hideinitializer
+   * @addtogroup fmm
+   */
+
+#define GTV_FMM_COEFFICIENT_NUMBER_MAX \
+  gtv_fmm_coefficient_number(GTV_FMM_ORDER_MAX)
+
   /*point location*/
   GtvCell *gtv_point_locate(GtsPoint *p, GtvVolume *v, GtvCell *guess) ;
   GtvCell *gtv_point_locate_slow(GtsPoint *p, GtvVolume *volume, 
 				 GtvCell *guess) ;
+  gint gtv_point_locate_many(GtvVolume *v, const gdouble *xyz, gint n,
+			     GtvCell **out, gint n_threads) ;
+  gint gtv_volume_locate_grid(GtvVolume *v, guint n) ;
+  gint gtv_volume_locate_grid_clear(GtvVolume *v) ;
+  /*ray traversal*/
+  gint gtv_volume_ray_traverse(GtvVolume *v, GtsPoint *origin,
+			       GtsVector direction, GtvRayFunc func,
+			       gpointer data) ;
+  gint gtv_volume_ray_traverse_many(GtvVolume *v, gdouble *origins,
+				    gdouble *directions, gint n,
+				    GtvRayFunc func, gpointer data,
+				    gint n_threads) ;
   /*Delaunay*/
   gboolean gtv_facet_is_regular(GtvFacet *f) ;
   GtvCell *gtv_delaunay_check(GtvVolume *v) ;
   gint gtv_delaunay_add_vertex_to_cell(GtvVolume *v,
 				       GtsVertex *p,
 				       GtvCell *c) ;
+  gint gtv_delaunay_add_vertex_to_cavity(GtvVolume *v,
+					 GtsVertex *p,
+					 GtvCell *c) ;
   gint gtv_delaunay_add_vertex(GtvVolume *v, GtsVertex *p, GtvCell *c) ;
+  gint gtv_delaunay_add_vertices(GtvVolume *v, GPtrArray *vertices) ;
   gint gtv_delaunay_remove_vertex(GtvVolume *v, GtsVertex *p) ;
+  gint gtv_delaunay_build_parallel(GtvVolume *v, GPtrArray *vertices,
+				   gint n_threads) ;
 
   /*geometric tests*/
   gdouble gtv_point_in_sphere(GtsPoint *p, 
@@ -583,13 +971,38 @@ extern "C" {
   gboolean gtv_points_are_collinear(GtsPoint *p1,
 				    GtsPoint *p2,
 				    GtsPoint *p3) ;
+  gdouble gtv_orient3d(gdouble *a, gdouble *b, gdouble *c, gdouble *d) ;
+  gdouble gtv_point_orientation_3d(GtsPoint *p1, GtsPoint *p2,
+				   GtsPoint *p3, GtsPoint *p4) ;
+  gdouble gtv_insphere(gdouble *a, gdouble *b, gdouble *c, gdouble *d,
+		       gdouble *e) ;
+  gint gtv_orient3d_many(gdouble **a, gdouble **b, gdouble **c, gdouble **d,
+			 gint n, gdouble *o) ;
+  gint gtv_insphere_many(gdouble **a, gdouble **b, gdouble **c, gdouble **d,
+			 gdouble **e, gint n, gdouble *o) ;
+  gint gtv_predicate_counting(gboolean count) ;
+  gint gtv_predicate_counts(guint64 *orient, guint64 *insphere) ;
+  gint gtv_predicate_counts_reset(void) ;
   gint gtv_delaunay_remove_vertex(GtvVolume *v, GtsVertex *p) ;
   /*Logging*/
   gint gtv_logging_init(FILE *f, gchar *p, 
 			GLogLevelFlags log_level,
 			gpointer exit_func) ;
 
+  /**
+   * Binomial coefficient \f$\binom{m}{k}\f$, for \f$m\leq\f$
+   * ::GTV_FMM_ORDER_MAX.
+   * @hideinitializer
+   * @addtogroup fmm
+   */
+
 #define gtv_binomial(m,k) (GTV_BINOMIALS[(m)*((m)+1)/2+(k)])
+  /**
+   * Factorial \f$i!\f$, for \f$i\leq\f$ ::GTV_FMM_ORDER_MAX.
+   * @hideinitializer
+   * @addtogroup fmm
+   */
+
 #define gtv_factorial(i) GTV_FACTORIALS[(i)]
 
 #ifdef __cplusplus
@@ -0,0 +1,408 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @defgroup integrals Potential integrals over tetrahedra
+ *
+ * Closed-form evaluation of the potential
+ * \f[
+ * \phi(\mathbf{x}) = \int_{T}\frac{\sigma(\mathbf{y})}
+ * {|\mathbf{x}-\mathbf{y}|}\,\mathrm{d}V(\mathbf{y})
+ * \f]
+ * of a tetrahedron \f$T\f$, and of its gradient, for constant and
+ * linear densities \f$\sigma\f$, at any point \f$\mathbf{x}\f$, inside
+ * or outside \f$T\f$. The method is that of Suh and of Newman: the
+ * divergence theorem reduces the volume integrals to integrals of
+ * \f$1/R\f$ and \f$R\f$ over the faces, with \f$R\f$ the distance
+ * from \f$\mathbf{x}\f$, which reduce in turn to closed-form integrals
+ * along the edges. Writing \f$h_{f}\f$ for the distance of
+ * \f$\mathbf{x}\f$ behind face \f$f\f$, with outward normal
+ * \f$\mathbf{n}_{f}\f$, a constant density gives
+ * \f[
+ * \phi = \frac{\sigma}{2}\sum_{f}h_{f}\int_{f}\frac{1}{R}\,\mathrm{d}S,
+ * \quad
+ * \nabla\phi = -\sigma\sum_{f}\mathbf{n}_{f}\int_{f}\frac{1}{R}
+ * \,\mathrm{d}S,
+ * \f]
+ * and a linear density adds terms in its gradient and in integrals of
+ * \f$R\f$ and \f$(\mathbf{y}-\mathbf{x})/R\f$ over the faces.
+ *
+ * ::gtv_tetrahedra_potentials works on packed vertex coordinates and
+ * densities for many tetrahedra and points at once: the geometry of
+ * each tetrahedron is found once and the loop over points is
+ * innermost.
+ *
+ * @{
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <gts.h>
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+/*edges whose line passes closer to the field point than this, relative
+  to their length, are treated as passing through it*/
+#define INTEGRAL_EDGE_TOLERANCE 1e-12
+
+/*face k is opposite vertex k; the vertices of a face are listed
+  anticlockwise about the outward normal of a positively oriented
+  tetrahedron*/
+static const gint tet_faces[4][3] = {{1, 2, 3}, {0, 3, 2},
+				     {0, 1, 3}, {0, 2, 1}} ;
+
+typedef struct {
+  gdouble v[12] ;
+  /*outward normal and area of each face*/
+  gdouble n[12], A[4] ;
+  /*for each face, vertex indices in anticlockwise order and, for each
+    edge, its unit direction, outward normal in the face and length*/
+  gint f[12] ;
+  gdouble s[36], m[36], L[12] ;
+  gdouble V ;
+} tet_geometry_t ;
+
+#define vector_cross(_c,_a,_b)				\
+  ((_c)[0] = (_a)[1]*(_b)[2] - (_a)[2]*(_b)[1],		\
+   (_c)[1] = (_a)[2]*(_b)[0] - (_a)[0]*(_b)[2],		\
+   (_c)[2] = (_a)[0]*(_b)[1] - (_a)[1]*(_b)[0])
+#define vector_dot(_a,_b) ((_a)[0]*(_b)[0]+(_a)[1]*(_b)[1]+(_a)[2]*(_b)[2])
+
+static void tet_geometry(const gdouble *v, tet_geometry_t *g)
+
+{
+  gdouble e1[3], e2[3], e3[3], len, *s ;
+  gint i, j, k, p, q ;
+  gboolean flip ;
+
+  memcpy(g->v, v, 12*sizeof(gdouble)) ;
+  for ( i = 0 ; i < 3 ; i ++ ) {
+    e1[i] = v[3+i] - v[i] ; e2[i] = v[6+i] - v[i] ; e3[i] = v[9+i] - v[i] ;
+  }
+  vector_cross(g->n, e1, e2) ;
+  g->V = vector_dot(g->n, e3)/6.0 ;
+  flip = (g->V < 0.0) ;
+  g->V = fabs(g->V) ;
+
+  for ( k = 0 ; k < 4 ; k ++ ) {
+    g->f[3*k+0] = tet_faces[k][0] ;
+    g->f[3*k+1] = tet_faces[k][flip ? 2 : 1] ;
+    g->f[3*k+2] = tet_faces[k][flip ? 1 : 2] ;
+    p = g->f[3*k+0] ;
+    for ( i = 0 ; i < 3 ; i ++ ) {
+      e1[i] = v[3*g->f[3*k+1]+i] - v[3*p+i] ;
+      e2[i] = v[3*g->f[3*k+2]+i] - v[3*p+i] ;
+    }
+    vector_cross(&(g->n[3*k]), e1, e2) ;
+    len = sqrt(vector_dot(&(g->n[3*k]), &(g->n[3*k]))) ;
+    g->A[k] = 0.5*len ;
+    for ( i = 0 ; i < 3 ; i ++ ) g->n[3*k+i] /= len ;
+
+    for ( j = 0 ; j < 3 ; j ++ ) {
+      p = g->f[3*k+j] ; q = g->f[3*k+(j+1)%3] ;
+      s = &(g->s[9*k+3*j]) ;
+      for ( i = 0 ; i < 3 ; i ++ ) s[i] = v[3*q+i] - v[3*p+i] ;
+      g->L[3*k+j] = len = sqrt(vector_dot(s, s)) ;
+      for ( i = 0 ; i < 3 ; i ++ ) s[i] /= len ;
+      vector_cross(&(g->m[9*k+3*j]), s, &(g->n[3*k])) ;
+    }
+  }
+
+  return ;
+}
+
+/*R+l, computed without cancellation when l is negative*/
+#define edge_log_argument(_l,_R,_R02) ((_l) >= 0.0 ? (_R)+(_l) : (_R02)/((_R)-(_l)))
+
+static void tet_face_integrals(tet_geometry_t *g, gint k, const gdouble *x,
+			       const gdouble *R, gboolean linear,
+			       gdouble *h, gdouble *I, gdouble *Ip,
+			       gdouble *J)
+
+/*
+  integrals of 1/R (I), and if linear is TRUE of R (Ip) and (y-x)/R
+  (J), over face k, and the height h of the face above x
+*/
+
+{
+  gdouble *n = &(g->n[3*k]), *s, *m, rho[3], a[3], d, lm, lp, P0, R02,
+    f, E, sP ;
+  gint i, p, q ;
+
+  p = g->f[3*k] ;
+  for ( i = 0 ; i < 3 ; i ++ ) a[i] = g->v[3*p+i] - x[i] ;
+  *h = vector_dot(n, a) ;
+  d = fabs(*h) ;
+  for ( i = 0 ; i < 3 ; i ++ ) rho[i] = x[i] + (*h)*n[i] ;
+
+  *I = sP = 0.0 ;
+  if ( linear ) J[0] = J[1] = J[2] = 0.0 ;
+  for ( i = 0 ; i < 3 ; i ++ ) {
+    p = g->f[3*k+i] ; q = g->f[3*k+(i+1)%3] ;
+    s = &(g->s[9*k+3*i]) ; m = &(g->m[9*k+3*i]) ;
+    a[0] = g->v[3*p+0] - rho[0] ;
+    a[1] = g->v[3*p+1] - rho[1] ;
+    a[2] = g->v[3*p+2] - rho[2] ;
+    lm = vector_dot(a, s) ; lp = lm + g->L[3*k+i] ;
+    P0 = vector_dot(a, m) ;
+    R02 = P0*P0 + d*d ;
+    f = 0.0 ;
+    /*if x lies on the line of the edge, all the edge terms vanish*/
+    if ( R02 > INTEGRAL_EDGE_TOLERANCE*INTEGRAL_EDGE_TOLERANCE*
+	 g->L[3*k+i]*g->L[3*k+i] ) {
+      f = log(edge_log_argument(lp, R[q], R02)/
+	      edge_log_argument(lm, R[p], R02)) ;
+      *I += P0*f - d*(atan2(P0*lp, R02 + d*R[q]) -
+		      atan2(P0*lm, R02 + d*R[p])) ;
+    }
+    if ( !linear ) continue ;
+    /*integral of R along the edge*/
+    E = 0.5*(lp*R[q] - lm*R[p] + R02*f) ;
+    sP += P0*E ;
+    J[0] += m[0]*E ; J[1] += m[1]*E ; J[2] += m[2]*E ;
+  }
+
+  if ( !linear ) return ;
+
+  *Ip = (d*d*(*I) + sP)/3.0 ;
+  J[0] += (*h)*n[0]*(*I) ;
+  J[1] += (*h)*n[1]*(*I) ;
+  J[2] += (*h)*n[2]*(*I) ;
+
+  return ;
+}
+
+static void tet_potential(tet_geometry_t *g, const gdouble *sigma,
+			  gboolean linear, const gdouble *x,
+			  gdouble *phi, gdouble *grad)
+
+/*
+  add the potential and gradient at x of g with nodal densities sigma
+  (linear) or constant density sigma[0]
+*/
+
+{
+  gdouble R[4], h, I, Ip, J[3], pc, sx, gs[3], t ;
+  gint i, k ;
+
+  for ( i = 0 ; i < 4 ; i ++ )
+    R[i] = sqrt((g->v[3*i+0] - x[0])*(g->v[3*i+0] - x[0]) +
+		(g->v[3*i+1] - x[1])*(g->v[3*i+1] - x[1]) +
+		(g->v[3*i+2] - x[2])*(g->v[3*i+2] - x[2])) ;
+
+  if ( !linear ) {
+    for ( k = 0 ; k < 4 ; k ++ ) {
+      tet_face_integrals(g, k, x, R, FALSE, &h, &I, NULL, NULL) ;
+      *phi += 0.5*sigma[0]*h*I ;
+      if ( grad == NULL ) continue ;
+      grad[0] -= sigma[0]*g->n[3*k+0]*I ;
+      grad[1] -= sigma[0]*g->n[3*k+1]*I ;
+      grad[2] -= sigma[0]*g->n[3*k+2]*I ;
+    }
+    return ;
+  }
+
+  /*sigma(y) = sx + gs.(y-x), using grad lambda_k = -n_k A_k/3V*/
+  gs[0] = gs[1] = gs[2] = 0.0 ;
+  for ( k = 0 ; k < 4 ; k ++ ) {
+    t = -sigma[k]*g->A[k]/3.0/g->V ;
+    gs[0] += t*g->n[3*k+0] ; gs[1] += t*g->n[3*k+1] ; gs[2] += t*g->n[3*k+2] ;
+  }
+  sx = sigma[0] + gs[0]*(x[0] - g->v[0]) + gs[1]*(x[1] - g->v[1]) +
+    gs[2]*(x[2] - g->v[2]) ;
+
+  pc = 0.0 ;
+  for ( k = 0 ; k < 4 ; k ++ ) {
+    tet_face_integrals(g, k, x, R, TRUE, &h, &I, &Ip, J) ;
+    pc += 0.5*h*I ;
+    *phi += vector_dot(gs, &(g->n[3*k]))*Ip ;
+    if ( grad == NULL ) continue ;
+    t = sx*I + vector_dot(gs, J) ;
+    grad[0] -= g->n[3*k+0]*t ;
+    grad[1] -= g->n[3*k+1]*t ;
+    grad[2] -= g->n[3*k+2]*t ;
+  }
+  *phi += sx*pc ;
+  if ( grad == NULL ) return ;
+  grad[0] += gs[0]*pc ; grad[1] += gs[1]*pc ; grad[2] += gs[2]*pc ;
+
+  return ;
+}
+
+static void tetrahedron_pack(GtvTetrahedron *t, gdouble *v)
+
+{
+  GtsVertex *w[4] ;
+  gint i ;
+
+  gtv_tetrahedron_vertices(t, &(w[0]), &(w[1]), &(w[2]), &(w[3])) ;
+  for ( i = 0 ; i < 4 ; i ++ ) {
+    v[3*i+0] = GTS_POINT(w[i])->x ;
+    v[3*i+1] = GTS_POINT(w[i])->y ;
+    v[3*i+2] = GTS_POINT(w[i])->z ;
+  }
+
+  return ;
+}
+
+/**
+ * Potential and gradient of a tetrahedron with unit density,
+ * \f$\int_{T}1/|\mathbf{x}-\mathbf{y}|\,\mathrm{d}V\f$, evaluated in
+ * closed form.
+ *
+ * @param t a ::GtvTetrahedron;
+ * @param x field point;
+ * @param phi on exit, the potential at \a x;
+ * @param grad if not NULL, on exit the gradient of the potential at
+ * \a x.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_tetrahedron_potential(GtvTetrahedron *t, GtsPoint *x,
+			       gdouble *phi, gdouble *grad)
+
+{
+  tet_geometry_t g ;
+  gdouble v[12], y[3], s = 1.0 ;
+
+  g_return_val_if_fail(t != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(x != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(phi != NULL, GTV_NULL_ARGUMENT) ;
+
+  tetrahedron_pack(t, v) ;
+  tet_geometry(v, &g) ;
+  y[0] = x->x ; y[1] = x->y ; y[2] = x->z ;
+  *phi = 0.0 ;
+  if ( grad != NULL ) grad[0] = grad[1] = grad[2] = 0.0 ;
+  tet_potential(&g, &s, FALSE, y, phi, grad) ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Potential and gradient of a tetrahedron with a density which varies
+ * linearly between given values at its vertices, evaluated in closed
+ * form.
+ *
+ * @param t a ::GtvTetrahedron;
+ * @param sigma density at the vertices of \a t, in the order returned
+ * by ::gtv_tetrahedron_vertices;
+ * @param x field point;
+ * @param phi on exit, the potential at \a x;
+ * @param grad if not NULL, on exit the gradient of the potential at
+ * \a x.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_tetrahedron_potential_linear(GtvTetrahedron *t, gdouble *sigma,
+				      GtsPoint *x, gdouble *phi,
+				      gdouble *grad)
+
+{
+  tet_geometry_t g ;
+  gdouble v[12], y[3] ;
+
+  g_return_val_if_fail(t != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(sigma != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(x != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(phi != NULL, GTV_NULL_ARGUMENT) ;
+
+  tetrahedron_pack(t, v) ;
+  tet_geometry(v, &g) ;
+  y[0] = x->x ; y[1] = x->y ; y[2] = x->z ;
+  *phi = 0.0 ;
+  if ( grad != NULL ) grad[0] = grad[1] = grad[2] = 0.0 ;
+  tet_potential(&g, sigma, TRUE, y, phi, grad) ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Add the potentials and gradients of many tetrahedra at many points,
+ * with constant or linear densities. The tetrahedra are given by
+ * packed coordinates, twelve per tetrahedron, and may have either
+ * orientation. The result at each point is the sum over all of the
+ * tetrahedra.
+ *
+ * @param v vertex coordinates, x, y, z of the four vertices of each
+ * tetrahedron in turn;
+ * @param sigma densities: one per tetrahedron if \a ns is 1, or the
+ * densities at the four vertices of each tetrahedron if \a ns is 4;
+ * @param ns 1 for constant density, 4 for linear density;
+ * @param nt number of tetrahedra;
+ * @param x field points, three coordinates per point;
+ * @param nx number of field points;
+ * @param phi potential at each field point, to which the result is
+ * added;
+ * @param grad if not NULL, gradient of potential, three components
+ * per point, to which the result is added.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_tetrahedra_potentials(gdouble *v, gdouble *sigma, gint ns, gint nt,
+			       gdouble *x, gint nx, gdouble *phi,
+			       gdouble *grad)
+
+{
+  tet_geometry_t g ;
+  gint i, j ;
+
+  g_return_val_if_fail(v != NULL || nt == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(sigma != NULL || nt == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(ns == 1 || ns == 4, GTV_ARGUMENT_OUT_OF_RANGE) ;
+  g_return_val_if_fail(x != NULL || nx == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(phi != NULL || nx == 0, GTV_NULL_ARGUMENT) ;
+
+  for ( i = 0 ; i < nt ; i ++ ) {
+    if ( ns == 1 && sigma[i] == 0.0 ) continue ;
+    tet_geometry(&(v[12*i]), &g) ;
+    if ( grad == NULL ) {
+      for ( j = 0 ; j < nx ; j ++ )
+	tet_potential(&g, &(sigma[ns*i]), ns == 4, &(x[3*j]), &(phi[j]),
+		      NULL) ;
+      continue ;
+    }
+    for ( j = 0 ; j < nx ; j ++ )
+      tet_potential(&g, &(sigma[ns*i]), ns == 4, &(x[3*j]), &(phi[j]),
+		    &(grad[3*j])) ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * @}
+ *
+ */
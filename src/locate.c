@@ -32,14 +32,6 @@
 #include "gtv.h"
 #include "gtv-private.h"
 
-#define NEIGHBOURS_THROUGH_FACET(_t,_p,_f) \
-((_t != _p) && gtv_tetrahedron_has_facet(GTV_TETRAHEDRON(_p), _f))
-
-#define OUTSIDE_FACET(_v1,_v2,_v3,_v4,_D) \
-(( _D > 0.0 ? \
-	   (gts_point_orientation_3d(_v1, _v2, _v3, _v4) < 0.0) : \
-           (gts_point_orientation_3d(_v1, _v2, _v3, _v4) > 0.0) ))
-
 /**
  * @defgroup locate Point location in a volume
  * @{
@@ -80,7 +72,7 @@ static gboolean cell_distance(gpointer key, gpointer value,
   return (*i >= ns) ;
 }
 
-static GtvCell *random_closest_cell(GHashTable *h, GtsPoint *p) 
+GtvCell *random_closest_cell(GHashTable *h, GtsPoint *p)
 
 {
   gpointer data[8] ;
@@ -135,7 +127,7 @@ struct _GHashTable
 #  endif /* not 1.3.0 */
 #endif /* not 1.2.8 */
 
-static GtvCell *random_closest_cell(GHashTable *h, GtsPoint *p)
+GtvCell *random_closest_cell(GHashTable *h, GtsPoint *p)
 
 {
   GtvCell *closest, *test ;
@@ -168,39 +160,14 @@ static GtvCell *random_closest_cell(GHashTable *h, GtsPoint *p)
 
 /*end of Stephane Popinet's code*/
 
-static GtvFacet *random_facet(GtvTetrahedron *t,
-			      GtsPoint **v1,
-			      GtsPoint **v2,
-			      GtsPoint **v3,
-			      GtsPoint **v4)
-
-{
-  gint i ;
-  GtsVertex *w1, *w2, *w3, *w4 ;
-
-  g_assert(t != NULL) ;
-  gtv_tetrahedron_vertices(t, &w1, &w2, &w3, &w4) ;
-  i = random() ;
-  if ( i < RAND_MAX/4 ) {
-    *v1 = GTS_POINT(w1) ; *v2 = GTS_POINT(w2) ; 
-    *v3 = GTS_POINT(w3) ; *v4 = GTS_POINT(w4) ; 
-    return t->f1 ; 
-  }
-  if ( i < RAND_MAX/2 ) {
-    *v1 = GTS_POINT(w2) ; *v2 = GTS_POINT(w3) ; 
-    *v3 = GTS_POINT(w4) ; *v4 = GTS_POINT(w1) ; 
-    return t->f2 ; 
-  }
-  if ( i < RAND_MAX/4*3 ) {
-    *v1 = GTS_POINT(w3) ; *v2 = GTS_POINT(w4) ; 
-    *v3 = GTS_POINT(w1) ; *v4 = GTS_POINT(w2) ; 
-    return t->f3 ; 
-  }
-
-  *v1 = GTS_POINT(w4) ; *v2 = GTS_POINT(w1) ; 
-  *v3 = GTS_POINT(w2) ; *v4 = GTS_POINT(w3) ; 
-  return t->f4 ; 
-}
+/*
+  xorshift generator (Marsaglia, G., `Xorshift RNGs', Journal of
+  Statistical Software 8(14), 2003) for the stochastic walk, with its
+  state held by the caller; the state must not be zero
+*/
+#define locate_random(_s)					\
+  ((*(_s)) ^= (*(_s)) << 13, (*(_s)) ^= (*(_s)) >> 17,		\
+   (*(_s)) ^= (*(_s)) << 5)
 
 #if GLIB_CHECK_VERSION(2,4,0)
 
@@ -294,16 +261,95 @@ GtvCell *gtv_point_locate_slow(GtsPoint *p, GtvVolume *volume,
   return t ;
 }
 
-static inline GtvFacet *next_facet(GtvTetrahedron *t, GtvFacet *f)
+static gint sequence_parity(gdouble **s, gdouble **u)
+
+/*sign of the permutation taking s to u, each four distinct pointers*/
+
+{
+  gint i, j, k[4] = {0, 0, 0, 0}, n ;
+
+  for ( i = 0 ; i < 4 ; i ++ )
+    for ( j = 0 ; j < 4 ; j ++ ) if ( u[i] == s[j] ) k[i] = j ;
+
+  for ( (i = 0), (n = 0) ; i < 4 ; i ++ )
+    for ( j = i+1 ; j < 4 ; j ++ ) if ( k[i] > k[j] ) n ++ ;
+
+  return (n % 2 == 0 ? 1 : -1) ;
+}
+
+void locate_walk_init(locate_walk_t *w, GtvVolume *volume, GtvCell *t)
 
 {
-  if ( f == t->f1 ) return t->f2 ;
-  if ( f == t->f2 ) return t->f3 ;
-  if ( f == t->f3 ) return t->f4 ;
-  if ( f == t->f4 ) return t->f1 ;
+  GtsVertex *v[4] ;
+  gint i ;
 
-  g_assert_not_reached() ;
-  return NULL ;
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(t), &v[0], &v[1], &v[2], &v[3]) ;
+  for ( i = 0 ; i < 4 ; i ++ ) w->x[i] = &(GTS_POINT(v[i])->x) ;
+  w->sgn = (gtv_orient3d(w->x[0], w->x[1], w->x[2], w->x[3]) > 0.0 ?
+	    1 : -1) ;
+  w->volume = volume ; w->t = t ; w->in = -1 ;
+
+  return ;
+}
+
+gint locate_walk_step(locate_walk_t *w, GtsPoint *p, gint k0)
+
+/*
+  index of the first facet of w->t, starting from k0, which p lies
+  strictly outside, with its orientation test left in w->o, or -1 if
+  p lies in w->t; the facet the walk entered through is not tested
+  again, since p is known to lie on its inner side
+*/
+
+{
+  gdouble *y ;
+  gint i, k ;
+
+  for ( i = 0 ; i < 4 ; i ++ ) {
+    k = (k0 + i) % 4 ;
+    if ( k == w->in ) continue ;
+    /*p is outside the facet opposite vertex k if putting p in its
+      place reverses the orientation*/
+    y = w->x[k] ; w->x[k] = &(p->x) ;
+    w->o = gtv_orient3d(w->x[0], w->x[1], w->x[2], w->x[3]) ;
+    w->x[k] = y ;
+    if ( w->sgn*w->o < 0.0 ) return k ;
+  }
+
+  return -1 ;
+}
+
+void locate_walk_cross(locate_walk_t *w, GtsPoint *p, gint k)
+
+/*
+  move w across facet k, returned by locate_walk_step, to the
+  neighbouring cell; the orientation of the new cell is not
+  evaluated: the test which took the walk across facet k is of the
+  same four points as the new cell with p in place of the vertex
+  opposite the facet, which lies on the same side as p
+*/
+
+{
+  GtvCell *n ;
+  GtsVertex *v[4] ;
+  gdouble *y[4] ;
+  gint i, m ;
+
+  n = cell_neighbour(w->t, w->volume, k) ;
+  g_assert(n != NULL) ;
+  m = tetrahedron_facet_slot(GTV_TETRAHEDRON(n),
+			     tetrahedron_facet(GTV_TETRAHEDRON(w->t), k)) ;
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(n), &v[0], &v[1], &v[2], &v[3]) ;
+  for ( i = 0 ; i < 4 ; i ++ ) y[i] = &(GTS_POINT(v[i])->x) ;
+
+  w->x[k] = &(p->x) ; y[m] = &(p->x) ;
+  w->sgn = (w->o > 0.0 ? 1 : -1)*sequence_parity(w->x, y) ;
+  y[m] = &(GTS_POINT(v[m])->x) ;
+
+  for ( i = 0 ; i < 4 ; i ++ ) w->x[i] = y[i] ;
+  w->t = n ; w->in = m ;
+
+  return ;
 }
 
 /** 
@@ -313,7 +359,12 @@ static inline GtvFacet *next_facet(GtvTetrahedron *t, GtvFacet *f)
  * href="http://hal.inria.fr/docs/00/10/21/94/PDF/hal.pdf">`Walking in
  * a triangulation'</a>, International Journal of Foundations in
  * Computer Science, 13:181--199). Note that at present this will not
- * work for volumes with holes in their interior.
+ * work for volumes with holes in their interior. The random choices
+ * of the walk are made by a generator local to the call, started
+ * from the seed of \a volume (see ::gtv_volume_set_seed), so the
+ * result is reproducible and calls may be made from several threads
+ * at once. If \a guess is NULL, the walk starts from the locate grid
+ * of \a volume, if it has one (see ::gtv_volume_locate_grid).
  * 
  * @param p a GtsPoint to locate;
  * @param volume a ::GtvVolume;
@@ -327,11 +378,10 @@ static inline GtvFacet *next_facet(GtvTetrahedron *t, GtvFacet *f)
 GtvCell *gtv_point_locate(GtsPoint *p, GtvVolume *volume, GtvCell *guess)
 
 {
-  GtvCell *t = NULL, *previous ;
-  GtvFacet *f ;
-  GtsPoint *v1, *v2, *v3, *v4 ;
-  gdouble D ;
-  gboolean stop ;
+  GtvCell *t = NULL ;
+  locate_walk_t w ;
+  gint k ;
+  guint32 state ;
 
   g_return_val_if_fail(p != NULL, NULL) ;
   g_return_val_if_fail(GTS_IS_POINT(p), NULL) ;
@@ -344,52 +394,387 @@ GtvCell *gtv_point_locate(GtsPoint *p, GtvVolume *volume, GtvCell *guess)
   if ( guess != NULL ) 
     t = guess ;
   else
-    t = random_closest_cell(volume->cells, p) ;
-
-  stop = FALSE ; previous = t ;
-
-  while ( !stop ) {
-    f = random_facet(GTV_TETRAHEDRON(t), &v1, &v2, &v3, &v4) ;
-    D = gts_point_orientation_3d(GTS_POINT(v1), GTS_POINT(v2),
-				 GTS_POINT(v3), GTS_POINT(v4)) ;
-    if ( !NEIGHBOURS_THROUGH_FACET(t, previous, f) &&
-	 OUTSIDE_FACET(p, v2, v3, v4, D) ) {
-      previous = t ;
-      t = GTV_CELL(gtv_tetrahedron_opposite(GTV_TETRAHEDRON(t), f)) ;
-      if ( t == NULL ) stop = TRUE ;
-    } else {
-      f = next_facet(GTV_TETRAHEDRON(t), f) ;
-      if ( !NEIGHBOURS_THROUGH_FACET(t, previous, f) &&
-	   OUTSIDE_FACET(v1, p, v3, v4, D) ) {
-	previous = t ;
-	t = GTV_CELL(gtv_tetrahedron_opposite(GTV_TETRAHEDRON(t), f)) ;
-	if ( t == NULL ) stop = TRUE ;
-      } else {
-	f = next_facet(GTV_TETRAHEDRON(t), f) ;
-	if ( !NEIGHBOURS_THROUGH_FACET(t, previous, f) &&
-	     OUTSIDE_FACET(v1, v2, p, v4, D) ) {
-	  previous = t ;
-	  t = GTV_CELL(gtv_tetrahedron_opposite(GTV_TETRAHEDRON(t), f)) ;
-	  if ( t == NULL ) stop = TRUE ;
-	} else {
-	  f = next_facet(GTV_TETRAHEDRON(t), f) ;
-	  if ( !NEIGHBOURS_THROUGH_FACET(t, previous, f) &&
-	       OUTSIDE_FACET(v1, v2, v3, p, D) ) {
-	    previous = t ;
-	    t = GTV_CELL(gtv_tetrahedron_opposite(GTV_TETRAHEDRON(t), f)) ;
-	    if ( t == NULL ) stop = TRUE ;
-	  } else 
-	    stop = TRUE ;
+    t = locate_start_cell(volume, p) ;
+  if ( t == NULL ) return NULL ;
+
+  state = (volume->seed != 0 ? volume->seed : GTV_LOCATE_SEED) ;
+
+  locate_walk_init(&w, volume, t) ;
+  /*the high bits of a xorshift generator are the better ones*/
+  while ( (k = locate_walk_step(&w, p, locate_random(&state) >> 30)) >= 0 ) {
+    if ( cell_neighbour(w.t, volume, k) == NULL ) return NULL ;
+    locate_walk_cross(&w, p, k) ;
+  }
+  t = w.t ;
+
+#ifdef GTV_DEVELOPER_DEBUG
+  g_assert( gtv_point_in_tetrahedron(GTS_POINT(p), 
+				     GTV_TETRAHEDRON(t), NULL) != GTV_OUT ) ;
+#endif /*GTV_DEVELOPER_DEBUG*/
+
+  return t ;
+}
+
+typedef struct {
+  guint64 key ;
+  gint i ;
+} locate_entry_t ;
+
+static gint locate_compare(gconstpointer a, gconstpointer b)
+
+{
+  const locate_entry_t *e1 = a, *e2 = b ;
+
+  if ( e1->key < e2->key ) return -1 ;
+  if ( e1->key > e2->key ) return  1 ;
+
+  return 0 ;
+}
+
+typedef struct {
+  GtvVolume *v ;
+  const gdouble *xyz ;
+  locate_entry_t *e ;
+  gint i0, i1 ;
+  GtvCell **out ;
+  gint n ;
+} locate_batch_t ;
+
+static gpointer locate_batch(locate_batch_t *b)
+
+/*locate sorted points i0 to i1-1, each walk starting from the cell
+  of the last point found*/
+
+{
+  GtvCell *guess ;
+  GtsPoint *p ;
+  const gdouble *x ;
+  gint i ;
+
+  p = gts_point_new(gts_point_class(), 0.0, 0.0, 0.0) ;
+  guess = NULL ; b->n = 0 ;
+  for ( i = b->i0 ; i < b->i1 ; i ++ ) {
+    x = &(b->xyz[3*b->e[i].i]) ;
+    gts_point_set(p, x[0], x[1], x[2]) ;
+    b->out[b->e[i].i] = gtv_point_locate(p, b->v, guess) ;
+    if ( b->out[b->e[i].i] == NULL ) continue ;
+    guess = b->out[b->e[i].i] ; b->n ++ ;
+  }
+  gts_object_destroy(GTS_OBJECT(p)) ;
+
+  return NULL ;
+}
+
+/**
+ * Locate many points in a ::GtvVolume. The points are sorted along a
+ * Hilbert curve and located in that order with ::gtv_point_locate,
+ * each walk starting from the cell found for the point before, so
+ * that a walk is usually only a few steps long and the cost of
+ * finding a starting cell is paid once per thread rather than once
+ * per point. The sorted points are split into contiguous blocks, one
+ * per thread. If GLib is older than 2.32, the points are located
+ * serially.
+ *
+ * @param v a ::GtvVolume;
+ * @param xyz coordinates of points, three per point;
+ * @param n number of points;
+ * @param out on exit, out[i] is a ::GtvCell containing point \a i, or
+ * NULL if the point is not in \a v;
+ * @param n_threads number of threads to use.
+ *
+ * @return the number of points found in \a v.
+ */
+
+gint gtv_point_locate_many(GtvVolume *v, const gdouble *xyz, gint n,
+			   GtvCell **out, gint n_threads)
+
+{
+  locate_entry_t *e ;
+  locate_batch_t *b ;
+  gdouble xmin[3], xmax[3], scale ;
+  guint32 x[3] ;
+  gint i, j, nf ;
+#if GLIB_CHECK_VERSION(2,32,0)
+  GThread **threads ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  g_return_val_if_fail(v != NULL, 0) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), 0) ;
+  g_return_val_if_fail(xyz != NULL || n == 0, 0) ;
+  g_return_val_if_fail(out != NULL || n == 0, 0) ;
+  g_return_val_if_fail(n_threads > 0, 0) ;
+
+  if ( n <= 0 ) return 0 ;
+
+  xmin[0] = xmin[1] = xmin[2] =  G_MAXDOUBLE ;
+  xmax[0] = xmax[1] = xmax[2] = -G_MAXDOUBLE ;
+  for ( i = 0 ; i < n ; i ++ ) {
+    for ( j = 0 ; j < 3 ; j ++ ) {
+      xmin[j] = MIN(xmin[j], xyz[3*i+j]) ;
+      xmax[j] = MAX(xmax[j], xyz[3*i+j]) ;
+    }
+  }
+  scale = MAX(xmax[0]-xmin[0], MAX(xmax[1]-xmin[1], xmax[2]-xmin[2])) ;
+  if ( scale > 0.0 ) scale = ((1 << HILBERT_BITS) - 1)/scale ;
+
+  e = g_new(locate_entry_t, n) ;
+  for ( i = 0 ; i < n ; i ++ ) {
+    for ( j = 0 ; j < 3 ; j ++ )
+      x[j] = (guint32)((xyz[3*i+j] - xmin[j])*scale) ;
+    e[i].key = hilbert_key(x) ; e[i].i = i ;
+  }
+  qsort(e, n, sizeof(locate_entry_t), locate_compare) ;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  n_threads = MIN(n_threads, n) ;
+#else
+  n_threads = 1 ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  b = g_new0(locate_batch_t, n_threads) ;
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    b[j].v = v ; b[j].xyz = xyz ; b[j].e = e ; b[j].out = out ;
+    b[j].i0 = (gint)((gint64)n*j/n_threads) ;
+    b[j].i1 = (gint)((gint64)n*(j+1)/n_threads) ;
+  }
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  threads = g_new(GThread *, n_threads) ;
+  for ( j = 1 ; j < n_threads ; j ++ )
+    threads[j] = g_thread_new(NULL, (GThreadFunc)locate_batch, &(b[j])) ;
+  locate_batch(&(b[0])) ;
+  for ( j = 1 ; j < n_threads ; j ++ ) g_thread_join(threads[j]) ;
+  g_free(threads) ;
+#else
+  locate_batch(&(b[0])) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  for ( (nf = 0), (j = 0) ; j < n_threads ; j ++ ) nf += b[j].n ;
+
+  g_free(b) ; g_free(e) ;
+
+  return nf ;
+}
+
+/*search this many rings of boxes around an empty box of a locate
+  grid before giving up*/
+#define LOCATE_GRID_RINGS 2
+
+static gint locate_grid_index(locate_grid_t *g, gdouble *x)
+
+{
+  gint i, j[3] ;
+
+  for ( i = 0 ; i < 3 ; i ++ ) {
+    j[i] = (gint)floor((x[i] - g->x0[i])/g->h) ;
+    j[i] = CLAMP(j[i], 0, g->n[i]-1) ;
+  }
+
+  return (j[2]*g->n[1] + j[1])*g->n[0] + j[0] ;
+}
+
+static void cell_centroid(GtvCell *c, gdouble *x)
+
+{
+  GtsVertex *v1, *v2, *v3, *v4 ;
+
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &v1, &v2, &v3, &v4) ;
+  x[0] = 0.25*(GTS_POINT(v1)->x + GTS_POINT(v2)->x +
+	       GTS_POINT(v3)->x + GTS_POINT(v4)->x) ;
+  x[1] = 0.25*(GTS_POINT(v1)->y + GTS_POINT(v2)->y +
+	       GTS_POINT(v3)->y + GTS_POINT(v4)->y) ;
+  x[2] = 0.25*(GTS_POINT(v1)->z + GTS_POINT(v2)->z +
+	       GTS_POINT(v3)->z + GTS_POINT(v4)->z) ;
+
+  return ;
+}
+
+void locate_grid_insert(GtvVolume *v, GtvCell *c)
+
+/*make c the cell of the box containing its centroid*/
+
+{
+  locate_grid_t *g = (locate_grid_t *)(v->grid) ;
+  gdouble x[3] ;
+
+  cell_centroid(c, x) ;
+  g->c[locate_grid_index(g, x)] = c ;
+
+  return ;
+}
+
+void locate_grid_remove(GtvVolume *v, GtvCell *c)
+
+{
+  locate_grid_t *g = (locate_grid_t *)(v->grid) ;
+  gdouble x[3] ;
+  gint i ;
+
+  cell_centroid(c, x) ;
+  i = locate_grid_index(g, x) ;
+  if ( g->c[i] == c ) g->c[i] = NULL ;
+
+  return ;
+}
+
+void locate_grid_free(GtvVolume *v)
+
+{
+  locate_grid_t *g = (locate_grid_t *)(v->grid) ;
+
+  if ( g == NULL ) return ;
+
+  g_free(g->c) ; g_free(g) ;
+  v->grid = NULL ;
+
+  return ;
+}
+
+GtvCell *locate_start_cell(GtvVolume *v, GtsPoint *p)
+
+/*
+  a cell to start a walk to p: the cell of the box of the locate grid
+  containing p, or of the nearest non-empty box within a few rings,
+  falling back to a sample of the cells
+*/
+
+{
+  locate_grid_t *g = (locate_grid_t *)(v->grid) ;
+  GtvCell *c ;
+  gdouble x[3] ;
+  gint i, j[3], k[3], r ;
+
+  if ( g == NULL ) return random_closest_cell(v->cells, p) ;
+
+  x[0] = p->x ; x[1] = p->y ; x[2] = p->z ;
+  if ( (c = g->c[locate_grid_index(g, x)]) != NULL ) return c ;
+
+  for ( i = 0 ; i < 3 ; i ++ ) {
+    j[i] = (gint)floor((x[i] - g->x0[i])/g->h) ;
+    j[i] = CLAMP(j[i], 0, g->n[i]-1) ;
+  }
+  for ( r = 1 ; r <= LOCATE_GRID_RINGS ; r ++ ) {
+    for ( k[2] = MAX(0, j[2]-r) ; k[2] <= MIN(g->n[2]-1, j[2]+r) ; k[2] ++ ) {
+      for ( k[1] = MAX(0, j[1]-r) ; k[1] <= MIN(g->n[1]-1, j[1]+r) ; 
+	    k[1] ++ ) {
+	for ( k[0] = MAX(0, j[0]-r) ; k[0] <= MIN(g->n[0]-1, j[0]+r) ; 
+	      k[0] ++ ) {
+	  /*only the boxes on ring r*/
+	  if ( ABS(k[0]-j[0]) != r && ABS(k[1]-j[1]) != r &&
+	       ABS(k[2]-j[2]) != r ) continue ;
+	  c = g->c[(k[2]*g->n[1] + k[1])*g->n[0] + k[0]] ;
+	  if ( c != NULL ) return c ;
 	}
       }
     }
   }
 
-  if ( t != NULL ) 
-    g_assert( gtv_point_in_tetrahedron(GTS_POINT(p), 
-				       GTV_TETRAHEDRON(t), NULL) != GTV_OUT ) ;
+  return random_closest_cell(v->cells, p) ;
+}
 
-  return t ;
+static gint grid_add_cell(GtvCell *c, GtvVolume *v)
+
+{
+  locate_grid_insert(v, c) ;
+
+  return GTV_SUCCESS ;
+}
+
+static gint grid_bound_cell(GtvCell *c, gdouble *b)
+
+{
+  GtsVertex *w[4] ;
+  gint i ;
+
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c),
+			   &(w[0]), &(w[1]), &(w[2]), &(w[3])) ;
+  for ( i = 0 ; i < 4 ; i ++ ) {
+    b[0] = MIN(b[0], GTS_POINT(w[i])->x) ;
+    b[1] = MIN(b[1], GTS_POINT(w[i])->y) ;
+    b[2] = MIN(b[2], GTS_POINT(w[i])->z) ;
+    b[3] = MAX(b[3], GTS_POINT(w[i])->x) ;
+    b[4] = MAX(b[4], GTS_POINT(w[i])->y) ;
+    b[5] = MAX(b[5], GTS_POINT(w[i])->z) ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Attach a locate grid to a ::GtvVolume, to give ::gtv_point_locate a
+ * starting cell close to the point sought when it is not given a
+ * guess (`jump and walk'). The grid is a uniform array of boxes over
+ * the bounding box of the volume, each holding one cell whose
+ * centroid lies in it. It is kept up to date as cells are added to
+ * and removed from the volume, for example by Delaunay insertion, but
+ * its extent is fixed when it is made, so for a volume which will be
+ * refined, \a n should be chosen for the final number of cells. A grid
+ * already attached to \a v is replaced.
+ *
+ * @param v a ::GtvVolume;
+ * @param n approximate number of boxes in the grid, or 0 for one box
+ * for every eight cells of \a v.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_volume_locate_grid(GtvVolume *v, guint n)
+
+{
+  locate_grid_t *g ;
+  gdouble b[6], len ;
+  gint i ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+
+  locate_grid_free(v) ;
+  if ( n == 0 ) n = MAX(1, gtv_volume_cell_number(v)/8) ;
+
+  b[0] = b[1] = b[2] =  G_MAXDOUBLE ;
+  b[3] = b[4] = b[5] = -G_MAXDOUBLE ;
+  gtv_volume_foreach_cell(v, (GtsFunc)grid_bound_cell, b) ;
+  if ( b[0] > b[3] ) b[0] = b[1] = b[2] = b[3] = b[4] = b[5] = 0.0 ;
+
+  /*boxes are cubes, sized to give about n of them*/
+  len = MAX(b[3]-b[0], MAX(b[4]-b[1], b[5]-b[2])) ;
+  g = g_new(locate_grid_t, 1) ;
+  g->h = (b[3]-b[0])*(b[4]-b[1])*(b[5]-b[2]) ;
+  g->h = (g->h > 0.0 ? cbrt(g->h/n) : len/n) ;
+  if ( g->h <= 0.0 ) g->h = 1.0 ;
+  for ( i = 0 ; i < 3 ; i ++ ) {
+    g->x0[i] = b[i] ;
+    g->n[i] = MAX(1, (gint)ceil((b[i+3]-b[i])/g->h)) ;
+  }
+  g->c = g_new0(GtvCell *, g->n[0]*g->n[1]*g->n[2]) ;
+  v->grid = g ;
+
+  gtv_volume_foreach_cell(v, (GtsFunc)grid_add_cell, v) ;
+
+  g_debug("%s: %dx%dx%d grid, box size %lg", __FUNCTION__,
+	  g->n[0], g->n[1], g->n[2], g->h) ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Remove the locate grid, if any, from a ::GtvVolume (see
+ * ::gtv_volume_locate_grid).
+ *
+ * @param v a ::GtvVolume.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_volume_locate_grid_clear(GtvVolume *v)
+
+{
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+
+  locate_grid_free(v) ;
+
+  return GTV_SUCCESS ;
 }
 
 /**
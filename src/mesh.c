@@ -0,0 +1,680 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @defgroup mesh Compact meshes
+ *
+ * A ::GtvMesh is an index-based copy of a tetrahedralization, with
+ * vertex coordinates and cell connectivity held in flat arrays. It
+ * takes a few tens of bytes per cell, against several hundred for the
+ * ::GtvVolume object graph, and can be converted to and from a
+ * ::GtvVolume. Cell vertices are stored in the order of
+ * ::gtv_tetrahedron_vertices, and neighbour \a j of a cell is the
+ * cell on the other side of the facet opposite vertex \a j, or -1 on
+ * the boundary.
+ *
+ * A ::GtvMesh can be written to and read from a versioned binary
+ * file. The file has a 64-byte header followed by the arrays of the
+ * mesh as they are held in memory. It can be mapped read-only to give
+ * a ::GtvMesh view with no copying or parsing. The header holds:
+ *
+ * - bytes 0--3: "GTVB";
+ * - bytes 4--7: format version (::GTV_MESH_BINARY_VERSION);
+ * - bytes 8--11: 0x01020304, to check the byte order of the writer;
+ * - bytes 12--15: flags: 1 if neighbours are stored, 2 if cell
+ * attributes are stored;
+ * - bytes 16--23: number of vertices, 64-bit;
+ * - bytes 24--31: number of cells, 64-bit;
+ * - bytes 32--35: number of attributes per cell;
+ *
+ * and the rest is zero. Then come 3 doubles per vertex, 4 32-bit
+ * vertex indices per cell, 4 32-bit neighbour indices per cell if
+ * stored, and the cell attributes as doubles if stored, all in the
+ * byte order of the writer.
+ *
+ * @{
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <gts.h>
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+#define MESH_BINARY_HEADER_SIZE 64
+#define MESH_BINARY_BYTE_ORDER  0x01020304
+#define MESH_BINARY_NEIGHBOURS  (1 << 0)
+#define MESH_BINARY_ATTRIBUTES  (1 << 1)
+
+typedef struct {
+  gint32 v[3], id ;
+} mesh_facet_t ;
+
+/**
+ * Allocate a new empty ::GtvMesh.
+ *
+ * @param nv initial number of vertices to allocate space for;
+ * @param nc initial number of cells to allocate space for.
+ *
+ * @return a pointer to the new ::GtvMesh.
+ */
+
+GtvMesh *gtv_mesh_new(gint32 nv, gint32 nc)
+
+{
+  GtvMesh *m ;
+
+  g_return_val_if_fail(nv >= 0, NULL) ;
+  g_return_val_if_fail(nc >= 0, NULL) ;
+
+  m = g_new0(GtvMesh, 1) ;
+
+  m->nvmax = MAX(nv, 16) ; m->ncmax = MAX(nc, 16) ;
+  m->x = g_new(gdouble, 3*m->nvmax) ;
+  m->cells = g_new(gint32, 4*m->ncmax) ;
+  m->neighbours = g_new(gint32, 4*m->ncmax) ;
+
+  return m ;
+}
+
+/**
+ * Free a ::GtvMesh and its data, or unmap it if it is a view of a
+ * binary file.
+ *
+ * @param m a ::GtvMesh.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_mesh_free(GtvMesh *m)
+
+{
+  g_return_val_if_fail(m != NULL, GTV_NULL_ARGUMENT) ;
+
+  if ( m->map != NULL ) {
+#if GLIB_CHECK_VERSION(2,22,0)
+    g_mapped_file_unref((GMappedFile *)(m->map)) ;
+#elif GLIB_CHECK_VERSION(2,8,0)
+    g_mapped_file_free((GMappedFile *)(m->map)) ;
+#endif /*GLIB_CHECK_VERSION*/
+    g_free(m) ;
+    return GTV_SUCCESS ;
+  }
+
+  g_free(m->x) ; g_free(m->cells) ; g_free(m->neighbours) ;
+  g_free(m->attributes) ;
+  g_free(m) ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Append a vertex to a ::GtvMesh.
+ *
+ * @param m a ::GtvMesh;
+ * @param x coordinate of vertex;
+ * @param y coordinate of vertex;
+ * @param z coordinate of vertex.
+ *
+ * @return index of the new vertex in \a m, or -1 on error.
+ */
+
+gint32 gtv_mesh_vertex_add(GtvMesh *m, gdouble x, gdouble y, gdouble z)
+
+{
+  g_return_val_if_fail(m != NULL, -1) ;
+  g_return_val_if_fail(m->map == NULL, -1) ;
+
+  if ( m->nv == m->nvmax ) {
+    m->nvmax *= 2 ;
+    m->x = g_renew(gdouble, m->x, 3*m->nvmax) ;
+  }
+
+  m->x[3*m->nv+0] = x ; m->x[3*m->nv+1] = y ; m->x[3*m->nv+2] = z ;
+
+  return m->nv ++ ;
+}
+
+/**
+ * Append a cell to a ::GtvMesh. The neighbours of the new cell are
+ * set to -1: call ::gtv_mesh_neighbours to connect it to the rest of
+ * the mesh. Its attributes, if any, are set to zero.
+ *
+ * @param m a ::GtvMesh;
+ * @param v1 index of first vertex;
+ * @param v2 index of second vertex;
+ * @param v3 index of third vertex;
+ * @param v4 index of fourth vertex.
+ *
+ * @return index of the new cell in \a m, or -1 on error.
+ */
+
+gint32 gtv_mesh_cell_add(GtvMesh *m, gint32 v1, gint32 v2, gint32 v3,
+			 gint32 v4)
+
+{
+  gint32 *c ;
+
+  g_return_val_if_fail(m != NULL, -1) ;
+  g_return_val_if_fail(m->map == NULL, -1) ;
+  g_return_val_if_fail(v1 >= 0 && v1 < m->nv, -1) ;
+  g_return_val_if_fail(v2 >= 0 && v2 < m->nv, -1) ;
+  g_return_val_if_fail(v3 >= 0 && v3 < m->nv, -1) ;
+  g_return_val_if_fail(v4 >= 0 && v4 < m->nv, -1) ;
+
+  if ( m->nc == m->ncmax ) {
+    m->ncmax *= 2 ;
+    m->cells = g_renew(gint32, m->cells, 4*m->ncmax) ;
+    m->neighbours = g_renew(gint32, m->neighbours, 4*m->ncmax) ;
+    if ( m->na > 0 )
+      m->attributes = g_renew(gdouble, m->attributes, m->na*m->ncmax) ;
+  }
+
+  c = gtv_mesh_cell(m, m->nc) ;
+  c[0] = v1 ; c[1] = v2 ; c[2] = v3 ; c[3] = v4 ;
+  c = &(m->neighbours[4*m->nc]) ;
+  c[0] = c[1] = c[2] = c[3] = -1 ;
+  if ( m->na > 0 )
+    memset(gtv_mesh_cell_attributes(m, m->nc), 0, m->na*sizeof(gdouble)) ;
+
+  return m->nc ++ ;
+}
+
+/**
+ * Allocate space for attributes of the cells of a ::GtvMesh. Any
+ * existing attributes are discarded and all are set to zero.
+ *
+ * @param m a ::GtvMesh;
+ * @param na number of attributes per cell.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_mesh_attributes_alloc(GtvMesh *m, gint32 na)
+
+{
+  g_return_val_if_fail(m != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(m->map == NULL, GTV_FAILURE) ;
+  g_return_val_if_fail(na >= 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+  g_free(m->attributes) ;
+  m->na = na ; m->attributes = NULL ;
+  if ( na > 0 ) m->attributes = g_new0(gdouble, na*m->ncmax) ;
+
+  return GTV_SUCCESS ;
+}
+
+static gint facet_compare(gconstpointer a, gconstpointer b)
+
+{
+  const mesh_facet_t *f1 = a, *f2 = b ;
+
+  if ( f1->v[0] != f2->v[0] ) return (f1->v[0] < f2->v[0] ? -1 : 1) ;
+  if ( f1->v[1] != f2->v[1] ) return (f1->v[1] < f2->v[1] ? -1 : 1) ;
+  if ( f1->v[2] != f2->v[2] ) return (f1->v[2] < f2->v[2] ? -1 : 1) ;
+
+  return 0 ;
+}
+
+static void facet_sort_vertices(gint32 *v)
+
+{
+  gint32 t ;
+
+  if ( v[0] > v[1] ) { t = v[0] ; v[0] = v[1] ; v[1] = t ; }
+  if ( v[1] > v[2] ) { t = v[1] ; v[1] = v[2] ; v[2] = t ; }
+  if ( v[0] > v[1] ) { t = v[0] ; v[0] = v[1] ; v[1] = t ; }
+
+  return ;
+}
+
+static mesh_facet_t *mesh_facet_table(GtvMesh *m)
+
+/*
+  facets of all cells of m, each with its vertex indices sorted, and
+  sorted on those so that the copies of a shared facet are adjacent;
+  the id of a facet is 4*cell + j, where j is the vertex it is
+  opposite
+*/
+
+{
+  mesh_facet_t *f ;
+  gint32 i, j, *c ;
+
+  f = g_new(mesh_facet_t, 4*m->nc) ;
+
+  for ( i = 0 ; i < m->nc ; i ++ ) {
+    c = gtv_mesh_cell(m, i) ;
+    for ( j = 0 ; j < 4 ; j ++ ) {
+      f[4*i+j].v[0] = c[(j+1)%4] ;
+      f[4*i+j].v[1] = c[(j+2)%4] ;
+      f[4*i+j].v[2] = c[(j+3)%4] ;
+      facet_sort_vertices(f[4*i+j].v) ;
+      f[4*i+j].id = 4*i+j ;
+    }
+  }
+
+  qsort(f, 4*m->nc, sizeof(mesh_facet_t), facet_compare) ;
+
+  return f ;
+}
+
+/**
+ * Compute the cell neighbours of a ::GtvMesh from its cell vertices,
+ * by sorting the facets of all cells on their vertex indices and
+ * matching equal pairs.
+ *
+ * @param m a ::GtvMesh.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_mesh_neighbours(GtvMesh *m)
+
+{
+  mesh_facet_t *f ;
+  gint32 k ;
+
+  g_return_val_if_fail(m != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(m->map == NULL, GTV_FAILURE) ;
+
+  f = mesh_facet_table(m) ;
+
+  for ( k = 0 ; k < 4*m->nc ; k ++ ) m->neighbours[k] = -1 ;
+
+  for ( k = 0 ; k < 4*m->nc - 1 ; k ++ ) {
+    if ( facet_compare(&(f[k]), &(f[k+1])) != 0 ) continue ;
+    m->neighbours[f[k].id] = f[k+1].id/4 ;
+    m->neighbours[f[k+1].id] = f[k].id/4 ;
+    if ( k < 4*m->nc - 2 && facet_compare(&(f[k]), &(f[k+2])) == 0 )
+      g_debug("%s: facet (%d,%d,%d) shared by more than two cells",
+	      __FUNCTION__, f[k].v[0], f[k].v[1], f[k].v[2]) ;
+    k ++ ;
+  }
+
+  g_free(f) ;
+
+  return GTV_SUCCESS ;
+}
+
+static void mesh_add_vertex(GtsVertex *v, gpointer *data)
+
+{
+  GHashTable *h = (GHashTable *)data[0] ;
+  GtvMesh *m = (GtvMesh *)data[1] ;
+  gint32 i ;
+
+  i = gtv_mesh_vertex_add(m, GTS_POINT(v)->x, GTS_POINT(v)->y,
+			  GTS_POINT(v)->z) ;
+  g_hash_table_insert(h, v, GINT_TO_POINTER(i)) ;
+
+  return ;
+}
+
+static void mesh_add_cell(GtvCell *c, gpointer *data)
+
+{
+  GHashTable *h = (GHashTable *)data[0] ;
+  GtvMesh *m = (GtvMesh *)data[1] ;
+  GtsVertex *v1, *v2, *v3, *v4 ;
+
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &v1, &v2, &v3, &v4) ;
+
+  gtv_mesh_cell_add(m,
+		    GPOINTER_TO_INT(g_hash_table_lookup(h, v1)),
+		    GPOINTER_TO_INT(g_hash_table_lookup(h, v2)),
+		    GPOINTER_TO_INT(g_hash_table_lookup(h, v3)),
+		    GPOINTER_TO_INT(g_hash_table_lookup(h, v4))) ;
+
+  return ;
+}
+
+/**
+ * Make a ::GtvMesh from the vertices and cells of a ::GtvVolume.
+ *
+ * @param v a ::GtvVolume.
+ *
+ * @return a new ::GtvMesh with the same vertices and cells as \a v,
+ * and its neighbours set.
+ */
+
+GtvMesh *gtv_mesh_from_volume(GtvVolume *v)
+
+{
+  GtvMesh *m ;
+  GHashTable *h ;
+  gpointer data[2] ;
+
+  g_return_val_if_fail(v != NULL, NULL) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), NULL) ;
+
+  m = gtv_mesh_new(gtv_volume_vertex_number(v),
+		   gtv_volume_cell_number(v)) ;
+  h = g_hash_table_new(NULL, NULL) ;
+
+  data[0] = h ; data[1] = m ;
+  gtv_volume_foreach_vertex(v, (GtsFunc)mesh_add_vertex, data) ;
+  gtv_volume_foreach_cell(v, (GtsFunc)mesh_add_cell, data) ;
+
+  g_hash_table_destroy(h) ;
+
+  gtv_mesh_neighbours(m) ;
+
+  return m ;
+}
+
+/**
+ * Add the cells of a ::GtvMesh to a ::GtvVolume, creating vertices,
+ * edges, facets and cells using the classes of the volume. Each facet
+ * is made once, from a table of the facets of all cells sorted on
+ * their vertex indices, so no searching of the volume is needed to
+ * connect the cells, and only vertices used by a cell are created.
+ *
+ * @param m a ::GtvMesh;
+ * @param v a ::GtvVolume.
+ *
+ * @return GTV_SUCCESS on success, GTV_ARGUMENT_OUT_OF_RANGE if a cell
+ * of \a m has a vertex index out of range or a repeated vertex, in
+ * which case nothing is added to \a v.
+ */
+
+gint gtv_mesh_to_volume(GtvMesh *m, GtvVolume *v)
+
+{
+  GtsVertex **w ;
+  GtvFacet **facets, *t ;
+  GtvCell *c ;
+  mesh_facet_t *f ;
+  gint32 i, j, k, *s ;
+
+  g_return_val_if_fail(m != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+
+  for ( i = 0 ; i < m->nc ; i ++ ) {
+    s = gtv_mesh_cell(m, i) ;
+    for ( j = 0 ; j < 4 ; j ++ ) {
+      if ( s[j] < 0 || s[j] >= m->nv ) {
+	g_warning("%s: cell %d has vertex %d out of range", 
+		  __FUNCTION__, i, s[j]) ;
+	return GTV_ARGUMENT_OUT_OF_RANGE ;
+      }
+    }
+    if ( s[0] == s[1] || s[0] == s[2] || s[0] == s[3] ||
+	 s[1] == s[2] || s[1] == s[3] || s[2] == s[3] ) {
+      g_warning("%s: cell %d has a repeated vertex", __FUNCTION__, i) ;
+      return GTV_ARGUMENT_OUT_OF_RANGE ;
+    }
+  }
+
+  w = g_new0(GtsVertex *, m->nv) ;
+  for ( i = 0 ; i < 4*m->nc ; i ++ ) {
+    j = m->cells[i] ;
+    if ( w[j] == NULL )
+      w[j] = gts_vertex_new(v->vertex_class,
+			    m->x[3*j+0], m->x[3*j+1], m->x[3*j+2]) ;
+  }
+
+  /*facets[4*i+j] is the facet of cell i opposite its vertex j*/
+  f = mesh_facet_table(m) ;
+  facets = g_new(GtvFacet *, 4*m->nc) ;
+  for ( k = 0 ; k < 4*m->nc ; k = j ) {
+    t = facet_new_from_vertices(v, v->facet_class, v->edge_class,
+				w[f[k].v[0]], w[f[k].v[1]], w[f[k].v[2]]) ;
+    for ( j = k ; j < 4*m->nc && facet_compare(&(f[k]), &(f[j])) == 0 ;
+	  j ++ )
+      facets[f[j].id] = t ;
+  }
+  g_free(f) ;
+
+  for ( i = 0 ; i < m->nc ; i ++ ) {
+    c = volume_cell_new(v, v->cell_class, facets[4*i+0], facets[4*i+1],
+			facets[4*i+2], facets[4*i+3]) ;
+    gtv_volume_add_cell(v, c) ;
+  }
+
+  g_free(facets) ; g_free(w) ;
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Write a ::GtvMesh to a file in binary format. The neighbours are
+ * written if \a m has any cells, and the attributes if \a m has any.
+ *
+ * @param m a ::GtvMesh;
+ * @param f file pointer, opened for binary writing.
+ *
+ * @return GTV_SUCCESS on success, GTV_FAILURE on a write error.
+ */
+
+gint gtv_mesh_write_binary(GtvMesh *m, FILE *f)
+
+{
+  gchar header[MESH_BINARY_HEADER_SIZE] ;
+  guint32 u ;
+  gint64 n ;
+  gsize nw ;
+
+  g_return_val_if_fail(m != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  memset(header, 0, MESH_BINARY_HEADER_SIZE) ;
+  memcpy(&(header[0]), "GTVB", 4) ;
+  u = GTV_MESH_BINARY_VERSION ; memcpy(&(header[4]), &u, 4) ;
+  u = MESH_BINARY_BYTE_ORDER ; memcpy(&(header[8]), &u, 4) ;
+  u = 0 ;
+  if ( m->neighbours != NULL && m->nc > 0 ) u |= MESH_BINARY_NEIGHBOURS ;
+  if ( m->na > 0 ) u |= MESH_BINARY_ATTRIBUTES ;
+  memcpy(&(header[12]), &u, 4) ;
+  n = m->nv ; memcpy(&(header[16]), &n, 8) ;
+  n = m->nc ; memcpy(&(header[24]), &n, 8) ;
+  memcpy(&(header[32]), &(m->na), 4) ;
+
+  nw  = fwrite(header, 1, MESH_BINARY_HEADER_SIZE, f) ;
+  nw += sizeof(gdouble)*fwrite(m->x, sizeof(gdouble), 3*m->nv, f) ;
+  nw += sizeof(gint32)*fwrite(m->cells, sizeof(gint32), 4*m->nc, f) ;
+  n = MESH_BINARY_HEADER_SIZE +
+    sizeof(gdouble)*3*m->nv + sizeof(gint32)*4*m->nc ;
+  if ( u & MESH_BINARY_NEIGHBOURS ) {
+    nw += sizeof(gint32)*fwrite(m->neighbours, sizeof(gint32), 4*m->nc, f) ;
+    n += sizeof(gint32)*4*m->nc ;
+  }
+  if ( u & MESH_BINARY_ATTRIBUTES ) {
+    nw += sizeof(gdouble)*fwrite(m->attributes, sizeof(gdouble),
+				 m->na*m->nc, f) ;
+    n += sizeof(gdouble)*m->na*m->nc ;
+  }
+
+  if ( nw != n ) {
+    g_warning("%s: short write (%lu of %lu bytes)", __FUNCTION__,
+	      (gulong)nw, (gulong)n) ;
+    return GTV_FAILURE ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
+/**
+ * Map a binary mesh file into memory and return a read-only
+ * ::GtvMesh whose arrays point into the mapping, so that nothing is
+ * copied or parsed. The mesh cannot be extended, and its \a
+ * neighbours are NULL if they were not stored in the file. It must
+ * be released with ::gtv_mesh_free, which unmaps the file.
+ *
+ * @param file name of a file written by ::gtv_mesh_write_binary.
+ *
+ * @return a read-only ::GtvMesh view of \a file, or NULL if it
+ * cannot be mapped or is not a valid binary mesh file.
+ */
+
+GtvMesh *gtv_mesh_map_binary(const gchar *file)
+
+{
+#if GLIB_CHECK_VERSION(2,8,0)
+  GMappedFile *map ;
+  GError *error = NULL ;
+  GtvMesh *m ;
+  gchar *buf ;
+  guint32 version, order, flags ;
+  gint64 nv, nc, size ;
+  gint32 na ;
+
+  g_return_val_if_fail(file != NULL, NULL) ;
+
+  if ( (map = g_mapped_file_new(file, FALSE, &error)) == NULL ) {
+    g_warning("%s: %s", __FUNCTION__, error->message) ;
+    g_error_free(error) ;
+    return NULL ;
+  }
+
+  buf = g_mapped_file_get_contents(map) ;
+  size = g_mapped_file_get_length(map) ;
+  if ( size < MESH_BINARY_HEADER_SIZE || strncmp(buf, "GTVB", 4) != 0 ) {
+    g_warning("%s: %s is not a binary mesh file", __FUNCTION__, file) ;
+    goto fail ;
+  }
+
+  memcpy(&version, &(buf[4]), 4) ; memcpy(&order, &(buf[8]), 4) ;
+  memcpy(&flags, &(buf[12]), 4) ;
+  memcpy(&nv, &(buf[16]), 8) ; memcpy(&nc, &(buf[24]), 8) ;
+  memcpy(&na, &(buf[32]), 4) ;
+
+  if ( order != MESH_BINARY_BYTE_ORDER ) {
+    g_warning("%s: %s was written with a different byte order",
+	      __FUNCTION__, file) ;
+    goto fail ;
+  }
+  if ( version > GTV_MESH_BINARY_VERSION ) {
+    g_warning("%s: %s has unsupported version %u", __FUNCTION__, file,
+	      version) ;
+    goto fail ;
+  }
+  if ( nv < 0 || nc < 0 || nv > G_MAXINT32 || nc > G_MAXINT32 || na < 0 ||
+       (!(flags & MESH_BINARY_ATTRIBUTES) && na != 0) ) {
+    g_warning("%s: %s has an invalid header", __FUNCTION__, file) ;
+    goto fail ;
+  }
+  if ( size != MESH_BINARY_HEADER_SIZE +
+       sizeof(gdouble)*3*nv + sizeof(gint32)*4*nc +
+       ((flags & MESH_BINARY_NEIGHBOURS) ? sizeof(gint32)*4*nc : 0) +
+       sizeof(gdouble)*na*nc ) {
+    g_warning("%s: %s is truncated or has the wrong size",
+	      __FUNCTION__, file) ;
+    goto fail ;
+  }
+
+  m = g_new0(GtvMesh, 1) ;
+  m->map = map ;
+  m->nv = m->nvmax = nv ; m->nc = m->ncmax = nc ; m->na = na ;
+  buf += MESH_BINARY_HEADER_SIZE ;
+  m->x = (gdouble *)buf ; buf += sizeof(gdouble)*3*nv ;
+  m->cells = (gint32 *)buf ; buf += sizeof(gint32)*4*nc ;
+  if ( flags & MESH_BINARY_NEIGHBOURS ) {
+    m->neighbours = (gint32 *)buf ; buf += sizeof(gint32)*4*nc ;
+  }
+  if ( na > 0 ) m->attributes = (gdouble *)buf ;
+
+  return m ;
+
+ fail:
+#if GLIB_CHECK_VERSION(2,22,0)
+  g_mapped_file_unref(map) ;
+#else
+  g_mapped_file_free(map) ;
+#endif /*GLIB_CHECK_VERSION(2,22,0)*/
+  return NULL ;
+#else
+  g_warning("%s: file mapping needs GLib 2.8 or later", __FUNCTION__) ;
+  return NULL ;
+#endif /*GLIB_CHECK_VERSION(2,8,0)*/
+}
+
+/**
+ * Write a ::GtvVolume to a file in the binary mesh format of
+ * ::gtv_mesh_write_binary, with cell neighbours.
+ *
+ * @param v a ::GtvVolume;
+ * @param f file pointer, opened for binary writing.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_volume_write_binary(GtvVolume *v, FILE *f)
+
+{
+  GtvMesh *m ;
+  gint status ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  m = gtv_mesh_from_volume(v) ;
+  status = gtv_mesh_write_binary(m, f) ;
+  gtv_mesh_free(m) ;
+
+  return status ;
+}
+
+/**
+ * Read a binary mesh file into a ::GtvVolume, creating vertices,
+ * edges, facets and cells using the classes of the volume. The file
+ * is mapped, not read through a buffer.
+ *
+ * @param v a ::GtvVolume;
+ * @param file name of a file written by ::gtv_mesh_write_binary or
+ * ::gtv_volume_write_binary.
+ *
+ * @return GTV_SUCCESS on success, GTV_UNKNOWN_FORMAT if \a file
+ * cannot be read as a binary mesh.
+ */
+
+gint gtv_volume_read_binary(GtvVolume *v, const gchar *file)
+
+{
+  GtvMesh *m ;
+  gint status ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(file != NULL, GTV_NULL_ARGUMENT) ;
+
+  if ( (m = gtv_mesh_map_binary(file)) == NULL ) return GTV_UNKNOWN_FORMAT ;
+  status = gtv_mesh_to_volume(m, v) ;
+  gtv_mesh_free(m) ;
+
+  return status ;
+}
+
+/**
+ * @}
+ *
+ */
@@ -0,0 +1,641 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @defgroup octree Octrees
+ *
+ * A ::GtvOctTree is a spatial index over the cells of a ::GtvVolume,
+ * built from ::GtvOctTreeBox's. Each cell is placed in the box which
+ * contains its centroid, and boxes holding more than a given number of
+ * cells are split into eight, down to a maximum depth. The boxes are
+ * held in a single array, in order of level, with the eight children
+ * of a box next to each other, and the cells are held in a single
+ * array, ordered so that the cells of any box are contiguous. A box
+ * therefore needs no lists: it refers to its children and cells by
+ * index.
+ *
+ * The ::GtsBBox of a box is the bounding box of its cells, which may
+ * extend beyond the cube of the box, and is empty (\a x1 > \a x2) if
+ * the box has no cells. The centre of the cube is \a xc and its side
+ * is given by ::gtv_oct_tree_box_width.
+ *
+ * @{
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <gts.h>
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+static void oct_tree_box_clear(GtvOctTreeBox *b)
+
+/*free the data of a box, other than its centre*/
+
+{
+  if ( b->cfft != NULL ) g_hash_table_destroy(b->cfft) ;
+  if ( b->Imnk != NULL ) g_array_free(b->Imnk, TRUE) ;
+  if ( b->dImnk != NULL ) g_array_free(b->dImnk, TRUE) ;
+  if ( b->B != NULL ) g_array_free(b->B, TRUE) ;
+  g_slist_free(b->elements) ;
+  b->cfft = NULL ; b->Imnk = b->dImnk = b->B = NULL ; b->elements = NULL ;
+
+  return ;
+}
+
+static void oct_tree_box_destroy(GtsObject *object)
+
+{
+  GtvOctTreeBox *b = GTV_OCT_TREE_BOX(object) ;
+
+  oct_tree_box_clear(b) ;
+  if ( b->xc != NULL ) gts_object_destroy(GTS_OBJECT(b->xc)) ;
+
+  (* GTS_OBJECT_CLASS (gtv_oct_tree_box_class ())->parent_class->destroy)
+    (object);
+}
+
+static void gtv_oct_tree_box_class_init(GtvOctTreeBoxClass *klass)
+
+{
+  GTS_OBJECT_CLASS(klass)->destroy = oct_tree_box_destroy ;
+}
+
+static void gtv_oct_tree_box_init(GtvOctTreeBox *b)
+
+{
+  b->klass = GTV_OCT_TREE_BOX_CLASS(GTS_OBJECT(b)->klass) ;
+  b->elements = NULL ; b->cfft = NULL ;
+  b->Imnk = b->dImnk = b->B = NULL ;
+  b->stride = b->order = 0 ;
+  b->xc = NULL ;
+  b->level = 0 ; b->parent_box = b->child = -1 ;
+  b->first = b->n = 0 ;
+}
+
+/**
+ * The basic class for boxes of octrees.
+ *
+ * @return the ::GtvOctTreeBoxClass
+ */
+
+GtvOctTreeBoxClass *gtv_oct_tree_box_class(void)
+
+{
+  static GtvOctTreeBoxClass *klass = NULL;
+
+  if (klass == NULL) {
+    GtsObjectClassInfo gtv_oct_tree_box_info = {
+      "GtvOctTreeBox",
+      sizeof (GtvOctTreeBox),
+      sizeof (GtvOctTreeBoxClass),
+      (GtsObjectClassInitFunc) gtv_oct_tree_box_class_init,
+      (GtsObjectInitFunc) gtv_oct_tree_box_init,
+      (GtsArgSetFunc) NULL,
+      (GtsArgGetFunc) NULL
+    };
+    klass = gts_object_class_new (GTS_OBJECT_CLASS (gts_bbox_class ()),
+				  &gtv_oct_tree_box_info);
+  }
+
+  return klass;
+}
+
+/**
+ * Make a new ::GtvOctTreeBox, not part of any tree, with its centre
+ * at the centre of its bounding box.
+ *
+ * @param klass a ::GtvOctTreeBoxClass;
+ * @param x1 minimum x coordinate;
+ * @param y1 minimum y coordinate;
+ * @param z1 minimum z coordinate;
+ * @param x2 maximum x coordinate;
+ * @param y2 maximum y coordinate;
+ * @param z2 maximum z coordinate.
+ *
+ * @return the new ::GtvOctTreeBox.
+ */
+
+GtvOctTreeBox *gtv_oct_tree_box_new(GtvOctTreeBoxClass *klass,
+				    gdouble x1, gdouble y1, gdouble z1,
+				    gdouble x2, gdouble y2, gdouble z2)
+
+{
+  GtvOctTreeBox *b ;
+
+  g_return_val_if_fail(klass != NULL, NULL) ;
+  g_return_val_if_fail(x1 <= x2 && y1 <= y2 && z1 <= z2, NULL) ;
+
+  b = GTV_OCT_TREE_BOX(gts_object_new(GTS_OBJECT_CLASS(klass))) ;
+  gts_bbox_set(GTS_BBOX(b), NULL, x1, y1, z1, x2, y2, z2) ;
+  b->xc = gts_point_new(gts_point_class(),
+			0.5*(x1+x2), 0.5*(y1+y2), 0.5*(z1+z2)) ;
+
+  return b ;
+}
+
+static void object_init(GtsObject *object, GtsObjectClass *klass)
+
+/*initialize an object held in an array, as gts_object_new would*/
+
+{
+  memset(object, 0, klass->info.object_size) ;
+  object->klass = klass ;
+  gts_object_init(object, klass) ;
+
+  return ;
+}
+
+static void oct_tree_add_cell(GtvCell *c, gpointer data[])
+
+{
+  GtvOctTree *t = (GtvOctTree *)data[0] ;
+  GtsVertex *v1, *v2, *v3, *v4 ;
+  gdouble *x = &(t->centroids[3*t->ncells]) ;
+
+  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &v1, &v2, &v3, &v4) ;
+  x[0] = 0.25*(GTS_POINT(v1)->x + GTS_POINT(v2)->x +
+	       GTS_POINT(v3)->x + GTS_POINT(v4)->x) ;
+  x[1] = 0.25*(GTS_POINT(v1)->y + GTS_POINT(v2)->y +
+	       GTS_POINT(v3)->y + GTS_POINT(v4)->y) ;
+  x[2] = 0.25*(GTS_POINT(v1)->z + GTS_POINT(v2)->z +
+	       GTS_POINT(v3)->z + GTS_POINT(v4)->z) ;
+  t->cells[t->ncells ++] = c ;
+
+  return ;
+}
+
+static void oct_tree_split(GtvOctTree *t, gint i, gdouble *c,
+			   GtvCell **cells, gdouble *x)
+
+/*
+  sort the cells of box i into its octants and add its eight
+  children, with their centres in c; cells and x are workspace
+*/
+
+{
+  GtvOctTreeBox *b = gtv_oct_tree_box(t, i), *child ;
+  guint j, n[8], off[9] ;
+  gint k, o ;
+  gdouble *y, w ;
+
+  memset(n, 0, 8*sizeof(guint)) ;
+  for ( j = b->first ; j < b->first + b->n ; j ++ ) {
+    y = &(t->centroids[3*j]) ;
+    o = (y[0] > c[3*i+0]) | ((y[1] > c[3*i+1]) << 1) |
+      ((y[2] > c[3*i+2]) << 2) ;
+    n[o] ++ ;
+  }
+  for ( (off[0] = 0), (k = 0) ; k < 8 ; k ++ ) off[k+1] = off[k] + n[k] ;
+
+  memset(n, 0, 8*sizeof(guint)) ;
+  for ( j = b->first ; j < b->first + b->n ; j ++ ) {
+    y = &(t->centroids[3*j]) ;
+    o = (y[0] > c[3*i+0]) | ((y[1] > c[3*i+1]) << 1) |
+      ((y[2] > c[3*i+2]) << 2) ;
+    cells[off[o]+n[o]] = t->cells[j] ;
+    memcpy(&(x[3*(off[o]+n[o])]), y, 3*sizeof(gdouble)) ;
+    n[o] ++ ;
+  }
+  memcpy(&(t->cells[b->first]), cells, b->n*sizeof(GtvCell *)) ;
+  memcpy(&(t->centroids[3*b->first]), x, 3*b->n*sizeof(gdouble)) ;
+
+  b->child = t->nboxes ;
+  w = 0.25*t->width/(gdouble)(1 << b->level) ;
+  for ( k = 0 ; k < 8 ; k ++ ) {
+    child = gtv_oct_tree_box(t, t->nboxes) ;
+    object_init(GTS_OBJECT(child), GTS_OBJECT_CLASS(b->klass)) ;
+    child->level = b->level + 1 ; child->parent_box = i ;
+    child->first = b->first + off[k] ; child->n = off[k+1] - off[k] ;
+    c[3*t->nboxes+0] = c[3*i+0] + ((k & 1) ? w : -w) ;
+    c[3*t->nboxes+1] = c[3*i+1] + ((k & 2) ? w : -w) ;
+    c[3*t->nboxes+2] = c[3*i+2] + ((k & 4) ? w : -w) ;
+    t->nboxes ++ ;
+    t->depth = MAX(t->depth, child->level) ;
+  }
+
+  return ;
+}
+
+static void oct_tree_box_bound(GtvOctTree *t, GtvOctTreeBox *b)
+
+/*bounding box of the cells of a box, from its children if it has any*/
+
+{
+  GtsBBox *bb = GTS_BBOX(b), *cb ;
+  GtsVertex *v[4] ;
+  GtsPoint *p ;
+  guint i, j ;
+
+  bb->x1 = bb->y1 = bb->z1 = G_MAXDOUBLE ;
+  bb->x2 = bb->y2 = bb->z2 = -G_MAXDOUBLE ;
+
+  if ( !gtv_oct_tree_box_is_leaf(b) ) {
+    for ( i = 0 ; i < 8 ; i ++ ) {
+      cb = GTS_BBOX(gtv_oct_tree_box(t, b->child+i)) ;
+      bb->x1 = MIN(bb->x1, cb->x1) ; bb->x2 = MAX(bb->x2, cb->x2) ;
+      bb->y1 = MIN(bb->y1, cb->y1) ; bb->y2 = MAX(bb->y2, cb->y2) ;
+      bb->z1 = MIN(bb->z1, cb->z1) ; bb->z2 = MAX(bb->z2, cb->z2) ;
+    }
+    return ;
+  }
+
+  for ( i = 0 ; i < b->n ; i ++ ) {
+    gtv_tetrahedron_vertices(GTV_TETRAHEDRON(gtv_oct_tree_box_cell(t,b,i)),
+			     &(v[0]), &(v[1]), &(v[2]), &(v[3])) ;
+    for ( j = 0 ; j < 4 ; j ++ ) {
+      p = GTS_POINT(v[j]) ;
+      bb->x1 = MIN(bb->x1, p->x) ; bb->x2 = MAX(bb->x2, p->x) ;
+      bb->y1 = MIN(bb->y1, p->y) ; bb->y2 = MAX(bb->y2, p->y) ;
+      bb->z1 = MIN(bb->z1, p->z) ; bb->z2 = MAX(bb->z2, p->z) ;
+    }
+  }
+
+  return ;
+}
+
+/**
+ * Build an octree over the cells of a ::GtvVolume. The tree refers
+ * to the cells but does not hold references to them, so it must be
+ * rebuilt if the volume is changed.
+ *
+ * @param v a ::GtvVolume;
+ * @param klass a ::GtvOctTreeBoxClass for the boxes of the tree;
+ * @param depth maximum depth of the tree (at most 20);
+ * @param leaf boxes with more than \a leaf cells are split, unless
+ * they are at the maximum depth.
+ *
+ * @return a new ::GtvOctTree.
+ */
+
+GtvOctTree *gtv_oct_tree_new(GtvVolume *v, GtvOctTreeBoxClass *klass,
+			     gint depth, guint leaf)
+
+{
+  GtvOctTree *t ;
+  GtvOctTreeBox *b ;
+  GtvCell **cells ;
+  gpointer data[1] ;
+  gdouble *c, *x, xmin[3], xmax[3] ;
+  gint i, nmax ;
+  guint j ;
+
+  g_return_val_if_fail(v != NULL, NULL) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), NULL) ;
+  g_return_val_if_fail(klass != NULL, NULL) ;
+  g_return_val_if_fail(GTV_IS_OCT_TREE_BOX_CLASS(klass), NULL) ;
+  g_return_val_if_fail(depth >= 0 && depth <= OCT_TREE_DEPTH_MAX, NULL) ;
+  g_return_val_if_fail(leaf > 0, NULL) ;
+
+  t = g_new0(GtvOctTree, 1) ;
+  j = gtv_volume_cell_number(v) ;
+  t->cells = g_new(GtvCell *, j) ;
+  t->centroids = g_new(gdouble, 3*j) ;
+  data[0] = t ;
+  gtv_volume_foreach_cell(v, (GtsFunc)oct_tree_add_cell, data) ;
+
+  /*root cube, just containing the cell centroids*/
+  xmin[0] = xmin[1] = xmin[2] = G_MAXDOUBLE ;
+  xmax[0] = xmax[1] = xmax[2] = -G_MAXDOUBLE ;
+  for ( j = 0 ; j < 3*t->ncells ; j ++ ) {
+    xmin[j%3] = MIN(xmin[j%3], t->centroids[j]) ;
+    xmax[j%3] = MAX(xmax[j%3], t->centroids[j]) ;
+  }
+  if ( t->ncells == 0 )
+    xmin[0] = xmin[1] = xmin[2] = xmax[0] = xmax[1] = xmax[2] = 0.0 ;
+  t->width = MAX(xmax[0]-xmin[0], MAX(xmax[1]-xmin[1], xmax[2]-xmin[2])) ;
+  t->width = (t->width > 0.0 ? t->width*(1.0 + 1e-9) : 1.0) ;
+
+  /*boxes are stored with the size of klass, which may be derived from
+    GtvOctTreeBox*/
+  nmax = 64 ;
+  t->box_size = GTS_OBJECT_CLASS(klass)->info.object_size ;
+  t->boxes = g_malloc(nmax*t->box_size) ;
+  c = g_new(gdouble, 3*nmax) ;
+  cells = g_new(GtvCell *, t->ncells) ;
+  x = g_new(gdouble, 3*t->ncells) ;
+
+  b = gtv_oct_tree_box(t, 0) ;
+  object_init(GTS_OBJECT(b), GTS_OBJECT_CLASS(klass)) ;
+  b->first = 0 ; b->n = t->ncells ;
+  for ( i = 0 ; i < 3 ; i ++ ) c[i] = 0.5*(xmin[i] + xmax[i]) ;
+  t->nboxes = 1 ; t->depth = 0 ;
+
+  /*boxes are split in order, so each level follows the one above*/
+  for ( i = 0 ; i < t->nboxes ; i ++ ) {
+    b = gtv_oct_tree_box(t, i) ;
+    if ( b->n <= leaf || b->level >= depth ) continue ;
+    if ( t->nboxes + 8 > nmax ) {
+      nmax *= 2 ;
+      t->boxes = g_realloc(t->boxes, nmax*t->box_size) ;
+      c = g_renew(gdouble, c, 3*nmax) ;
+    }
+    oct_tree_split(t, i, c, cells, x) ;
+  }
+
+  g_free(cells) ; g_free(x) ;
+
+  t->centres = g_new(GtsPoint, t->nboxes) ;
+  for ( i = t->nboxes - 1 ; i >= 0 ; i -- ) {
+    b = gtv_oct_tree_box(t, i) ;
+    object_init(GTS_OBJECT(&(t->centres[i])),
+		GTS_OBJECT_CLASS(gts_point_class())) ;
+    gts_point_set(&(t->centres[i]), c[3*i+0], c[3*i+1], c[3*i+2]) ;
+    b->xc = &(t->centres[i]) ;
+    oct_tree_box_bound(t, b) ;
+  }
+
+  g_free(c) ;
+
+  return t ;
+}
+
+/**
+ * Free a ::GtvOctTree and its boxes. The cells are not affected.
+ *
+ * @param t a ::GtvOctTree.
+ *
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_oct_tree_free(GtvOctTree *t)
+
+{
+  gint i ;
+
+  g_return_val_if_fail(t != NULL, GTV_NULL_ARGUMENT) ;
+
+  /*boxes and centres are held in arrays, not allocated as objects*/
+  for ( i = 0 ; i < t->nboxes ; i ++ )
+    oct_tree_box_clear(gtv_oct_tree_box(t, i)) ;
+
+  g_free(t->boxes) ; g_free(t->centres) ;
+  g_free(t->cells) ; g_free(t->centroids) ;
+  g_free(t) ;
+
+  return GTV_SUCCESS ;
+}
+
+static gboolean bbox_contains(GtsBBox *b, GtsPoint *p)
+
+{
+  return (p->x >= b->x1 && p->x <= b->x2 &&
+	  p->y >= b->y1 && p->y <= b->y2 &&
+	  p->z >= b->z1 && p->z <= b->z2) ;
+}
+
+/**
+ * Find a cell of an octree which contains a point. Only boxes whose
+ * bounding boxes contain the point are searched.
+ *
+ * @param t a ::GtvOctTree;
+ * @param p a ::GtsPoint.
+ *
+ * @return a ::GtvCell of \a t which contains \a p, or NULL if there is
+ * none.
+ */
+
+GtvCell *gtv_oct_tree_point_locate(GtvOctTree *t, GtsPoint *p)
+
+{
+  GtvOctTreeBox *b ;
+  GtvCell *c ;
+  gint stack[8*(OCT_TREE_DEPTH_MAX+1)], n, i ;
+  guint j ;
+
+  g_return_val_if_fail(t != NULL, NULL) ;
+  g_return_val_if_fail(p != NULL, NULL) ;
+
+  stack[0] = 0 ; n = 1 ;
+  while ( n > 0 ) {
+    b = gtv_oct_tree_box(t, stack[--n]) ;
+    if ( !bbox_contains(GTS_BBOX(b), p) ) continue ;
+    if ( !gtv_oct_tree_box_is_leaf(b) ) {
+      for ( i = 0 ; i < 8 ; i ++ ) stack[n++] = b->child + i ;
+      continue ;
+    }
+    for ( j = 0 ; j < b->n ; j ++ ) {
+      c = gtv_oct_tree_box_cell(t, b, j) ;
+      if ( gtv_point_in_tetrahedron(p, GTV_TETRAHEDRON(c), NULL) != GTV_OUT )
+	return c ;
+    }
+  }
+
+  return NULL ;
+}
+
+/**
+ * Find the cells of an octree whose bounding boxes overlap a given
+ * box.
+ *
+ * @param t a ::GtvOctTree;
+ * @param b a ::GtsBBox.
+ *
+ * @return a ::GSList of the ::GtvCell's of \a t whose bounding boxes
+ * overlap \a b, NULL if there are none.
+ */
+
+GSList *gtv_oct_tree_box_cells(GtvOctTree *t, GtsBBox *b)
+
+{
+  GtvOctTreeBox *ob ;
+  GtsBBox *bb ;
+  GtsVertex *v[4] ;
+  GtsPoint *p ;
+  GSList *cells ;
+  gint stack[8*(OCT_TREE_DEPTH_MAX+1)], n, i ;
+  gdouble x1, y1, z1, x2, y2, z2 ;
+  guint j ;
+
+  g_return_val_if_fail(t != NULL, NULL) ;
+  g_return_val_if_fail(b != NULL, NULL) ;
+
+  stack[0] = 0 ; n = 1 ; cells = NULL ;
+  while ( n > 0 ) {
+    ob = gtv_oct_tree_box(t, stack[--n]) ;
+    bb = GTS_BBOX(ob) ;
+    if ( bb->x1 > b->x2 || bb->x2 < b->x1 || bb->y1 > b->y2 ||
+	 bb->y2 < b->y1 || bb->z1 > b->z2 || bb->z2 < b->z1 ) continue ;
+    if ( !gtv_oct_tree_box_is_leaf(ob) ) {
+      for ( i = 0 ; i < 8 ; i ++ ) stack[n++] = ob->child + i ;
+      continue ;
+    }
+    for ( j = 0 ; j < ob->n ; j ++ ) {
+      gtv_tetrahedron_vertices(GTV_TETRAHEDRON(gtv_oct_tree_box_cell(t,ob,j)),
+			       &(v[0]), &(v[1]), &(v[2]), &(v[3])) ;
+      x1 = y1 = z1 = G_MAXDOUBLE ; x2 = y2 = z2 = -G_MAXDOUBLE ;
+      for ( i = 0 ; i < 4 ; i ++ ) {
+	p = GTS_POINT(v[i]) ;
+	x1 = MIN(x1, p->x) ; x2 = MAX(x2, p->x) ;
+	y1 = MIN(y1, p->y) ; y2 = MAX(y2, p->y) ;
+	z1 = MIN(z1, p->z) ; z2 = MAX(z2, p->z) ;
+      }
+      if ( x1 > b->x2 || x2 < b->x1 || y1 > b->y2 ||
+	   y2 < b->y1 || z1 > b->z2 || z2 < b->z1 ) continue ;
+      cells = g_slist_prepend(cells, gtv_oct_tree_box_cell(t, ob, j)) ;
+    }
+  }
+
+  return cells ;
+}
+
+static gdouble box_distance2(GtvOctTree *t, GtvOctTreeBox *b, GtsPoint *p)
+
+/*
+  squared distance from p to the cube of b, a lower bound on the
+  distance to the centroids of its cells
+*/
+
+{
+  gdouble h = 0.5*gtv_oct_tree_box_width(t, b), d, r ;
+
+  r = 0.0 ;
+  d = fabs(p->x - b->xc->x) - h ; if ( d > 0.0 ) r += d*d ;
+  d = fabs(p->y - b->xc->y) - h ; if ( d > 0.0 ) r += d*d ;
+  d = fabs(p->z - b->xc->z) - h ; if ( d > 0.0 ) r += d*d ;
+
+  return r ;
+}
+
+static void heap_sift_down(guint *idx, gdouble *d, gint n, gint i)
+
+/*restore a max-heap on d after replacing entry i*/
+
+{
+  gint j ;
+  guint ti ;
+  gdouble td ;
+
+  while ( (j = 2*i+1) < n ) {
+    if ( j+1 < n && d[j+1] > d[j] ) j ++ ;
+    if ( d[i] >= d[j] ) return ;
+    td = d[i] ; d[i] = d[j] ; d[j] = td ;
+    ti = idx[i] ; idx[i] = idx[j] ; idx[j] = ti ;
+    i = j ;
+  }
+
+  return ;
+}
+
+/**
+ * Find the cells of an octree whose centroids are nearest a point.
+ *
+ * @param t a ::GtvOctTree;
+ * @param p a ::GtsPoint;
+ * @param k number of cells to find;
+ * @param cells on exit, the cells found, nearest first;
+ * @param r if not NULL, on exit the distances from \a p to the
+ * centroids of \a cells.
+ *
+ * @return the number of cells found, which is less than \a k only if
+ * \a t has fewer than \a k cells.
+ */
+
+gint gtv_oct_tree_nearest_cells(GtvOctTree *t, GtsPoint *p, gint k,
+				GtvCell **cells, gdouble *r)
+
+{
+  GtvOctTreeBox *b ;
+  gint stack[8*(OCT_TREE_DEPTH_MAX+1)], order[8], n, nh, i, j, o ;
+  gdouble bound[8*(OCT_TREE_DEPTH_MAX+1)], dc[8], *d, *x, d2, td ;
+  guint *idx, m, ti ;
+
+  g_return_val_if_fail(t != NULL, 0) ;
+  g_return_val_if_fail(p != NULL, 0) ;
+  g_return_val_if_fail(k >= 0, 0) ;
+  g_return_val_if_fail(cells != NULL || k == 0, 0) ;
+
+  if ( k == 0 || t->ncells == 0 ) return 0 ;
+
+  /*the k nearest so far, as a max-heap on squared distance*/
+  idx = g_new(guint, k) ; d = g_new(gdouble, k) ; nh = 0 ;
+
+  stack[0] = 0 ; bound[0] = 0.0 ; n = 1 ;
+  while ( n > 0 ) {
+    n -- ;
+    if ( nh == k && bound[n] >= d[0] ) continue ;
+    b = gtv_oct_tree_box(t, stack[n]) ;
+    if ( !gtv_oct_tree_box_is_leaf(b) ) {
+      /*push the children furthest first, so the nearest is searched
+	first*/
+      for ( i = 0 ; i < 8 ; i ++ ) {
+	order[i] = i ;
+	dc[i] = box_distance2(t, gtv_oct_tree_box(t, b->child+i), p) ;
+      }
+      for ( i = 1 ; i < 8 ; i ++ )
+	for ( j = i ; j > 0 && dc[order[j]] > dc[order[j-1]] ; j -- ) {
+	  o = order[j] ; order[j] = order[j-1] ; order[j-1] = o ;
+	}
+      for ( i = 0 ; i < 8 ; i ++ ) {
+	if ( gtv_oct_tree_box(t, b->child+order[i])->n == 0 ) continue ;
+	if ( nh == k && dc[order[i]] >= d[0] ) continue ;
+	stack[n] = b->child + order[i] ; bound[n] = dc[order[i]] ; n ++ ;
+      }
+      continue ;
+    }
+    for ( m = b->first ; m < b->first + b->n ; m ++ ) {
+      x = &(t->centroids[3*m]) ;
+      d2 = (x[0] - p->x)*(x[0] - p->x) + (x[1] - p->y)*(x[1] - p->y) +
+	(x[2] - p->z)*(x[2] - p->z) ;
+      if ( nh < k ) {
+	/*sift up*/
+	for ( i = nh ++ ; i > 0 && d[(i-1)/2] < d2 ; i = (i-1)/2 ) {
+	  d[i] = d[(i-1)/2] ; idx[i] = idx[(i-1)/2] ;
+	}
+	d[i] = d2 ; idx[i] = m ;
+	continue ;
+      }
+      if ( d2 >= d[0] ) continue ;
+      d[0] = d2 ; idx[0] = m ;
+      heap_sift_down(idx, d, nh, 0) ;
+    }
+  }
+
+  /*heap sort, nearest first*/
+  for ( i = nh - 1 ; i > 0 ; i -- ) {
+    td = d[0] ; d[0] = d[i] ; d[i] = td ;
+    ti = idx[0] ; idx[0] = idx[i] ; idx[i] = ti ;
+    heap_sift_down(idx, d, i, 0) ;
+  }
+
+  for ( i = 0 ; i < nh ; i ++ ) {
+    cells[i] = t->cells[idx[i]] ;
+    if ( r != NULL ) r[i] = sqrt(d[i]) ;
+  }
+
+  g_free(idx) ; g_free(d) ;
+
+  return nh ;
+}
+
+/**
+ * @}
+ *
+ */
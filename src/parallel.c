@@ -0,0 +1,361 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @defgroup parallel Parallel Delaunay tetrahedralization
+ *
+ * Multi-threaded insertion of vertices into a Delaunay
+ * tetrahedralization, following the optimistic locking scheme of
+ * Batista, V. H. F., Millman, D. L., Pion, S. and Singler, J.,
+ * `Parallel geometric algorithms for multi-core computers',
+ * Computational Geometry 43:663--677, 2010. Each thread inserts
+ * vertices from its own part of a Hilbert-sorted insertion round with
+ * the cavity method of ::gtv_delaunay_add_vertex_to_cavity. Before a
+ * thread reads a cell, it takes a lock on each of the cell's
+ * vertices, so that the cells of a cavity and those around it cannot
+ * be changed by another thread. A thread which fails to take a lock
+ * releases all of its locks and tries again later, so there is no
+ * deadlock. Only the cell table of the volume is shared and that is
+ * updated under a single mutex.
+ *
+ * A vertex lock is held in the \a reserved field of the ::GtsVertex,
+ * which must be NULL for all vertices of the volume and the new
+ * vertices on entry.
+ *
+ * @{
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <gts.h>
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+#if GLIB_CHECK_VERSION(2,32,0)
+
+/*insertion rounds smaller than this, per thread, are done serially*/
+#define PARALLEL_ROUND_MIN   256
+/*attempts to insert a vertex before it is left to the serial pass*/
+#define PARALLEL_RETRY_MAX   8
+
+#define vertex_lock_owner(_v) (GTS_OBJECT(_v)->reserved)
+
+typedef struct {
+  GtvVolume *v ;
+  brio_entry_t *e ;
+  gint i0, i1 ;
+  GMutex *mutex ;
+  GPtrArray *locked ;
+  GArray *deferred ;
+  GtvCell *last ;
+  GRand *rand ;
+  gint ret ;
+} parallel_data_t ;
+
+static gboolean vertex_lock(GtsVertex *w, parallel_data_t *d)
+
+{
+  if ( g_atomic_pointer_get(&(vertex_lock_owner(w))) == d ) return TRUE ;
+  if ( !g_atomic_pointer_compare_and_exchange(&(vertex_lock_owner(w)),
+					      NULL, d) )
+    return FALSE ;
+
+  g_ptr_array_add(d->locked, w) ;
+
+  return TRUE ;
+}
+
+static void vertices_unlock(parallel_data_t *d)
+
+{
+  gint i ;
+
+  for ( i = 0 ; i < d->locked->len ; i ++ )
+    g_atomic_pointer_set(&(vertex_lock_owner(g_ptr_array_index(d->locked,
+							       i))),
+			 NULL) ;
+  g_ptr_array_set_size(d->locked, 0) ;
+
+  return ;
+}
+
+static gboolean cell_lock(GtvCell *c, gpointer data)
+
+{
+  parallel_data_t *d = data ;
+  GtvTetrahedron *t = GTV_TETRAHEDRON(c) ;
+
+  return (vertex_lock(t->v1, d) && vertex_lock(t->v2, d) &&
+	  vertex_lock(t->v3, d) && vertex_lock(t->v4, d)) ;
+}
+
+static GtvCell *parallel_start(GtsPoint *p, parallel_data_t *d)
+
+/*
+  a locked cell to start the walk to p from: the last cell created by
+  this thread if it is still in the volume, otherwise one close to p
+*/
+
+{
+  GtvCell *c ;
+
+  g_mutex_lock(d->mutex) ;
+  if ( d->last != NULL && g_hash_table_lookup(d->v->cells, d->last) != NULL )
+    c = d->last ;
+  else
+    c = locate_start_cell(d->v, p) ;
+  /*c cannot be destroyed while the mutex is held, and not after that
+    once its vertices are locked*/
+  if ( c != NULL && !cell_lock(c, d) ) c = NULL ;
+  g_mutex_unlock(d->mutex) ;
+
+  return c ;
+}
+
+static gint parallel_walk(GtsPoint *p, parallel_data_t *d, GtvCell **c)
+
+/*
+  visibility walk from *c to the cell containing p, locking each cell
+  on the way; on exit *c is the containing cell or, if p is outside
+  the volume, NULL
+*/
+
+{
+  GtvCell *n ;
+  locate_walk_t w ;
+  gint k ;
+
+  locate_walk_init(&w, d->v, *c) ;
+  while ( (k = locate_walk_step(&w, p, g_rand_int_range(d->rand, 0, 4)))
+	  >= 0 ) {
+    if ( (n = cell_neighbour(w.t, d->v, k)) == NULL ) {
+      *c = NULL ; return GTV_VERTEX_NOT_IN_VOLUME ;
+    }
+    if ( !cell_lock(n, d) ) return GTV_FAILURE ;
+    locate_walk_cross(&w, p, k) ;
+  }
+
+  *c = w.t ;
+
+  return GTV_SUCCESS ;
+}
+
+static gint parallel_insert(GtsVertex *p, parallel_data_t *d)
+
+{
+  GSList *cells, *boundary, *outer, *new, *i ;
+  GtvIntersect inter ;
+  GtvCell *c ;
+  gpointer s ;
+  gint status ;
+
+  if ( !vertex_lock(p, d) ) return GTV_FAILURE ;
+  if ( (c = parallel_start(GTS_POINT(p), d)) == NULL ) return GTV_FAILURE ;
+  if ( (status = parallel_walk(GTS_POINT(p), d, &c)) != GTV_SUCCESS )
+    return status ;
+
+  inter = gtv_point_in_tetrahedron(GTS_POINT(p), GTV_TETRAHEDRON(c), &s) ;
+  if ( inter == GTV_ON_VERTEX ) return GTV_COINCIDENT_VERTEX ;
+  if ( inter == GTV_ON_FACET && gtv_facet_is_boundary(GTV_FACET(s), d->v) )
+    return GTV_VERTEX_ON_HULL ;
+  if ( inter == GTV_ON_EDGE && gtv_edge_is_boundary(GTS_EDGE(s), d->v) )
+    return GTV_VERTEX_ON_HULL ;
+
+  if ( delaunay_cavity_grow(d->v, p, c, cell_lock, d,
+			    &cells, &boundary, &outer) != GTV_SUCCESS )
+    return GTV_FAILURE ;
+
+  /*all the vertices of the cavity and of the cells around it are
+    locked, so the new cells can be made outside the mutex*/
+  new = delaunay_cavity_fill(d->v, p, boundary, outer) ;
+  g_slist_free(boundary) ; g_slist_free(outer) ;
+
+  g_mutex_lock(d->mutex) ;
+  for ( i = cells ; i != NULL ; i = i->next )
+    gtv_volume_remove_cell(d->v, GTV_CELL(i->data)) ;
+  for ( i = new ; i != NULL ; i = i->next )
+    gtv_volume_add_cell(d->v, GTV_CELL(i->data)) ;
+  g_mutex_unlock(d->mutex) ;
+
+  d->last = GTV_CELL(new->data) ;
+  g_slist_free(cells) ; g_slist_free(new) ;
+
+  return GTV_SUCCESS ;
+}
+
+static gpointer parallel_thread(parallel_data_t *d)
+
+{
+  GtsVertex *p ;
+  gint i, j, status ;
+
+  for ( i = d->i0 ; i < d->i1 ; i ++ ) {
+    p = d->e[i].p ;
+    for ( j = 0 ; j < PARALLEL_RETRY_MAX ; j ++ ) {
+      status = parallel_insert(p, d) ;
+      vertices_unlock(d) ;
+      if ( status != GTV_FAILURE ) break ;
+      g_thread_yield() ;
+    }
+    if ( status == GTV_FAILURE ) {
+      g_array_append_val(d->deferred, i) ;
+      continue ;
+    }
+    if ( status == GTV_VERTEX_NOT_IN_VOLUME ) {
+      g_message("%s: vertex (%lg,%lg,%lg) not inside convex hull",
+		__FUNCTION__,
+		GTS_POINT(p)->x, GTS_POINT(p)->y, GTS_POINT(p)->z) ;
+      d->ret = GTV_VERTEX_NOT_IN_VOLUME ;
+    }
+  }
+
+  return NULL ;
+}
+
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+/**
+ * Add an array of ::GtsVertex to a ::GtvVolume, preserving the
+ * Delaunay property, using a number of threads. The vertices are put
+ * in the same order as in ::gtv_delaunay_add_vertices and the first
+ * insertion rounds, which are small and touch most of the volume, are
+ * inserted serially. Each later round is split into \a n_threads
+ * contiguous stretches of the Hilbert curve, which are inserted
+ * concurrently with the cavity method. Vertices which repeatedly lose
+ * out on locks to other threads are inserted serially at the end of
+ * the round. Since every insertion is a complete cavity insertion,
+ * the volume is Delaunay between insertions and on return, whatever
+ * the order in which the threads run. If GLib is older than 2.32, or
+ * \a n_threads is one, this is the same as ::gtv_delaunay_add_vertices.
+ *
+ * The vertices of \a v and those in \a vertices must not be locked or
+ * marked using their \a reserved field during the call.
+ *
+ * @param v a ::GtvVolume;
+ * @param vertices a GPtrArray of ::GtsVertex to be added to \a v;
+ * @param n_threads number of threads to use.
+ *
+ * @return GTV_SUCCESS if all of \a vertices were inserted in \a v,
+ * GTV_VERTEX_NOT_IN_VOLUME if any vertex lay outside \a v (the others
+ * are still inserted).
+ */
+
+gint gtv_delaunay_build_parallel(GtvVolume *v, GPtrArray *vertices,
+				 gint n_threads)
+
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+  brio_entry_t *e ;
+  parallel_data_t *data ;
+  GThread **threads ;
+  GMutex mutex ;
+  GtvCell *guess ;
+  gint i, j, n, r0, r1, ret, status ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(vertices != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(n_threads > 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  if ( n_threads == 1 ) return gtv_delaunay_add_vertices(v, vertices) ;
+  if ( vertices->len == 0 ) return GTV_SUCCESS ;
+
+  e = brio_order(vertices) ;
+
+  g_mutex_init(&mutex) ;
+  data = g_new0(parallel_data_t, n_threads) ;
+  threads = g_new(GThread *, n_threads) ;
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    data[j].v = v ; data[j].e = e ; data[j].mutex = &mutex ;
+    data[j].locked = g_ptr_array_new() ;
+    data[j].deferred = g_array_new(FALSE, FALSE, sizeof(gint)) ;
+    data[j].rand = g_rand_new_with_seed(j) ;
+  }
+
+  /*the serial passes use the cavity method too, so that cells made
+    by all threads are built the same way*/
+  guess = NULL ; ret = GTV_SUCCESS ;
+  for ( r0 = 0 ; r0 < vertices->len ; r0 = r1 ) {
+    for ( r1 = r0 ; r1 < vertices->len && e[r1].round == e[r0].round ;
+	  r1 ++ ) ;
+    if ( r1 - r0 < PARALLEL_ROUND_MIN*n_threads ) {
+      status = delaunay_insert_sorted(v, e, r0, r1, TRUE, &guess) ;
+      if ( status != GTV_SUCCESS ) ret = status ;
+      continue ;
+    }
+
+    g_debug("%s: inserting round of %d vertices on %d threads",
+	    __FUNCTION__, r1 - r0, n_threads) ;
+    for ( j = 0 ; j < n_threads ; j ++ ) {
+      data[j].i0 = r0 + (r1 - r0)*j/n_threads ;
+      data[j].i1 = r0 + (r1 - r0)*(j+1)/n_threads ;
+      data[j].last = NULL ;
+      g_array_set_size(data[j].deferred, 0) ;
+      threads[j] = g_thread_new(NULL, (GThreadFunc)parallel_thread,
+				&(data[j])) ;
+    }
+    for ( j = 0 ; j < n_threads ; j ++ ) g_thread_join(threads[j]) ;
+
+    for ( (n = 0), (j = 0) ; j < n_threads ; j ++ ) {
+      if ( data[j].ret != GTV_SUCCESS ) ret = data[j].ret ;
+      for ( i = 0 ; i < data[j].deferred->len ; i ++ ) {
+	n ++ ;
+	status = delaunay_insert_sorted(v, e,
+					g_array_index(data[j].deferred, gint, i),
+					g_array_index(data[j].deferred, gint, i)+1,
+					TRUE, &guess) ;
+	if ( status != GTV_SUCCESS ) ret = status ;
+      }
+    }
+    g_debug("%s: %d vertices deferred to serial insertion",
+	    __FUNCTION__, n) ;
+    guess = NULL ;
+  }
+
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    g_ptr_array_free(data[j].locked, TRUE) ;
+    g_array_free(data[j].deferred, TRUE) ;
+    g_rand_free(data[j].rand) ;
+  }
+  g_free(data) ; g_free(threads) ;
+  g_mutex_clear(&mutex) ;
+  g_free(e) ;
+
+  return ret ;
+#else
+  return gtv_delaunay_add_vertices(v, vertices) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+}
+
+/**
+ * @}
+ *
+ */
@@ -0,0 +1,176 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+  slab pools for the cells and facets of a volume: objects are carved
+  out of large blocks and returned to a free list when destroyed, so
+  that building and destroying a volume does not go through malloc
+  and free for every object
+*/
+
+#include <string.h>
+
+#include <gts.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+#if GLIB_CHECK_VERSION(2,32,0)
+#define pool_lock(_p)   g_mutex_lock(&((_p)->mutex))
+#define pool_unlock(_p) g_mutex_unlock(&((_p)->mutex))
+#else
+#define pool_lock(_p)
+#define pool_unlock(_p)
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+static void pool_destroy(object_pool_t *p)
+
+{
+  GSList *i ;
+
+  for ( i = p->slabs ; i != NULL ; i = i->next ) g_free(i->data) ;
+  g_slist_free(p->slabs) ;
+#if GLIB_CHECK_VERSION(2,32,0)
+  g_mutex_clear(&(p->mutex)) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+  g_free(p) ;
+
+  return ;
+}
+
+static void pool_grow(object_pool_t *p)
+
+/*add a slab to p and thread its objects onto the free list*/
+
+{
+  gchar *s ;
+  gint i ;
+
+  s = g_malloc(POOL_SLAB_OBJECTS*p->size) ;
+  p->slabs = g_slist_prepend(p->slabs, s) ;
+  p->nslabs ++ ;
+
+  for ( i = POOL_SLAB_OBJECTS-1 ; i >= 0 ; i -- ) {
+    GTS_OBJECT(&(s[i*p->size]))->reserved = p->free ;
+    p->free = &(s[i*p->size]) ;
+  }
+
+  return ;
+}
+
+object_pool_t *object_pool_new(void)
+
+{
+  object_pool_t *p ;
+
+  p = g_new0(object_pool_t, 1) ;
+#if GLIB_CHECK_VERSION(2,32,0)
+  g_mutex_init(&(p->mutex)) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  return p ;
+}
+
+GtsObject *object_pool_alloc(object_pool_t *p, GtsObjectClass *klass)
+
+/*
+  a new object of class klass from p, initialized as gts_object_new
+  would, or NULL if p holds objects of another class; a pool takes
+  the class of the first object allocated from it
+*/
+
+{
+  GtsObject *object ;
+
+  pool_lock(p) ;
+  if ( p->klass == NULL ) {
+    p->klass = klass ;
+    /*keep every object in a slab aligned as malloc would*/
+    p->size = (klass->info.object_size + 2*sizeof(gpointer) - 1) &
+      ~(2*sizeof(gpointer) - 1) ;
+  }
+  if ( p->klass != klass ) {
+    pool_unlock(p) ;
+    return NULL ;
+  }
+
+  if ( p->free == NULL ) pool_grow(p) ;
+  object = GTS_OBJECT(p->free) ;
+  p->free = object->reserved ;
+  p->in_use ++ ;
+  p->peak = MAX(p->peak, p->in_use) ;
+  pool_unlock(p) ;
+
+  memset(object, 0, klass->info.object_size) ;
+  object->klass = klass ;
+  gts_object_init(object, klass) ;
+
+  return object ;
+}
+
+void object_pool_release(object_pool_t *p, GtsObject *object)
+
+/*
+  return a destroyed object to p, leaving its flags alone so that it
+  still reads as destroyed; an orphaned pool is freed with its last
+  object
+*/
+
+{
+  gboolean last ;
+
+  pool_lock(p) ;
+  object->klass = NULL ;
+  object->reserved = p->free ;
+  p->free = object ;
+  p->in_use -- ;
+  last = (p->orphan && p->in_use == 0) ;
+  pool_unlock(p) ;
+
+  if ( last ) pool_destroy(p) ;
+
+  return ;
+}
+
+void object_pool_free(object_pool_t *p)
+
+/*
+  release the slabs of p in one go if none of its objects are in use,
+  otherwise leave it to be freed when the last of them is destroyed
+*/
+
+{
+  gboolean empty ;
+
+  if ( p == NULL ) return ;
+
+  pool_lock(p) ;
+  p->orphan = TRUE ;
+  empty = (p->in_use == 0) ;
+  pool_unlock(p) ;
+
+  if ( empty ) pool_destroy(p) ;
+
+  return ;
+}
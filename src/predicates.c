@@ -116,6 +116,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <glib.h>
 #include "predicates.h"
 
 /* Use header file generated automatically by predicates_init. */
@@ -380,6 +381,12 @@ static REAL isperrboundA, isperrboundB, isperrboundC;
 
 #endif /* USE_PREDICATES_INIT */
 
+/* Counts of calls which fall through to exact arithmetic.                   */
+int predicates_counting = 0;
+
+#define count_exact(i) \
+  if (predicates_counting) predicate_count_add((i), 2, 1)
+
 /*****************************************************************************/
 /*                                                                           */
 /*  doubleprint()   Print the bit representation of a double.                */
@@ -1107,6 +1114,7 @@ static REAL orient3dadapt(REAL *pa, REAL *pb, REAL *pc, REAL *pd,
     return det;
   }
 
+  count_exact(0);
   finnow = fin1;
   finother = fin2;
 
@@ -2579,6 +2587,7 @@ static REAL insphereadapt(REAL *pa, REAL *pb, REAL *pc, REAL *pd, REAL *pe,
     return det;
   }
 
+  count_exact(1);
   return insphereexact(pa, pb, pc, pd, pe);
 }
 
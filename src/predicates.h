@@ -38,4 +38,10 @@ double insphere            (double * pa,
 			    double * pd,
 			    double * pe);
 
+/* when predicates_counting is set, calls of orient3d (0) and
+   insphere (1) reaching the exact stage (2) are added to the counts
+   kept with predicate_count_add */
+extern int predicates_counting;
+void predicate_count_add(int pred, int stage, int n);
+
 #endif /* __PREDICATES_H__ */
@@ -87,20 +87,20 @@ int main (int argc, char * argv[])
 	" * but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
 	" * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n"
 	" */\n");
-  printf ("static double splitter = %f;\n", splitter);
-  printf ("static double resulterrbound = %.16g;\n", resulterrbound);
-  printf ("static double ccwerrboundA = %.16g;\n", ccwerrboundA);
-  printf ("static double ccwerrboundB = %.16g;\n", ccwerrboundB);
-  printf ("static double ccwerrboundC = %.16g;\n", ccwerrboundC);
-  printf ("static double o3derrboundA = %.16g;\n", o3derrboundA);
-  printf ("static double o3derrboundB = %.16g;\n", o3derrboundB);
-  printf ("static double o3derrboundC = %.16g;\n", o3derrboundC);
-  printf ("static double iccerrboundA = %.16g;\n", iccerrboundA);
-  printf ("static double iccerrboundB = %.16g;\n", iccerrboundB);
-  printf ("static double iccerrboundC = %.16g;\n", iccerrboundC);
-  printf ("static double isperrboundA = %.16g;\n", isperrboundA);
-  printf ("static double isperrboundB = %.16g;\n", isperrboundB);
-  printf ("static double isperrboundC = %.16g;\n", isperrboundC);
+  printf ("static const double splitter = %f;\n", splitter);
+  printf ("static const double resulterrbound = %.17g;\n", resulterrbound);
+  printf ("static const double ccwerrboundA = %.17g;\n", ccwerrboundA);
+  printf ("static const double ccwerrboundB = %.17g;\n", ccwerrboundB);
+  printf ("static const double ccwerrboundC = %.17g;\n", ccwerrboundC);
+  printf ("static const double o3derrboundA = %.17g;\n", o3derrboundA);
+  printf ("static const double o3derrboundB = %.17g;\n", o3derrboundB);
+  printf ("static const double o3derrboundC = %.17g;\n", o3derrboundC);
+  printf ("static const double iccerrboundA = %.17g;\n", iccerrboundA);
+  printf ("static const double iccerrboundB = %.17g;\n", iccerrboundB);
+  printf ("static const double iccerrboundC = %.17g;\n", iccerrboundC);
+  printf ("static const double isperrboundA = %.17g;\n", isperrboundA);
+  printf ("static const double isperrboundB = %.17g;\n", isperrboundB);
+  printf ("static const double isperrboundC = %.17g;\n", isperrboundC);
   
   FPU_RESTORE;
 
@@ -10,17 +10,17 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
  */
 
-static double splitter = 134217729.000000;
-static double resulterrbound = 3.330669073875471e-16;
-static double ccwerrboundA = 3.330669073875472e-16;
-static double ccwerrboundB = 2.220446049250315e-16;
-static double ccwerrboundC = 1.109335647967049e-31;
-static double o3derrboundA = 7.771561172376103e-16;
-static double o3derrboundB = 3.330669073875473e-16;
-static double o3derrboundC = 3.204747427460364e-31;
-static double iccerrboundA = 1.110223024625158e-15;
-static double iccerrboundB = 4.440892098500632e-16;
-static double iccerrboundC = 5.423418723394464e-31;
-static double isperrboundA = 1.776356839400253e-15;
-static double isperrboundB = 5.551115123125792e-16;
-static double isperrboundC = 8.751425667295619e-31;
+static const double splitter = 134217729.000000;
+static const double resulterrbound = 3.3306690738754706e-16;
+static const double ccwerrboundA = 3.3306690738754716e-16;
+static const double ccwerrboundB = 2.2204460492503146e-16;
+static const double ccwerrboundC = 1.1093356479670487e-31;
+static const double o3derrboundA = 7.7715611723761027e-16;
+static const double o3derrboundB = 3.3306690738754731e-16;
+static const double o3derrboundC = 3.2047474274603644e-31;
+static const double iccerrboundA = 1.1102230246251577e-15;
+static const double iccerrboundB = 4.4408920985006321e-16;
+static const double iccerrboundC = 5.423418723394464e-31;
+static const double isperrboundA = 1.7763568394002532e-15;
+static const double isperrboundB = 5.5511151231257916e-16;
+static const double isperrboundC = 8.751425667295619e-31;
@@ -0,0 +1,299 @@
+/* GTV - Library for the manipulation of tetrahedralized volumes
+ *
+ * Copyright (C) 2007, 2008, 2021 Michael Carley
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * @defgroup ray Ray traversal
+ *
+ * A ray \f$\mathbf{o}+s\mathbf{d}\f$, \f$s\geq0\f$, is traced through
+ * a ::GtvVolume by locating the cell which contains its origin and
+ * then walking from cell to cell through the facets by which it
+ * leaves each one. For each cell crossed, a ::GtvRayFunc is called
+ * with the values of \f$s\f$ at which the ray enters and leaves the
+ * cell, so that line integrals can be accumulated cell by cell. The
+ * walk ends when the ray leaves the volume through a boundary facet,
+ * and so does not follow a ray which leaves a non-convex volume and
+ * enters it again.
+ *
+ * @{
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <gts.h>
+
+#include "gtv.h"
+#include "gtv-private.h"
+
+static GtvFacet *ray_exit(GtvTetrahedron *t, GtvFacet *entry,
+			  gdouble *o, gdouble *d, gdouble *s)
+
+/*
+  facet through which the ray o + s d leaves t, other than the facet
+  it entered by, with the ray parameter on exit in s (which is not
+  decreased)
+*/
+
+{
+  GtsVertex *w[4] ;
+  GtvFacet *f[4], *exit ;
+  GtsPoint *a, *b, *c, *p ;
+  gdouble n[3], e1[3], e2[3], nd, se, smin ;
+  gint k ;
+
+  gtv_tetrahedron_vertices(t, &(w[0]), &(w[1]), &(w[2]), &(w[3])) ;
+  f[0] = t->f1 ; f[1] = t->f2 ; f[2] = t->f3 ; f[3] = t->f4 ;
+
+  exit = NULL ; smin = G_MAXDOUBLE ;
+  for ( k = 0 ; k < 4 ; k ++ ) {
+    if ( f[k] == entry ) continue ;
+    /*facet k is opposite vertex k*/
+    p = GTS_POINT(w[k]) ;
+    a = GTS_POINT(w[(k+1)%4]) ;
+    b = GTS_POINT(w[(k+2)%4]) ;
+    c = GTS_POINT(w[(k+3)%4]) ;
+    e1[0] = b->x - a->x ; e1[1] = b->y - a->y ; e1[2] = b->z - a->z ;
+    e2[0] = c->x - a->x ; e2[1] = c->y - a->y ; e2[2] = c->z - a->z ;
+    n[0] = e1[1]*e2[2] - e1[2]*e2[1] ;
+    n[1] = e1[2]*e2[0] - e1[0]*e2[2] ;
+    n[2] = e1[0]*e2[1] - e1[1]*e2[0] ;
+    if ( n[0]*(p->x - a->x) + n[1]*(p->y - a->y) + n[2]*(p->z - a->z) > 0.0 ) {
+      n[0] = -n[0] ; n[1] = -n[1] ; n[2] = -n[2] ;
+    }
+    nd = n[0]*d[0] + n[1]*d[1] + n[2]*d[2] ;
+    if ( nd <= 0.0 ) continue ;
+    se = (n[0]*(a->x - o[0]) + n[1]*(a->y - o[1]) + n[2]*(a->z - o[2]))/nd ;
+    if ( se < smin ) { smin = se ; exit = f[k] ; }
+  }
+
+  if ( exit != NULL ) *s = MAX(*s, smin) ;
+
+  return exit ;
+}
+
+static gint ray_walk(GtvCell *c, gdouble *o, gdouble *d,
+		     gint ray, guint nmax, GtvRayFunc func, gpointer data)
+
+{
+  GtvFacet *entry, *exit ;
+  GtvTetrahedron *next ;
+  gdouble s0, s1 ;
+  guint n ;
+  gint status ;
+
+  entry = NULL ; s0 = 0.0 ;
+  for ( n = 0 ; n < nmax ; n ++ ) {
+    s1 = s0 ;
+    exit = ray_exit(GTV_TETRAHEDRON(c), entry, o, d, &s1) ;
+    if ( exit == NULL ) {
+      g_debug("%s: ray %d has no exit from cell %p", __FUNCTION__, ray, c) ;
+      return GTV_FAILURE ;
+    }
+    status = func(c, ray, s0, s1, data) ;
+    if ( status != GTV_SUCCESS ) return status ;
+    next = gtv_tetrahedron_opposite(GTV_TETRAHEDRON(c), exit) ;
+    if ( next == NULL ) return GTV_SUCCESS ;
+    c = GTV_CELL(next) ; entry = exit ; s0 = s1 ;
+  }
+
+  g_debug("%s: ray %d did not leave the volume after %u cells",
+	  __FUNCTION__, ray, nmax) ;
+
+  return GTV_FAILURE ;
+}
+
+/**
+ * Trace a ray through a ::GtvVolume, calling a function for each cell
+ * it crosses, in order along the ray. The cell containing the origin
+ * is found with ::gtv_point_locate and the ray is then followed
+ * through the exit facet of each cell into its neighbour, using
+ * ::gtv_tetrahedron_opposite, until it leaves the volume or \a func
+ * returns a value other than GTV_SUCCESS.
+ *
+ * @param v a ::GtvVolume;
+ * @param origin origin of the ray, which must lie in \a v;
+ * @param direction direction of the ray, which need not be normalized;
+ * @param func a ::GtvRayFunc, called with ray index 0;
+ * @param data user data passed to \a func.
+ *
+ * @return GTV_SUCCESS if the ray was followed until it left \a v,
+ * GTV_VERTEX_NOT_IN_VOLUME if \a origin is not in \a v, the value
+ * returned by \a func if it stopped the traversal, or GTV_FAILURE if
+ * the walk failed.
+ */
+
+gint gtv_volume_ray_traverse(GtvVolume *v, GtsPoint *origin,
+			     GtsVector direction, GtvRayFunc func,
+			     gpointer data)
+
+{
+  GtvCell *c ;
+  gdouble o[3] ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(origin != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(func != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(direction[0] != 0.0 || direction[1] != 0.0 ||
+		       direction[2] != 0.0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+  c = gtv_point_locate(origin, v, NULL) ;
+  if ( c == NULL ) return GTV_VERTEX_NOT_IN_VOLUME ;
+
+  o[0] = origin->x ; o[1] = origin->y ; o[2] = origin->z ;
+
+  return ray_walk(c, o, direction, 0, gtv_volume_cell_number(v) + 1,
+		  func, data) ;
+}
+
+typedef struct {
+  GtvVolume *v ;
+  gdouble *o, *d ;
+  gint i0, i1 ;
+  guint nmax ;
+  GtvRayFunc func ;
+  gpointer data ;
+  gint ret ;
+} ray_batch_t ;
+
+static gpointer ray_batch_thread(ray_batch_t *r)
+
+/*trace rays i0 to i1-1, starting each search from the cell of the
+  last origin located*/
+
+{
+  GtvCell *c, *guess ;
+  GtsPoint *p ;
+  gint i, status ;
+
+  p = gts_point_new(gts_point_class(), 0.0, 0.0, 0.0) ;
+  guess = NULL ;
+  for ( i = r->i0 ; i < r->i1 ; i ++ ) {
+    gts_point_set(p, r->o[3*i+0], r->o[3*i+1], r->o[3*i+2]) ;
+    c = gtv_point_locate(p, r->v, guess) ;
+    if ( c == NULL ) {
+      r->ret = GTV_VERTEX_NOT_IN_VOLUME ;
+      continue ;
+    }
+    guess = c ;
+    status = ray_walk(c, &(r->o[3*i]), &(r->d[3*i]), i, r->nmax,
+		      r->func, r->data) ;
+    if ( status == GTV_FAILURE ) r->ret = GTV_FAILURE ;
+  }
+  gts_object_destroy(GTS_OBJECT(p)) ;
+
+  return NULL ;
+}
+
+/**
+ * Trace many rays through a ::GtvVolume, as in
+ * ::gtv_volume_ray_traverse, using a number of threads. The rays are
+ * split into contiguous blocks, one per thread, and the location of
+ * each origin starts from the cell of the previous one, so rays with
+ * nearby origins should be placed together. A value other than
+ * GTV_SUCCESS returned by \a func stops the traversal of that ray
+ * only. If more than one thread is used, \a func is called from
+ * several threads at once. If GLib is older than 2.32, the rays are
+ * traced serially.
+ *
+ * @param v a ::GtvVolume;
+ * @param origins ray origins, three coordinates per ray;
+ * @param directions ray directions, three components per ray;
+ * @param n number of rays;
+ * @param func a ::GtvRayFunc, called with the index of each ray;
+ * @param data user data passed to \a func;
+ * @param n_threads number of threads to use.
+ *
+ * @return GTV_SUCCESS if every ray was traced, GTV_VERTEX_NOT_IN_VOLUME
+ * if the origin of any ray was not in \a v, GTV_FAILURE if any walk
+ * failed.
+ */
+
+gint gtv_volume_ray_traverse_many(GtvVolume *v, gdouble *origins,
+				  gdouble *directions, gint n,
+				  GtvRayFunc func, gpointer data,
+				  gint n_threads)
+
+{
+  ray_batch_t *r ;
+  gint j, ret ;
+#if GLIB_CHECK_VERSION(2,32,0)
+  GThread **threads ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(origins != NULL || n == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(directions != NULL || n == 0, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(func != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(n >= 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+  g_return_val_if_fail(n_threads > 0, GTV_ARGUMENT_OUT_OF_RANGE) ;
+
+  if ( n == 0 ) return GTV_SUCCESS ;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  n_threads = MIN(n_threads, n) ;
+#else
+  n_threads = 1 ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  r = g_new0(ray_batch_t, n_threads) ;
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    r[j].v = v ; r[j].o = origins ; r[j].d = directions ;
+    r[j].i0 = (gint)((gint64)n*j/n_threads) ;
+    r[j].i1 = (gint)((gint64)n*(j+1)/n_threads) ;
+    r[j].nmax = gtv_volume_cell_number(v) + 1 ;
+    r[j].func = func ; r[j].data = data ;
+    r[j].ret = GTV_SUCCESS ;
+  }
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  threads = g_new(GThread *, n_threads) ;
+  for ( j = 1 ; j < n_threads ; j ++ )
+    threads[j] = g_thread_new(NULL, (GThreadFunc)ray_batch_thread, &(r[j])) ;
+  ray_batch_thread(&(r[0])) ;
+  for ( j = 1 ; j < n_threads ; j ++ ) g_thread_join(threads[j]) ;
+  g_free(threads) ;
+#else
+  ray_batch_thread(&(r[0])) ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  ret = GTV_SUCCESS ;
+  for ( j = 0 ; j < n_threads ; j ++ ) {
+    if ( r[j].ret == GTV_FAILURE ) { ret = GTV_FAILURE ; break ; }
+    if ( r[j].ret != GTV_SUCCESS ) ret = r[j].ret ;
+  }
+
+  g_free(r) ;
+
+  return ret ;
+}
+
+/**
+ * @}
+ *
+ */
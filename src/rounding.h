@@ -19,12 +19,30 @@
 
 #include "config.h"
 
+#include <float.h>
+
+/* The FPU state saved by FPU_ROUND_DOUBLE is kept per thread, so that
+ * the predicates can be called from several threads at once. */
+#if defined(__GNUC__)
+#  define FPU_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#  define FPU_THREAD_LOCAL __declspec(thread)
+#else
+#  define FPU_THREAD_LOCAL
+#endif
+
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+/* double arithmetic is already evaluated in double precision (e.g.
+ * with SSE2), so the FPU control word need not be touched */
+#  define FPU_ROUND_DOUBLE
+#  define FPU_RESTORE
+#else /* FLT_EVAL_METHOD != 0 */
 #ifdef HAVE_FPU_CONTROL_H
 #  include <fpu_control.h>
 #  ifdef _FPU_EXTENDED
      static fpu_control_t fpu_round_double =
        (_FPU_DEFAULT & ~ _FPU_EXTENDED)|_FPU_DOUBLE;
-     static fpu_control_t fpu_init;
+     static FPU_THREAD_LOCAL fpu_control_t fpu_init;
 #    define FPU_ROUND_DOUBLE  { _FPU_GETCW(fpu_init);\
                                 _FPU_SETCW(fpu_round_double); }
 #    define FPU_RESTORE       {_FPU_SETCW(fpu_init);}
@@ -41,7 +59,7 @@
 #    ifdef WIN32
 #      ifdef _MSC_VER
 #        include <float.h>
-         static unsigned int fpu_init;
+         static FPU_THREAD_LOCAL unsigned int fpu_init;
 #        define FPU_ROUND_DOUBLE (fpu_init = _controlfp (0, 0),\
                                  _controlfp (_PC_53, MCW_PC))
 #        define FPU_RESTORE      (_controlfp (fpu_init, 0xfffff))
@@ -52,7 +70,7 @@
 #      ifdef __CYGWIN__
          typedef unsigned int fpu_control_t __attribute__ ((__mode__ (__HI__)));
          static fpu_control_t fpu_round_double = 0x027f;
-         static fpu_control_t fpu_init;
+         static FPU_THREAD_LOCAL fpu_control_t fpu_init;
 #        define _FPU_GETCW(cw) __asm__ ("fnstcw %0" : "=m" (*&cw))
 #        define _FPU_SETCW(cw) __asm__ ("fldcw %0" : : "m" (*&cw))
 #        define FPU_ROUND_DOUBLE  { _FPU_GETCW(fpu_init);\
@@ -68,3 +86,4 @@
 #    endif /* not WIN32 */
 #  endif /* not __FreeBSD__ */
 #endif /* not HAVE_FPU_CONTROL_H */
+#endif /* FLT_EVAL_METHOD != 0 */
@@ -42,9 +42,14 @@
  * 
  */
 
-static void tetrahedron_destroy (GtsObject * object)
+void tetrahedron_disconnect(GtvTetrahedron *tetrahedron)
+
+/*
+  detach a tetrahedron from its facets, destroying those left unused,
+  as in destroying it
+*/
+
 {
-  GtvTetrahedron * tetrahedron = GTV_TETRAHEDRON (object);
   GtvFacet *f1 = tetrahedron->f1 ;
   GtvFacet *f2 = tetrahedron->f2 ;
   GtvFacet *f3 = tetrahedron->f3 ;
@@ -69,7 +74,14 @@ static void tetrahedron_destroy (GtsObject * object)
   if (!GTS_OBJECT_DESTROYED (f4) &&
       !gtv_allow_floating_facets && f4->tetrahedra == NULL)
     gts_object_destroy (GTS_OBJECT (f4));
-  
+
+  return ;
+}
+
+static void tetrahedron_destroy (GtsObject * object)
+{
+  tetrahedron_disconnect(GTV_TETRAHEDRON (object)) ;
+
   (* GTS_OBJECT_CLASS (gtv_tetrahedron_class ())->parent_class->destroy) 
     (object);
 }
@@ -83,6 +95,8 @@ static void tetrahedron_init (GtvTetrahedron *tetrahedron)
 {
   tetrahedron->f1 = tetrahedron->f2 = tetrahedron->f3 = 
     tetrahedron->f4 = NULL ;
+  tetrahedron->v1 = tetrahedron->v2 = tetrahedron->v3 = 
+    tetrahedron->v4 = NULL ;
 }
 
 /** 
@@ -171,6 +185,7 @@ gint gtv_tetrahedron_set (GtvTetrahedron *tetrahedron,
   tetrahedron->f2 = f2 ;
   tetrahedron->f3 = f3 ;
   tetrahedron->f4 = f4 ;
+  tetrahedron_vertices_cache(tetrahedron) ;
 
   f1->tetrahedra = g_slist_prepend(f1->tetrahedra, tetrahedron) ;
   f2->tetrahedra = g_slist_prepend(f2->tetrahedra, tetrahedron) ;
@@ -237,9 +252,52 @@ static inline GtsVertex *triangle_opposite_vertex(GtsTriangle *t,
   return NULL ;
 }
 
+/*
+  recover the vertices of a tetrahedron from the common edges of its
+  facets and store them in the tetrahedron, in the order of
+  gtv_tetrahedron_vertices. This must be called whenever the facets of
+  the tetrahedron are changed.
+*/
+
+void tetrahedron_vertices_cache(GtvTetrahedron *t)
+
+{
+  GtsSegment *e12, *e13, *e23, *e24, *e34 ;
+
+  e12 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
+					      GTS_TRIANGLE(t->f2))) ;
+  e13 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
+					      GTS_TRIANGLE(t->f3))) ;
+  e23 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
+					      GTS_TRIANGLE(t->f3))) ;
+  e24 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
+					      GTS_TRIANGLE(t->f4))) ;
+  e34 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f3),
+					      GTS_TRIANGLE(t->f4))) ;
+
+  g_assert(e12 != NULL && e13 != NULL && e23 != NULL && 
+	   e24 != NULL && e34 != NULL) ;
+  
+  if ( e34->v1 == e24->v1 || e34->v1 == e24->v2 ) t->v1 = e34->v1 ;
+  else t->v1 = e34->v2 ;
+
+  if ( e34->v1 == e13->v1 || e34->v1 == e13->v2 ) t->v2 = e34->v1 ;
+  else t->v2 = e34->v2 ;
+
+  if ( e24->v1 == e12->v1 || e24->v1 == e12->v2 ) t->v3 = e24->v1 ;
+  else t->v3 = e24->v2 ;
+
+  if ( e23->v1 == e13->v1 || e23->v1 == e13->v2 ) t->v4 = e23->v1 ;
+  else t->v4 = e23->v2 ;
+
+  return ;
+}
+
 /** 
  * Extract the vertices of a tetrahedron. These are ordered so that \a
- * v1 is opposite the first face of \a t (t->f1) and so on.
+ * v1 is opposite the first face of \a t (t->f1) and so on. The
+ * vertices are stored in \a t when its facets are set, so this is a
+ * constant-time operation.
  * 
  * @param t a ::GtvTetrahedron;
  * @param v1 a ::GtsVertex;
@@ -257,38 +315,14 @@ gint gtv_tetrahedron_vertices(GtvTetrahedron *t,
 			      GtsVertex **v4)
 
 {
-  GtsSegment *e12, *e13, *e23, *e24, *e34 ;
-
   g_return_val_if_fail(t != NULL, GTV_NULL_ARGUMENT);
   g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), GTV_WRONG_TYPE) ;
   g_return_val_if_fail(v1 != NULL && v2 != NULL && v3 != NULL && v4 != NULL,
 		       GTV_NULL_ARGUMENT);
 
-  e12 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
-					      GTS_TRIANGLE(t->f2))) ;
-  e13 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
-					      GTS_TRIANGLE(t->f3))) ;
-  e23 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
-					      GTS_TRIANGLE(t->f3))) ;
-  e24 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
-					      GTS_TRIANGLE(t->f4))) ;
-  e34 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f3),
-					      GTS_TRIANGLE(t->f4))) ;
-
-  g_assert(e12 != NULL && e13 != NULL && e23 != NULL && 
-	   e24 != NULL && e34 != NULL) ;
-  
-  if ( e34->v1 == e24->v1 || e34->v1 == e24->v2 ) *v1 = e34->v1 ;
-  else *v1 = e34->v2 ;
-
-  if ( e34->v1 == e13->v1 || e34->v1 == e13->v2 ) *v2 = e34->v1 ;
-  else *v2 = e34->v2 ;
-
-  if ( e24->v1 == e12->v1 || e24->v1 == e12->v2 ) *v3 = e24->v1 ;
-  else *v3 = e24->v2 ;
+  g_assert(t->v1 != NULL) ;
 
-  if ( e23->v1 == e13->v1 || e23->v1 == e13->v2 ) *v4 = e23->v1 ;
-  else *v4 = e23->v2 ;
+  *v1 = t->v1 ; *v2 = t->v2 ; *v3 = t->v3 ; *v4 = t->v4 ;
 
   return GTV_SUCCESS ;
 }
@@ -314,7 +348,7 @@ gdouble gtv_tetrahedron_volume(GtvTetrahedron *t)
 
   gtv_tetrahedron_vertices(t, &v1, &v2, &v3, &v4) ;
 
-  V = gts_point_orientation_3d(GTS_POINT(v1),
+  V = gtv_point_orientation_3d(GTS_POINT(v1),
 			       GTS_POINT(v2),
 			       GTS_POINT(v3),
 			       GTS_POINT(v4))/6.0 ;
@@ -475,7 +509,7 @@ GtvIntersect gtv_point_in_tetrahedron(GtsPoint *p,
 				      gpointer *s)
 
 {
-  gdouble D, D1, D2, D3, D4, sgn ;
+  gdouble D, D1, D2, D3, D4, sgn, eps ;
   gdouble xmin, xmax, ymin, ymax, zmin, zmax ;
   GtsVertex *v1, *v2, *v3, *v4 ;
 
@@ -509,10 +543,11 @@ GtvIntersect gtv_point_in_tetrahedron(GtsPoint *p,
        (p->y < ymin) || (p->y > ymax) ||
        (p->z < zmin) || (p->z > zmax) ) return GTV_OUT ;
 
-  D = gts_point_orientation_3d(GTS_POINT(v1),
-			       GTS_POINT(v2),
-			       GTS_POINT(v3),
-			       GTS_POINT(v4)) ;
+  /*p lies in the bounding box of t, so one error bound serves for
+    all the orientation tests*/
+  eps = orient3d_filter_bound(xmax-xmin, ymax-ymin, zmax-zmin) ;
+  D = orient3d_filtered(&(GTS_POINT(v1)->x), &(GTS_POINT(v2)->x),
+			&(GTS_POINT(v3)->x), &(GTS_POINT(v4)->x), eps) ;
   /*degenerate tetrahedron*/
   if ( D == 0.0 ) {
     g_debug("%s: degenerate tetrahedron", __FUNCTION__) ;
@@ -522,20 +557,20 @@ GtvIntersect gtv_point_in_tetrahedron(GtsPoint *p,
   sgn = 1.0 ;
   if ( D < 0.0 ) { D = -D ; sgn = -1.0 ; }
 
-  D1 = sgn*gts_point_orientation_3d(GTS_POINT(p), GTS_POINT(v2),
-				    GTS_POINT(v3), GTS_POINT(v4))  ;
+  D1 = sgn*orient3d_filtered(&(p->x), &(GTS_POINT(v2)->x),
+			     &(GTS_POINT(v3)->x), &(GTS_POINT(v4)->x), eps) ;
   if ( D1 < 0.0 ) return GTV_OUT ;
 
-  D2 = sgn*gts_point_orientation_3d(GTS_POINT(v1), GTS_POINT(p),
-				    GTS_POINT(v3), GTS_POINT(v4)) ;
+  D2 = sgn*orient3d_filtered(&(GTS_POINT(v1)->x), &(p->x),
+			     &(GTS_POINT(v3)->x), &(GTS_POINT(v4)->x), eps) ;
   if ( D2 < 0.0 ) return GTV_OUT ;
 
-  D3 = sgn*gts_point_orientation_3d(GTS_POINT(v1), GTS_POINT(v2),
-				    GTS_POINT(p), GTS_POINT(v4)) ;
+  D3 = sgn*orient3d_filtered(&(GTS_POINT(v1)->x), &(GTS_POINT(v2)->x),
+			     &(p->x), &(GTS_POINT(v4)->x), eps) ;
   if ( D3 < 0.0 ) return GTV_OUT ;
 
-  D4 = sgn*gts_point_orientation_3d(GTS_POINT(v1), GTS_POINT(v2),
-				    GTS_POINT(v3), GTS_POINT(p)) ;
+  D4 = sgn*orient3d_filtered(&(GTS_POINT(v1)->x), &(GTS_POINT(v2)->x),
+			     &(GTS_POINT(v3)->x), &(p->x), eps) ;
   if ( D4 < 0.0 ) return GTV_OUT ;
 
 #ifdef GTV_DEVELOPER_DEBUG
@@ -822,6 +857,7 @@ GtvTetrahedron *gtv_tetrahedron_opposite(GtvTetrahedron *t,
 
 {
   GSList *i ;
+  GtvCell *n ;
 
   g_return_val_if_fail(t != NULL, NULL) ;
   g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), NULL) ;
@@ -829,6 +865,11 @@ GtvTetrahedron *gtv_tetrahedron_opposite(GtvTetrahedron *t,
   g_return_val_if_fail(t->f1 == f || t->f2 == f || t->f3 == f ||
 		       t->f4 == f, NULL) ;
 
+  /*cells in a single volume know their neighbours*/
+  if ( GTV_IS_CELL(t) && cell_has_single_volume(GTV_CELL(t)) &&
+       (n = GTV_CELL(t)->neighbours[tetrahedron_facet_slot(t, f)]) != NULL )
+    return GTV_TETRAHEDRON(n) ;
+
   for ( i = f->tetrahedra ; i != NULL ; i = i->next ) 
     if ( GTV_TETRAHEDRON(i->data) != t ) return GTV_TETRAHEDRON(i->data) ;
 
@@ -859,7 +900,7 @@ gdouble gtv_tetrahedron_orientation(GtvTetrahedron *t)
 
   gtv_tetrahedron_vertices(t, &v1, &v2, &v3, &v4) ;
 
-  return gts_point_orientation_3d(GTS_POINT(v1),
+  return gtv_point_orientation_3d(GTS_POINT(v1),
 				  GTS_POINT(v2),
 				  GTS_POINT(v3),
 				  GTS_POINT(v4)) ;    
@@ -894,6 +935,22 @@ gint gtv_tetrahedron_facets(GtvTetrahedron *t,
   return GTV_SUCCESS ;
 }
 
+static void swap_neighbours(GtvTetrahedron *t, gint i, gint j)
+
+/*keep the neighbours of a cell in step with its facets*/
+
+{
+  GtvCell *n ;
+
+  if ( !GTV_IS_CELL(t) ) return ;
+
+  n = GTV_CELL(t)->neighbours[i] ;
+  GTV_CELL(t)->neighbours[i] = GTV_CELL(t)->neighbours[j] ;
+  GTV_CELL(t)->neighbours[j] = n ;
+
+  return ;
+}
+
 /** 
  * Invert a tetrahedron by changing the order of two faces. This will
  * change the sign of the tetrahedron volume.
@@ -907,11 +964,43 @@ gint gtv_tetrahedron_invert(GtvTetrahedron *t)
 
 {
   GtvFacet *f ;
+  GtsVertex *v ;
 
   g_return_val_if_fail(t != NULL, GTV_NULL_ARGUMENT) ;
   g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), GTV_WRONG_TYPE) ;
 
   f = t->f3 ; t->f3 = t->f4 ; t->f4 = f ;
+  v = t->v3 ; t->v3 = t->v4 ; t->v4 = v ;
+  swap_neighbours(t, 2, 3) ;
+
+  return GTV_SUCCESS ;
+}
+
+/** 
+ * Revert a tetrahedron by reversing the order of its faces, so that
+ * \a f1 and \a f4 are exchanged, as are \a f2 and \a f3. This is an
+ * even permutation and leaves the sign of the tetrahedron volume
+ * unchanged (compare ::gtv_tetrahedron_invert).
+ * 
+ * @param t ::GtvTetrahedron to revert.
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_tetrahedron_revert(GtvTetrahedron *t)
+
+{
+  GtvFacet *f ;
+  GtsVertex *v ;
+
+  g_return_val_if_fail(t != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), GTV_WRONG_TYPE) ;
+
+  f = t->f1 ; t->f1 = t->f4 ; t->f4 = f ;
+  f = t->f2 ; t->f2 = t->f3 ; t->f3 = f ;
+  v = t->v1 ; t->v1 = t->v4 ; t->v4 = v ;
+  v = t->v2 ; t->v2 = t->v3 ; t->v3 = v ;
+  swap_neighbours(t, 0, 3) ; swap_neighbours(t, 1, 2) ;
 
   return GTV_SUCCESS ;
 }
@@ -931,8 +1020,6 @@ GtsVertex *gtv_tetrahedron_vertex_opposite(GtvTetrahedron *t,
 					   GtvFacet *f)
 
 {
-  GtsSegment *e1 = NULL, *e2 = NULL;
-
   g_return_val_if_fail(t != NULL, NULL) ;
   g_return_val_if_fail(GTV_IS_TETRAHEDRON(t), NULL) ;
 
@@ -940,39 +1027,11 @@ GtsVertex *gtv_tetrahedron_vertex_opposite(GtvTetrahedron *t,
   g_return_val_if_fail(GTV_IS_FACET(f), NULL) ;
   g_return_val_if_fail(gtv_tetrahedron_has_facet(t, f), NULL) ;
 
-  if ( f == t->f1 ) {
-    e1 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
-					       GTS_TRIANGLE(t->f4))) ;
-    e2 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f3),
-					       GTS_TRIANGLE(t->f4))) ;
-  }
-
-  if ( f == t->f2 ) {
-    e1 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f3),
-					       GTS_TRIANGLE(t->f4))) ;
-    e2 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
-					       GTS_TRIANGLE(t->f3))) ;
-  }
-
-  if ( f == t->f3 ) {
-    e1 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
-					       GTS_TRIANGLE(t->f4))) ;
-    e2 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
-					       GTS_TRIANGLE(t->f2))) ;
-  }
-
-  if ( f == t->f4 ) {
-    e1 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
-					       GTS_TRIANGLE(t->f3))) ;
-    e2 = GTS_SEGMENT(gts_triangles_common_edge(GTS_TRIANGLE(t->f1),
-					       GTS_TRIANGLE(t->f3))) ;
-  }
-
-  g_assert(e1 != NULL && e2 != NULL) ;
-
-  if ( e1->v1 == e2->v1 || e1->v1 == e2->v2 ) return e1->v1 ;
+  if ( f == t->f1 ) return t->v1 ;
+  if ( f == t->f2 ) return t->v2 ;
+  if ( f == t->f3 ) return t->v3 ;
 
-  return e1->v2 ;
+  return t->v4 ;
 }
 
 /** 
@@ -1059,13 +1118,13 @@ GtvTetrahedron *gtv_tetrahedron_new_from_vertices(GtvTetrahedronClass *klass,
 		       v2 != v3 && v2 != v4 && v3 != v4, NULL) ;  
   
   if ( (f1 = GTV_FACET(triangle_from_vertices(v2, v3, v4))) == NULL )
-    f1 = facet_new_from_vertices(facet_class, edge_class, v2, v3, v4) ;
+    f1 = facet_new_from_vertices(NULL, facet_class, edge_class, v2, v3, v4) ;
   if ( (f2 = GTV_FACET(triangle_from_vertices(v3, v4, v1))) == NULL )
-    f2 = facet_new_from_vertices(facet_class, edge_class, v3, v4, v1) ;
+    f2 = facet_new_from_vertices(NULL, facet_class, edge_class, v3, v4, v1) ;
   if ( (f3 = GTV_FACET(triangle_from_vertices(v4, v1, v2))) == NULL )
-    f3 = facet_new_from_vertices(facet_class, edge_class, v4, v1, v2) ;
+    f3 = facet_new_from_vertices(NULL, facet_class, edge_class, v4, v1, v2) ;
   if ( (f4 = GTV_FACET(triangle_from_vertices(v1, v2, v3))) == NULL )
-    f4 = facet_new_from_vertices(facet_class, edge_class, v1, v2, v3) ;
+    f4 = facet_new_from_vertices(NULL, facet_class, edge_class, v1, v2, v3) ;
 
   if ( (t = gtv_tetrahedron_from_facets(f1, f2, f3, f4)) == NULL )
     t = gtv_tetrahedron_new(klass, f1, f2, f3, f4) ;
@@ -1272,25 +1331,25 @@ GtvFacet *gtv_point_in_tetrahedron_facet(GtvTetrahedron *t,
        (p->y < ymin) || (p->y > ymax) ||
        (p->z < zmin) || (p->z > zmax) ) return NULL ;
 
-  if ( (Di = gts_point_orientation_3d(GTS_POINT(p),
+  if ( (Di = gtv_point_orientation_3d(GTS_POINT(p),
 				      GTS_POINT(v2),
 				      GTS_POINT(v3),
 				      GTS_POINT(v4))) == 0.0 )
     return t->f1 ;
 
-  if ( (Di = gts_point_orientation_3d(GTS_POINT(v1),
+  if ( (Di = gtv_point_orientation_3d(GTS_POINT(v1),
 				      GTS_POINT(p),
 				      GTS_POINT(v3),
 				      GTS_POINT(v4))) == 0.0 )
     return t->f2 ;
 
-  if ( (Di = gts_point_orientation_3d(GTS_POINT(v1),
+  if ( (Di = gtv_point_orientation_3d(GTS_POINT(v1),
 				      GTS_POINT(v2),
 				      GTS_POINT(p),
 				      GTS_POINT(v4))) == 0.0 )
     return t->f3 ;
 
-  if ( (Di = gts_point_orientation_3d(GTS_POINT(v1),
+  if ( (Di = gtv_point_orientation_3d(GTS_POINT(v1),
 				      GTS_POINT(v2),
 				      GTS_POINT(v3),
 				      GTS_POINT(p))) == 0.0 )
@@ -1433,11 +1492,15 @@ gint gtv_tetrahedron_orient(GtvTetrahedron *t)
 
   g_debug("%s: swapping f3 and f4", __FUNCTION__) ;
   swap = t->f3 ; t->f3 = t->f4 ; t->f4 = swap ;
+  swap = t->v3 ; t->v3 = t->v4 ; t->v4 = swap ;
+  swap_neighbours(t, 2, 3) ;
 
   if ( gtv_tetrahedron_volume(t) >= 0.0 ) return GTV_SUCCESS ;
 
   g_debug("%s: swapping f2 and f3", __FUNCTION__) ;
   swap = t->f2 ; t->f2 = t->f3 ; t->f3 = swap ;
+  swap = t->v2 ; t->v2 = t->v3 ; t->v3 = swap ;
+  swap_neighbours(t, 1, 2) ;
 
   g_assert(gtv_tetrahedron_volume(t) >= 0.0 ) ;
 
@@ -51,7 +51,8 @@ GtsTriangle *triangle_from_vertices(GtsVertex *v1,
   return gts_triangle_use_edges(e1, e2, e3) ;
 }
 
-GtvFacet *facet_new_from_vertices(GtvFacetClass *klass,
+GtvFacet *facet_new_from_vertices(GtvVolume *v,
+				  GtvFacetClass *klass,
 				  GtsEdgeClass *edge_class,
 				  GtsVertex *v1,
 				  GtsVertex *v2,
@@ -69,7 +70,7 @@ GtvFacet *facet_new_from_vertices(GtvFacetClass *klass,
     e3 = gts_edge_new(edge_class, v3, v1) ;
 
   if ( (f = GTV_FACET(gts_triangle_use_edges(e1, e2, e3))) == NULL )
-    f = gtv_facet_new(klass, e1, e2, e3) ;
+    f = volume_facet_new(v, klass, e1, e2, e3) ;
 
   return f ;
 }
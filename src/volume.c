@@ -43,10 +43,139 @@
 
 gboolean gtv_allow_floating_cells = FALSE ;
 
+/*traversal stamps are shared by all volumes, since vertices, edges
+  and facets can be in several of them and hold a single stamp; the
+  live volumes are listed so that all stamps can be cleared when the
+  count runs out*/
+static guint volume_epoch = 0 ;
+static GSList *volumes_live = NULL ;
+#if GLIB_CHECK_VERSION(2,32,0)
+static GMutex volume_epoch_mutex ;
+#define epoch_lock()   g_mutex_lock(&volume_epoch_mutex)
+#define epoch_unlock() g_mutex_unlock(&volume_epoch_mutex)
+#else
+#define epoch_lock()
+#define epoch_unlock()
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+static void epoch_clear_cell(GtvTetrahedron *t, gpointer dummy,
+			     gpointer data)
+
+{
+  GtsSegment *s[3] ;
+  GtvFacet *f[4] ;
+  gint i, j ;
+
+  f[0] = t->f1 ; f[1] = t->f2 ; f[2] = t->f3 ; f[3] = t->f4 ;
+  for ( i = 0 ; i < 4 ; i ++ ) {
+    object_epoch_set(f[i], 0) ;
+    s[0] = GTS_SEGMENT(GTS_TRIANGLE(f[i])->e1) ;
+    s[1] = GTS_SEGMENT(GTS_TRIANGLE(f[i])->e2) ;
+    s[2] = GTS_SEGMENT(GTS_TRIANGLE(f[i])->e3) ;
+    for ( j = 0 ; j < 3 ; j ++ ) {
+      object_epoch_set(s[j], 0) ;
+      object_epoch_set(s[j]->v1, 0) ;
+      object_epoch_set(s[j]->v2, 0) ;
+    }
+  }
+
+  return ;
+}
+
+static void cell_connect(GtvCell *c, GtvVolume *v)
+
+/*
+  set c as a neighbour of its neighbours in v, which it has just
+  joined, and set its own neighbours if v is its only volume; cached
+  neighbours are only kept for cells in a single volume
+*/
+
+{
+  GtvTetrahedron *t = GTV_TETRAHEDRON(c) ;
+  GtvFacet *f[4] ;
+  GtvCell *n ;
+  gint k ;
+
+  f[0] = t->f1 ; f[1] = t->f2 ; f[2] = t->f3 ; f[3] = t->f4 ;
+  for ( k = 0 ; k < 4 ; k ++ ) {
+    n = cell_neighbour_scan(c, v, k) ;
+    if ( cell_has_single_volume(c) ) c->neighbours[k] = n ;
+    if ( n != NULL && cell_has_single_volume(n) )
+      n->neighbours[tetrahedron_facet_slot(GTV_TETRAHEDRON(n), f[k])] = c ;
+  }
+
+  return ;
+}
+
+static void cell_disconnect(GtvCell *c, GtvVolume *v)
+
+/*
+  clear c from the neighbours of its neighbours in v, which it has
+  just left, and reset its own neighbours for the volume it is left
+  in, if only one
+*/
+
+{
+  GtvTetrahedron *t = GTV_TETRAHEDRON(c) ;
+  GtvFacet *f[4] ;
+  GtvCell *n ;
+  gint k, j ;
+
+  f[0] = t->f1 ; f[1] = t->f2 ; f[2] = t->f3 ; f[3] = t->f4 ;
+  for ( k = 0 ; k < 4 ; k ++ ) {
+    /*if v was the only volume of c, its neighbours there are cached*/
+    n = (c->volumes == NULL ? c->neighbours[k] :
+	 cell_neighbour_scan(c, v, k)) ;
+    c->neighbours[k] = NULL ;
+    if ( n == NULL || !cell_has_single_volume(n) ) continue ;
+    j = tetrahedron_facet_slot(GTV_TETRAHEDRON(n), f[k]) ;
+    if ( n->neighbours[j] == c ) n->neighbours[j] = NULL ;
+  }
+
+  if ( cell_has_single_volume(c) ) 
+    for ( k = 0 ; k < 4 ; k ++ )
+      c->neighbours[k] = cell_neighbour_scan(c, c->volumes->data, k) ;
+
+  return ;
+}
+
+static void cell_count(GtvCell *c, GtvVolume *v, gint sign)
+
+/*
+  add (sign = 1) or subtract (sign = -1) the vertices, edges and
+  facets of c which are not used by any other cell of v; c must not be
+  in v when this is called
+*/
+
+{
+  GtvTetrahedron *t = GTV_TETRAHEDRON(c) ;
+  GtsVertex *w[4] ;
+  GtsEdge *e ;
+  gint i, j ;
+
+  if ( gtv_facet_has_parent_volume(t->f1, v) == NULL ) v->n_facets += sign ;
+  if ( gtv_facet_has_parent_volume(t->f2, v) == NULL ) v->n_facets += sign ;
+  if ( gtv_facet_has_parent_volume(t->f3, v) == NULL ) v->n_facets += sign ;
+  if ( gtv_facet_has_parent_volume(t->f4, v) == NULL ) v->n_facets += sign ;
+
+  w[0] = t->v1 ; w[1] = t->v2 ; w[2] = t->v3 ; w[3] = t->v4 ;
+  for ( i = 0 ; i < 4 ; i ++ ) {
+    if ( gtv_vertex_has_parent_volume(w[i], v) == NULL ) 
+      v->n_vertices += sign ;
+    for ( j = i+1 ; j < 4 ; j ++ ) {
+      e = GTS_EDGE(gts_vertices_are_connected(w[i], w[j])) ;
+      if ( gtv_edge_has_parent_volume(e, v) == NULL ) v->n_edges += sign ;
+    }
+  }
+
+  return ;
+}
+
 static void destroy_cell(GtvCell *c, GtvVolume *v)
 
 {
   c->volumes = g_slist_remove(c->volumes, v) ;
+  cell_disconnect(c, v) ;
 
   if ( !GTS_OBJECT_DESTROYED(c) &&
        !gtv_allow_floating_cells && c->volumes == NULL ) 
@@ -60,10 +189,20 @@ static void volume_destroy (GtsObject *object)
 {
   GtvVolume *v = GTV_VOLUME(object) ;
 
+  epoch_lock() ;
+  volumes_live = g_slist_remove(volumes_live, v) ;
+  epoch_unlock() ;
+
+  locate_grid_free(v) ;
   gtv_volume_foreach_cell(v, (GtsFunc)destroy_cell, v) ;
 
   g_hash_table_destroy(v->cells) ;
 
+  /*the cells and facets have been returned to the pools, whose slabs
+    can now go in one go unless some objects outlive the volume*/
+  object_pool_free(v->cell_pool) ;
+  object_pool_free(v->facet_pool) ;
+
   (*GTS_OBJECT_CLASS(gtv_volume_class ())->parent_class->destroy) (object);
 
   return ;
@@ -97,6 +236,15 @@ static void gtv_volume_init (GtvVolume * volume)
   volume->edge_class = gts_edge_class() ;
   volume->vertex_class = gts_vertex_class() ;
   volume->keep_cells = FALSE ;
+  volume->n_vertices = volume->n_edges = volume->n_facets = 0 ;
+  volume->seed = GTV_LOCATE_SEED ;
+  volume->grid = NULL ;
+  volume->cell_pool = object_pool_new() ;
+  volume->facet_pool = object_pool_new() ;
+
+  epoch_lock() ;
+  volumes_live = g_slist_prepend(volumes_live, volume) ;
+  epoch_unlock() ;
 }
 
 /** 
@@ -157,7 +305,34 @@ GtvVolume * gtv_volume_new(GtvVolumeClass * klass,
 }
 
 /** 
- * Add a GtvCell to a GtvVolume. 
+ * Set the seed of the random choices made by ::gtv_point_locate in a
+ * ::GtvVolume. Every call to ::gtv_point_locate starts its own
+ * generator from this seed, so that point location, and anything
+ * built on it such as Delaunay insertion, gives the same result on
+ * every run and does not depend on other calls, in this or in other
+ * threads. New volumes have a fixed default seed.
+ * 
+ * @param v a ::GtvVolume;
+ * @param seed seed for point location.
+ * 
+ * @return GTV_SUCCESS on success.
+ */
+
+gint gtv_volume_set_seed(GtvVolume *v, guint32 seed)
+
+{
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+
+  v->seed = seed ;
+
+  return GTV_SUCCESS ;
+}
+
+/** 
+ * Add a GtvCell to a GtvVolume. The neighbours of the cell in the
+ * volume are set, so that ::gtv_cell_neighbour can be used, and the
+ * vertex, edge and facet counts of the volume are updated.
  * 
  * @param v GtvVolume
  * @param c GtvCell
@@ -175,8 +350,15 @@ gint gtv_volume_add_cell(GtvVolume *v, GtvCell *c)
   g_return_val_if_fail(GTV_IS_CELL(c), GTV_WRONG_TYPE) ;
 
   if (!g_hash_table_lookup (v->cells, c)) {
+    /*a cell joining its first volume may carry stamps from before
+      the stamps of the live volumes were last cleared*/
+    if ( c->volumes == NULL )
+      epoch_clear_cell(GTV_TETRAHEDRON(c), NULL, NULL) ;
+    cell_count(c, v, 1) ;
     c->volumes = g_slist_prepend (c->volumes, v);
     g_hash_table_insert (v->cells, c, c);
+    cell_connect(c, v) ;
+    if ( v->grid != NULL ) locate_grid_insert(v, c) ;
   } else
     g_message("%s: cell %p already present", __FUNCTION__, c) ;
 
@@ -205,8 +387,11 @@ gint gtv_volume_remove_cell(GtvVolume *v, GtvCell *c)
   if ( !g_hash_table_lookup(v->cells, c) ) return GTV_SUCCESS ;
   
   g_hash_table_remove(v->cells, c) ;
+  if ( v->grid != NULL ) locate_grid_remove(v, c) ;
 
   c->volumes = g_slist_remove(c->volumes, v) ;
+  cell_disconnect(c, v) ;
+  cell_count(c, v, -1) ;
 
   if (!GTS_OBJECT_DESTROYED(c) &&
       !gtv_allow_floating_cells &&
@@ -282,7 +467,6 @@ gint gtv_volume_write(GtvVolume *v, FILE *f)
   guint n ;
   gpointer data[5] ;
   GHashTable *vi, *ei, *fi ;
-  GtvVolumeStats s ;
   
   g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
   g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
@@ -294,13 +478,11 @@ gint gtv_volume_write(GtvVolume *v, FILE *f)
   data[3] = ei = g_hash_table_new(NULL, NULL) ;
   data[4] = fi = g_hash_table_new(NULL, NULL) ;
 
-  gtv_volume_stats(v, &s) ;
-
   fprintf(f, "%u %u %u %u", 
-	  s.edges_per_vertex.n,
-	  s.facets_per_edge.n,
-	  s.cells_per_facet.n,
-	  s.n_cells) ;
+	  gtv_volume_vertex_number(v),
+	  gtv_volume_edge_number(v),
+	  gtv_volume_facet_number(v),
+	  gtv_volume_cell_number(v)) ;
   if (GTS_OBJECT (v)->klass->write)
     (*GTS_OBJECT (v)->klass->write) (GTS_OBJECT (v), f);  
   fputc('\n', f) ;
@@ -325,6 +507,8 @@ gint gtv_volume_write(GtvVolume *v, FILE *f)
 
 /** 
  * Read a volume from file, adding its cells to the GtvVolume \a v.
+ * This handles binary vertices and data written by derived classes;
+ * for large plain volumes, ::gtv_volume_read_ascii is much faster.
  * 
  * @param v GtvVolume to add cells to;
  * @param f GtsFile to read from.
@@ -502,10 +686,10 @@ guint gtv_volume_read(GtvVolume *v, GtsFile *f)
 		gts_file_error (f, "edge index `%d' is out of range `[1,%d]'", 
 				s3, ne);
 	      else {
-		GtvFacet * new_facet = gtv_facet_new (v->facet_class,
-						      edges[s1 - 1],
-						      edges[s2 - 1],
-						      edges[s3 - 1]);
+		GtvFacet * new_facet = volume_facet_new (v, v->facet_class,
+							 edges[s1 - 1],
+							 edges[s2 - 1],
+							 edges[s3 - 1]);
 
 		gts_file_next_token (f);
 		if (f->type != '\n')
@@ -565,11 +749,11 @@ guint gtv_volume_read(GtvVolume *v, GtsFile *f)
 				    f4, nf);
 		
 		  else {
-		    GtvCell * new_cell = gtv_cell_new (v->cell_class,
-						       facets[f1-1],
-						       facets[f2-1],
-						       facets[f3-1],
-						       facets[f4-1]);
+		    GtvCell * new_cell = volume_cell_new (v, v->cell_class,
+							  facets[f1-1],
+							  facets[f2-1],
+							  facets[f3-1],
+							  facets[f4-1]);
 
 		    gts_file_next_token (f);
 		    if (f->type != '\n')
@@ -603,6 +787,281 @@ guint gtv_volume_read(GtvVolume *v, GtsFile *f)
   return GTV_SUCCESS ;
 }
 
+#define READER_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+  FILE *f ;
+  gchar *buf, *p, *end ;
+  gsize size ;
+  guint line ;
+  gboolean eof ;
+} volume_reader_t ;
+
+static gchar *reader_line(volume_reader_t *r)
+
+/*
+  next line of input, NUL-terminated in place, or NULL at end of
+  file; the buffer is refilled in large blocks and grown if a line
+  does not fit
+*/
+
+{
+  gchar *line, *nl ;
+  gsize n ;
+
+  while ( (nl = memchr(r->p, '\n', r->end - r->p)) == NULL ) {
+    if ( r->eof ) {
+      if ( r->p == r->end ) return NULL ;
+      /*last line has no newline*/
+      nl = r->end ; break ;
+    }
+    n = r->end - r->p ;
+    if ( r->p == r->buf && n >= r->size - 1 ) {
+      r->size *= 2 ;
+      r->buf = g_realloc(r->buf, r->size) ;
+    } else
+      memmove(r->buf, r->p, n) ;
+    r->p = r->buf ; r->end = r->buf + n ;
+    n = fread(r->end, 1, r->size - 1 - n, r->f) ;
+    if ( n == 0 ) r->eof = TRUE ;
+    r->end += n ;
+  }
+
+  *nl = '\0' ; line = r->p ;
+  r->p = (nl == r->end ? r->end : nl + 1) ;
+  r->line ++ ;
+
+  return line ;
+}
+
+static gboolean reader_uint(gchar **s, guint *u)
+
+{
+  gchar *p = *s ;
+  guint x ;
+
+  while ( *p == ' ' || *p == '\t' || *p == '\r' ) p ++ ;
+  if ( *p < '0' || *p > '9' ) return FALSE ;
+  for ( x = 0 ; *p >= '0' && *p <= '9' ; p ++ ) x = 10*x + (*p - '0') ;
+  *u = x ; *s = p ;
+
+  return TRUE ;
+}
+
+static gboolean reader_index(gchar **s, guint n, guint *u)
+
+{
+  return (reader_uint(s, u) && *u >= 1 && *u <= n) ;
+}
+
+static gboolean reader_triangle(GtsEdge *e1, GtsEdge *e2, GtsEdge *e3)
+
+/*check that three edges can make a triangle, as gts_triangle_set needs*/
+
+{
+  GtsVertex *v1, *v2, *v3 ;
+
+  if ( e1 == e2 || e2 == e3 || e3 == e1 ) return FALSE ;
+
+  if ( (v1 = gts_segments_touch(GTS_SEGMENT(e1), GTS_SEGMENT(e2))) == NULL ||
+       (v2 = gts_segments_touch(GTS_SEGMENT(e2), GTS_SEGMENT(e3))) == NULL ||
+       (v3 = gts_segments_touch(GTS_SEGMENT(e3), GTS_SEGMENT(e1))) == NULL )
+    return FALSE ;
+
+  return (v1 != v2 && v2 != v3 && v3 != v1) ;
+}
+
+static gboolean reader_tetrahedron(GtvFacet *f1, GtvFacet *f2,
+				   GtvFacet *f3, GtvFacet *f4)
+
+/*check that four facets can make a tetrahedron, as
+  gtv_tetrahedron_set needs*/
+
+{
+  GtsTriangle *t[4] ;
+  GtsEdge *e[6] ;
+  gint i, j, k ;
+
+  t[0] = GTS_TRIANGLE(f1) ; t[1] = GTS_TRIANGLE(f2) ;
+  t[2] = GTS_TRIANGLE(f3) ; t[3] = GTS_TRIANGLE(f4) ;
+
+  for ( (i = 0), (k = 0) ; i < 4 ; i ++ ) {
+    for ( j = i+1 ; j < 4 ; j ++ ) {
+      if ( t[i] == t[j] ) return FALSE ;
+      if ( (e[k] = gts_triangles_common_edge(t[i], t[j])) == NULL )
+	return FALSE ;
+      k ++ ;
+    }
+  }
+
+  for ( i = 0 ; i < 6 ; i ++ )
+    for ( j = i+1 ; j < 6 ; j ++ ) if ( e[i] == e[j] ) return FALSE ;
+
+  return TRUE ;
+}
+
+static gboolean reader_double(gchar **s, gdouble *x)
+
+{
+  gchar *e ;
+
+  *x = strtod(*s, &e) ;
+  if ( e == *s ) return FALSE ;
+  *s = e ;
+
+  return TRUE ;
+}
+
+/** 
+ * Read a volume in the ASCII format written by ::gtv_volume_write,
+ * adding its cells to \a v. The input is read in large blocks and
+ * parsed in place, with the vertices, edges and facets held in arrays
+ * sized from the header, so this is much faster than
+ * ::gtv_volume_read on large files. Anything after the indices or
+ * coordinates on a line, such as data written by a derived class, is
+ * ignored, and volumes written with binary vertices cannot be read:
+ * use ::gtv_volume_read for those. On error, a message giving the
+ * line is logged and nothing is added to \a v.
+ * 
+ * @param v GtvVolume to add cells to;
+ * @param f file pointer to read from.
+ * 
+ * @return GTV_SUCCESS on success, otherwise the line number where the
+ * error occurred.
+ */
+
+guint gtv_volume_read_ascii(GtvVolume *v, FILE *f)
+
+{
+  volume_reader_t r ;
+  GtsVertex **vertices ;
+  GtsEdge **edges ;
+  GtvFacet **facets ;
+  GtvCell **cells ;
+  guint nv, ne, nf, nc, i, j[4], n[4] ;
+  gdouble x[3] ;
+  gchar *s, *err ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
+
+  r.f = f ; r.size = READER_BUFFER_SIZE ; r.line = 0 ; r.eof = FALSE ;
+  r.buf = r.p = r.end = g_malloc(r.size) ;
+
+  vertices = NULL ; edges = NULL ; facets = NULL ; cells = NULL ;
+  nv = ne = nf = nc = 0 ; n[0] = n[1] = n[2] = n[3] = 0 ;
+  err = NULL ;
+
+  if ( (s = reader_line(&r)) == NULL ||
+       !reader_uint(&s, &nv) || !reader_uint(&s, &ne) ||
+       !reader_uint(&s, &nf) || !reader_uint(&s, &nc) ) {
+    err = "expecting numbers of vertices, edges, facets and cells" ;
+    goto error ;
+  }
+  if ( strstr(s, "GtsVertexBinary") != NULL ) {
+    err = "binary vertices are not supported: use gtv_volume_read" ;
+    goto error ;
+  }
+
+  vertices = g_new(GtsVertex *, nv) ;
+  edges = g_new(GtsEdge *, ne) ;
+  facets = g_new(GtvFacet *, nf) ;
+  cells = g_new(GtvCell *, nc) ;
+
+  for ( ; n[0] < nv ; n[0] ++ ) {
+    if ( (s = reader_line(&r)) == NULL ||
+	 !reader_double(&s, &(x[0])) || !reader_double(&s, &(x[1])) ||
+	 !reader_double(&s, &(x[2])) ) {
+      err = "expecting vertex coordinates" ; goto error ;
+    }
+    vertices[n[0]] = gts_vertex_new(v->vertex_class, x[0], x[1], x[2]) ;
+  }
+
+  for ( ; n[1] < ne ; n[1] ++ ) {
+    if ( (s = reader_line(&r)) == NULL ||
+	 !reader_index(&s, nv, &(j[0])) || !reader_index(&s, nv, &(j[1])) ) {
+      err = "expecting two vertex indices in range" ; goto error ;
+    }
+    edges[n[1]] = gts_edge_new(v->edge_class,
+			       vertices[j[0]-1], vertices[j[1]-1]) ;
+  }
+
+  for ( ; n[2] < nf ; n[2] ++ ) {
+    if ( (s = reader_line(&r)) == NULL ||
+	 !reader_index(&s, ne, &(j[0])) || !reader_index(&s, ne, &(j[1])) ||
+	 !reader_index(&s, ne, &(j[2])) ) {
+      err = "expecting three edge indices in range" ; goto error ;
+    }
+    if ( !reader_triangle(edges[j[0]-1], edges[j[1]-1], edges[j[2]-1]) ) {
+      err = "edges do not form a triangle" ; goto error ;
+    }
+    facets[n[2]] = volume_facet_new(v, v->facet_class,
+				    edges[j[0]-1], edges[j[1]-1],
+				    edges[j[2]-1]) ;
+  }
+
+  for ( ; n[3] < nc ; n[3] ++ ) {
+    if ( (s = reader_line(&r)) == NULL ||
+	 !reader_index(&s, nf, &(j[0])) || !reader_index(&s, nf, &(j[1])) ||
+	 !reader_index(&s, nf, &(j[2])) || !reader_index(&s, nf, &(j[3])) ) {
+      err = "expecting four facet indices in range" ; goto error ;
+    }
+    if ( !reader_tetrahedron(facets[j[0]-1], facets[j[1]-1],
+			     facets[j[2]-1], facets[j[3]-1]) ) {
+      err = "facets do not form a tetrahedron" ; goto error ;
+    }
+    cells[n[3]] = volume_cell_new(v, v->cell_class,
+				  facets[j[0]-1], facets[j[1]-1],
+				  facets[j[2]-1], facets[j[3]-1]) ;
+  }
+
+  for ( i = 0 ; i < nc ; i ++ ) gtv_volume_add_cell(v, cells[i]) ;
+
+  g_free(vertices) ; g_free(edges) ; g_free(facets) ; g_free(cells) ;
+  g_free(r.buf) ;
+
+  return GTV_SUCCESS ;
+
+ error:
+  g_warning("%s: line %u: %s", __FUNCTION__, r.line, err) ;
+  /*destroying the vertices takes the edges, facets and cells with
+    them*/
+  gts_allow_floating_vertices = TRUE ;
+  for ( i = 0 ; i < n[0] ; i ++ ) 
+    gts_object_destroy(GTS_OBJECT(vertices[i])) ;
+  gts_allow_floating_vertices = FALSE ;
+  g_free(vertices) ; g_free(edges) ; g_free(facets) ; g_free(cells) ;
+  g_free(r.buf) ;
+
+  return (r.line > 0 ? r.line : 1) ;
+}
+
+static guint volume_epoch_next(void)
+
+/*
+  stamp for a new traversal of the vertices, edges or facets of a
+  volume; when the stamps run out, those of every live volume are
+  cleared and the count restarts
+*/
+
+{
+  GSList *i ;
+  guint epoch ;
+
+  epoch_lock() ;
+  if ( ++ volume_epoch > GTV_EPOCH_MAX ) {
+    for ( i = volumes_live ; i != NULL ; i = i->next )
+      g_hash_table_foreach(GTV_VOLUME(i->data)->cells,
+			   (GHFunc) epoch_clear_cell, NULL) ;
+    volume_epoch = 1 ;
+  }
+  epoch = volume_epoch ;
+  epoch_unlock() ;
+
+  return epoch ;
+}
+
 static void cell_foreach_cell(GtvCell *c, gpointer dummy, 
 			      gpointer *foreach_data)
 
@@ -646,30 +1105,32 @@ static void facet_foreach_cell(GtvTetrahedron *t, gpointer dummy,
 {
   GtsFunc func = (GtsFunc) foreach_data[0];
   gpointer data = foreach_data[1];
-  GHashTable *h = foreach_data[2];
+  guint epoch = GPOINTER_TO_UINT(foreach_data[2]) ;
 
-  if ( !g_hash_table_lookup (h, t->f1) ) {
+  if ( object_epoch(t->f1) != epoch ) {
+    object_epoch_set(t->f1, epoch) ;
     (*func) (t->f1, data) ;
-    g_hash_table_insert(h, t->f1, GINT_TO_POINTER(-1)) ;
   }
-  if ( !g_hash_table_lookup (h, t->f2) ) {
+  if ( object_epoch(t->f2) != epoch ) {
+    object_epoch_set(t->f2, epoch) ;
     (*func) (t->f2, data) ;
-    g_hash_table_insert(h, t->f2, GINT_TO_POINTER(-1)) ;
   }
-  if ( !g_hash_table_lookup (h, t->f3) ) {
+  if ( object_epoch(t->f3) != epoch ) {
+    object_epoch_set(t->f3, epoch) ;
     (*func) (t->f3, data) ;
-    g_hash_table_insert(h, t->f3, GINT_TO_POINTER(-1)) ;
   }
-  if ( !g_hash_table_lookup (h, t->f4) ) {
+  if ( object_epoch(t->f4) != epoch ) {
+    object_epoch_set(t->f4, epoch) ;
     (*func) (t->f4, data) ;
-    g_hash_table_insert(h, t->f4, GINT_TO_POINTER(-1)) ;
   }
 
   return ;
 }
 
 /** 
- * Execute a function for each facet of a GtvVolume. 
+ * Execute a function for each facet of a GtvVolume. Each facet is
+ * visited once, by marking it with a stamp unique to the traversal,
+ * so \a func must not itself loop over the facets of a volume.
  * 
  * @param v GtvVolume;
  * @param func a GtsFunc to be evaluated for each facet;
@@ -689,12 +1150,10 @@ gint gtv_volume_foreach_facet(GtvVolume *v, GtsFunc func, gpointer data)
 
   foreach_data[0] = func ; 
   foreach_data[1] = data ; 
-  foreach_data[2] = g_hash_table_new(NULL, NULL) ;
+  foreach_data[2] = GUINT_TO_POINTER(volume_epoch_next()) ;
 
   g_hash_table_foreach(v->cells, (GHFunc) facet_foreach_cell, foreach_data) ;
 
-  g_hash_table_destroy(foreach_data[2]) ;
-
   return GTV_SUCCESS ;
 }
 
@@ -704,48 +1163,33 @@ static void edge_foreach_cell(GtvTetrahedron *t, gpointer dummy,
 {
   GtsFunc func = (GtsFunc) foreach_data[0];
   gpointer data = foreach_data[1];
-  GHashTable *h = foreach_data[2];
-  GtsEdge *e ;
-
-  e = GTS_TRIANGLE(t->f1)->e1 ;
-  if ( !g_hash_table_lookup (h, e) ) {
-    (*func) (e, data) ;
-    g_hash_table_insert(h, e, GINT_TO_POINTER(-1)) ;
-  }
-  e = GTS_TRIANGLE(t->f1)->e2 ;
-  if ( !g_hash_table_lookup (h, e) ) {
-    (*func) (e, data) ;
-    g_hash_table_insert(h, e, GINT_TO_POINTER(-1)) ;
-  }
-  e = GTS_TRIANGLE(t->f1)->e3 ;
-  if ( !g_hash_table_lookup (h, e) ) {
-    (*func) (e, data) ;
-    g_hash_table_insert(h, e, GINT_TO_POINTER(-1)) ;
-  }
-  e = gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
-				GTS_TRIANGLE(t->f3)) ;
-  if ( !g_hash_table_lookup (h, e) ) {
-    (*func) (e, data) ;
-    g_hash_table_insert(h, e, GINT_TO_POINTER(-1)) ;
-  }
-  e = gts_triangles_common_edge(GTS_TRIANGLE(t->f3),
-				GTS_TRIANGLE(t->f4)) ;
-  if ( !g_hash_table_lookup (h, e) ) {
-    (*func) (e, data) ;
-    g_hash_table_insert(h, e, GINT_TO_POINTER(-1)) ;
-  }
-  e = gts_triangles_common_edge(GTS_TRIANGLE(t->f4),
-				GTS_TRIANGLE(t->f2)) ;
-  if ( !g_hash_table_lookup (h, e) ) {
-    (*func) (e, data) ;
-    g_hash_table_insert(h, e, GINT_TO_POINTER(-1)) ;
+  guint epoch = GPOINTER_TO_UINT(foreach_data[2]) ;
+  GtsEdge *e[6] ;
+  gint i ;
+
+  e[0] = GTS_TRIANGLE(t->f1)->e1 ;
+  e[1] = GTS_TRIANGLE(t->f1)->e2 ;
+  e[2] = GTS_TRIANGLE(t->f1)->e3 ;
+  e[3] = gts_triangles_common_edge(GTS_TRIANGLE(t->f2),
+				   GTS_TRIANGLE(t->f3)) ;
+  e[4] = gts_triangles_common_edge(GTS_TRIANGLE(t->f3),
+				   GTS_TRIANGLE(t->f4)) ;
+  e[5] = gts_triangles_common_edge(GTS_TRIANGLE(t->f4),
+				   GTS_TRIANGLE(t->f2)) ;
+
+  for ( i = 0 ; i < 6 ; i ++ ) {
+    if ( object_epoch(e[i]) == epoch ) continue ;
+    object_epoch_set(e[i], epoch) ;
+    (*func) (e[i], data) ;
   }
 
   return ;
 }
 
 /** 
- * Execute a function for each edge of a GtvVolume. 
+ * Execute a function for each edge of a GtvVolume. Each edge is
+ * visited once, by marking it with a stamp unique to the traversal,
+ * so \a func must not itself loop over the edges of a volume.
  * 
  * @param v GtvVolume;
  * @param func a GtsFunc to be evaluated for each edge;
@@ -765,12 +1209,10 @@ gint gtv_volume_foreach_edge(GtvVolume *v, GtsFunc func, gpointer data)
 
   foreach_data[0] = func ; 
   foreach_data[1] = data ; 
-  foreach_data[2] = g_hash_table_new(NULL, NULL) ;
+  foreach_data[2] = GUINT_TO_POINTER(volume_epoch_next()) ;
 
   g_hash_table_foreach(v->cells, (GHFunc) edge_foreach_cell, foreach_data) ;
 
-  g_hash_table_destroy(foreach_data[2]) ;
-
   return GTV_SUCCESS ;
 }
 
@@ -780,36 +1222,32 @@ static void vertex_foreach_cell(GtvTetrahedron *t, gpointer dummy,
 {
   GtsFunc func = (GtsFunc) foreach_data[0];
   gpointer data = foreach_data[1];
-  GHashTable *h = foreach_data[2];
-  GtsVertex *v1, *v2, *v3, *v4 ;
+  guint epoch = GPOINTER_TO_UINT(foreach_data[2]) ;
 
-  gtv_tetrahedron_vertices(t, &v1, &v2, &v3, &v4) ;
-
-  if ( !g_hash_table_lookup (h, v1)) {
-    (*func) (v1, data) ;
-    g_hash_table_insert(h, v1, GINT_TO_POINTER(-1)) ;
+  if ( object_epoch(t->v1) != epoch ) {
+    object_epoch_set(t->v1, epoch) ;
+    (*func) (t->v1, data) ;
   }
-
-  if ( !g_hash_table_lookup (h, v2)) {
-    (*func) (v2, data) ;
-    g_hash_table_insert(h, v2, GINT_TO_POINTER(-1)) ;
+  if ( object_epoch(t->v2) != epoch ) {
+    object_epoch_set(t->v2, epoch) ;
+    (*func) (t->v2, data) ;
   }
-
-  if ( !g_hash_table_lookup (h, v3)) {
-    (*func) (v3, data) ;
-    g_hash_table_insert(h, v3, GINT_TO_POINTER(-1)) ;
+  if ( object_epoch(t->v3) != epoch ) {
+    object_epoch_set(t->v3, epoch) ;
+    (*func) (t->v3, data) ;
   }
-
-  if ( !g_hash_table_lookup (h, v4)) {
-    (*func) (v4, data) ;
-    g_hash_table_insert(h, v4, GINT_TO_POINTER(-1)) ;
+  if ( object_epoch(t->v4) != epoch ) {
+    object_epoch_set(t->v4, epoch) ;
+    (*func) (t->v4, data) ;
   }
 
   return ;
 }
 
 /** 
- * Execute a function for each vertex of a GtvVolume. 
+ * Execute a function for each vertex of a GtvVolume. Each vertex is
+ * visited once, by marking it with a stamp unique to the traversal,
+ * so \a func must not itself loop over the vertices of a volume.
  * 
  * @param v GtvVolume;
  * @param func a GtsFunc to be evaluated for each vertex;
@@ -829,12 +1267,10 @@ gint gtv_volume_foreach_vertex(GtvVolume *v, GtsFunc func, gpointer data)
 
   foreach_data[0] = func ; 
   foreach_data[1] = data ; 
-  foreach_data[2] = g_hash_table_new(NULL, NULL) ;
+  foreach_data[2] = GUINT_TO_POINTER(volume_epoch_next()) ;
 
   g_hash_table_foreach(v->cells, (GHFunc) vertex_foreach_cell, foreach_data) ;
 
-  g_hash_table_destroy(foreach_data[2]) ;
-
   return GTV_SUCCESS ;
 }
 
@@ -1064,6 +1500,47 @@ gint gtv_volume_print_stats(GtvVolume *v, FILE *f)
   return GTV_SUCCESS ;
 }
 
+/**
+ * Allocation statistics for the pools from which the cells and
+ * facets made for a ::GtvVolume, by Delaunay insertion or by reading
+ * a file, are allocated.
+ *
+ * @param v a ::GtvVolume;
+ * @param cells_in_use on exit the number of pool cells in use (may be
+ * NULL);
+ * @param cells_peak on exit the largest number of pool cells there
+ * have been in use (may be NULL);
+ * @param facets_in_use as \a cells_in_use for facets (may be NULL);
+ * @param facets_peak as \a cells_peak for facets (may be NULL);
+ * @param bytes on exit the memory held by the pools (may be NULL).
+ *
+ * @return ::GTV_SUCCESS on success.
+ */
+
+gint gtv_volume_pool_stats(GtvVolume *v,
+			   gint *cells_in_use, gint *cells_peak,
+			   gint *facets_in_use, gint *facets_peak,
+			   gsize *bytes)
+
+{
+  object_pool_t *c, *f ;
+
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+
+  c = (object_pool_t *)(v->cell_pool) ;
+  f = (object_pool_t *)(v->facet_pool) ;
+
+  if ( cells_in_use != NULL ) *cells_in_use = c->in_use ;
+  if ( cells_peak != NULL ) *cells_peak = c->peak ;
+  if ( facets_in_use != NULL ) *facets_in_use = f->in_use ;
+  if ( facets_peak != NULL ) *facets_peak = f->peak ;
+  if ( bytes != NULL )
+    *bytes = (c->nslabs*c->size + f->nslabs*f->size)*POOL_SLAB_OBJECTS ;
+
+  return GTV_SUCCESS ;
+}
+
 static void volume_boundary(GtvFacet *f, gpointer *data)
 
 {
@@ -1131,42 +1608,75 @@ gdouble gtv_volume_volume(GtvVolume *v)
   return V ;
 }
 
-static void count_vertices(GtsVertex *v, guint *n) 
-
-{
-  (*n) ++ ;
-}
+/** 
+ * Number of vertices in a ::GtvVolume, which is kept up to date as
+ * cells are added and removed.
+ * 
+ * @param v a ::GtvVolume.
+ * 
+ * @return number of vertices used by the cells of \a v.
+ */
 
 guint gtv_volume_vertex_number(GtvVolume *v)
 
 {
-  guint n = 0 ;
+  g_return_val_if_fail(v != NULL, 0) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), 0) ;
 
-  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
-  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  return v->n_vertices ;
+}
+
+/** 
+ * Number of edges in a ::GtvVolume, which is kept up to date as
+ * cells are added and removed.
+ * 
+ * @param v a ::GtvVolume.
+ * 
+ * @return number of edges used by the cells of \a v.
+ */
 
-  gtv_volume_foreach_vertex(v, (GtsFunc)count_vertices, &n) ;
+guint gtv_volume_edge_number(GtvVolume *v)
 
-  return n ;
+{
+  g_return_val_if_fail(v != NULL, 0) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), 0) ;
+
+  return v->n_edges ;
 }
 
-static void count_cells(GtsVertex *v, guint *n) 
+/** 
+ * Number of facets in a ::GtvVolume, which is kept up to date as
+ * cells are added and removed.
+ * 
+ * @param v a ::GtvVolume.
+ * 
+ * @return number of facets used by the cells of \a v.
+ */
+
+guint gtv_volume_facet_number(GtvVolume *v)
 
 {
-  (*n) ++ ;
+  g_return_val_if_fail(v != NULL, 0) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), 0) ;
+
+  return v->n_facets ;
 }
 
+/** 
+ * Number of cells in a ::GtvVolume.
+ * 
+ * @param v a ::GtvVolume.
+ * 
+ * @return number of cells in \a v.
+ */
+
 guint gtv_volume_cell_number(GtvVolume *v)
 
 {
-  guint n = 0 ;
+  g_return_val_if_fail(v != NULL, 0) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), 0) ;
 
-  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
-  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
-
-  gtv_volume_foreach_cell(v, (GtsFunc)count_cells, &n) ;
-
-  return n ;
+  return g_hash_table_size(v->cells) ;
 }
 
 static gint nearest_vertex(GtsVertex *v, gpointer data[])
@@ -1335,7 +1845,7 @@ static gint msh_element_n_nodes(gint type)
 
 {
   switch (type) {
-  default: g_assert_not_reached() ; break ;
+  default: return -1 ; break ;
   case GTV_GMSH_ELEMENT_LINE: return 2 ; break ;
   case GTV_GMSH_ELEMENT_TRIANGLE: return 3 ; break ;
   case GTV_GMSH_ELEMENT_QUADRANGLE: return 4 ; break ;
@@ -1352,372 +1862,838 @@ static gint msh_element_n_nodes(gint type)
   case GTV_GMSH_ELEMENT_PYRAMID_2: return 5+8+1 ; break ;
   case GTV_GMSH_ELEMENT_POINT: return 1 ; break ;
   }
-  return GTV_SUCCESS ;
+  return -1 ;
 }
 
-static gint msh_read_element2(FILE *f, gint *i, gint *e,
-			      gint *tags,
-			      gint *nodes, gint *nn)
+typedef struct {
+  gint64 tag ;
+  gint32 i ;
+} msh_tag_t ;
+
+/*
+  state for parsing a gmsh file held in memory: the buffer is not
+  NUL-terminated, so all scanning is bounded by end
+*/
+
+typedef struct {
+  const gchar *buf, *p, *end ;
+  gboolean binary, swap, indexed ;
+  gchar *err ;
+  GtvMesh *m ;
+  /*node tags of the mesh vertices, and an array of vertex indices
+    indexed by tag if the tags are dense, otherwise the tags are
+    sorted for searching*/
+  msh_tag_t *tags ;
+  gint32 ntags, *index ;
+  gint64 max ;
+} msh_buffer_t ;
+
+static guint msh_line(msh_buffer_t *b)
 
 {
-  gint j, nt ;
-  
-  if ( fscanf(f, "%d", i) != 1) return -1 ;
-  if ( fscanf(f, "%d", e) != 1) return -1 ;
+  const gchar *p ;
+  guint n ;
 
-  *nn = msh_element_n_nodes(*e) ;
+  for ( (n = 1), (p = b->buf) ; p < b->p ; p ++ ) if ( *p == '\n' ) n ++ ;
 
-  if ( fscanf(f, "%d", &nt) != 1) return -1 ;
+  return n ;
+}
 
-  for ( j = 0 ; j < nt ; j ++ ) 
-    if ( fscanf(f, "%d", &(tags[j])) != 1) return -1 ;
+static void msh_skip_space(msh_buffer_t *b)
 
-  for ( j = 0 ; j < (*nn) ; j ++ )
-    if ( fscanf(f, "%d", &nodes[j]) != 1 ) return -1 ;
+{
+  while ( b->p < b->end && g_ascii_isspace(*(b->p)) ) b->p ++ ;
 
-  return GTV_SUCCESS ;
+  return ;
 }
 
-static gint msh_read_element1(FILE *f, gint *i, gint *e,
-			      gint *rp, gint *re,
-			      gint *nodes, gint *nn)
+static void msh_skip_line(msh_buffer_t *b)
 
 {
-  gint j ;
-  
-  if ( fscanf(f, "%d", i) != 1) return -1 ;
-  if ( fscanf(f, "%d", e) != 1) return -1 ;
+  const gchar *nl ;
 
-  if ( fscanf(f, "%d", rp) != 1 ) return -1 ;
-  if ( fscanf(f, "%d", re) != 1 ) return -1 ;
-  if ( fscanf(f, "%d", nn) != 1 ) return -1 ;
+  if ( (nl = memchr(b->p, '\n', b->end - b->p)) == NULL ) b->p = b->end ;
+  else b->p = nl + 1 ;
 
-  for ( j = 0 ; j < (*nn) ; j ++ )
-    if ( fscanf(f, "%d", &nodes[j]) != 1 ) return -1 ;
-
-  return GTV_SUCCESS ;
+  return ;
 }
 
-static gint msh_add_element(GtvVolume *v, GHashTable *h,
-			    gint elem, gint *nodes, gint nn)
-
-{
-  GtsVertex *w[32] ;
-  GtvCell *c ;
-
-  g_debug("%s: adding element of type %d", __FUNCTION__, elem) ;
-
-  switch (elem) {
-  case GTV_GMSH_ELEMENT_POINT: return GTV_SUCCESS ; break ;
-  case GTV_GMSH_ELEMENT_LINE: return GTV_SUCCESS ; break ;
-  case GTV_GMSH_ELEMENT_LINE_2: return GTV_SUCCESS ; break ;
-  case GTV_GMSH_ELEMENT_TRIANGLE: return GTV_SUCCESS ; break ;
-  case GTV_GMSH_ELEMENT_TRIANGLE_2: return GTV_SUCCESS ; break ;
-  case GTV_GMSH_ELEMENT_TETRAHEDRON:
-    w[0] = g_hash_table_lookup(h, GINT_TO_POINTER(nodes[0])) ;
-    w[1] = g_hash_table_lookup(h, GINT_TO_POINTER(nodes[1])) ;
-    w[2] = g_hash_table_lookup(h, GINT_TO_POINTER(nodes[2])) ;
-    w[3] = g_hash_table_lookup(h, GINT_TO_POINTER(nodes[3])) ;
-    if ( (c = GTV_CELL(gtv_tetrahedron_from_vertices(w[0], w[1], w[2], w[3])))
-	 == NULL )
-      /*our vertex order is the opposite of gmsh's so swap w[0] and w[1]*/
-      c = gtv_cell_new_from_vertices(gtv_cell_class(),
-				     gtv_facet_class(),
-				     gts_edge_class(),
-				     w[1], w[0], w[2], w[3]) ;
-    gtv_volume_add_cell(v, c) ;
-    g_debug("%s: added cell with vertices (%p,%p,%p,%p)",
-	    __FUNCTION__, w[1], w[0], w[2], w[3]) ;
-      return GTV_SUCCESS ; break ;
-    break ;
-  default: 
-    if ( elem <= 15 ) {
-      g_debug("%s: unimplemented GMSH element type %d", 
-	      __FUNCTION__, elem) ;
-      return GTV_SUCCESS ; break ;
-    } else {
-      g_debug("%s: unrecognized GMSH element type %d", 
-	      __FUNCTION__, elem) ;
-      return -1 ; break ;
-    }
-  }
-
-  return GTV_SUCCESS ;
-}
+static gboolean msh_word(msh_buffer_t *b, const gchar *w)
 
-static guint msh_read_file1(FILE *f, GtvVolume *v)
+/*check that the next token is w, and step over it*/
 
 {
-  gchar line[256] ;
-  guint lineno = 2 ;
-  gint i, j, np, ne, nv, elem, nn, data[32] ;
-  gint rp, re ;
-  GHashTable *h ;
-  gdouble x, y, z ;
+  gsize n = strlen(w) ;
 
-  if ( (nv = fscanf(f, "%d", &np)) != 1 ) {
-    g_debug("%s: error reading number of vertices", __FUNCTION__) ;
-    return lineno ;
-  }
-  lineno ++ ;
+  msh_skip_space(b) ;
+  if ( b->p + n > b->end || strncmp(b->p, w, n) != 0 ) return FALSE ;
+  if ( b->p + n < b->end && !g_ascii_isspace(b->p[n]) ) return FALSE ;
+  b->p += n ;
 
-  h = g_hash_table_new(NULL, NULL) ;
-  for ( i = 0 ; i < np ; i ++ ) {
-    nv = fscanf(f, "%d %lg %lg %lg", &j, &x, &y, &z) ;
-    if ( nv != 4 ) {
-      g_debug("%s: error reading vertex at line %u", __FUNCTION__, lineno) ;
-      return lineno ;    
-    }
-    if ( j <= 0 ) {
-      g_debug("%s: vertex index %d out of range at line %u", 
-	      __FUNCTION__, j, lineno) ;
-      return lineno ;    
-    }
-    
-    g_hash_table_insert(h, GINT_TO_POINTER(j), 
-			gts_vertex_new(GTV_VOLUME(v)->vertex_class, 
-				       x, y, z)) ;
-    lineno ++ ;
-  }
+  return TRUE ;
+}
 
-  g_debug("%s: %d vertices read", __FUNCTION__, np) ;
+static gboolean msh_token(msh_buffer_t *b, gchar *s, gsize len)
 
-  nv = fscanf(f, "%s", line) ; 
-  g_debug("%s: %s", __FUNCTION__, line) ;
-  if ( strcmp(line, "$ENDNOD") || nv == 0) {
-    g_debug("%s: no $ENDNOD marker found", __FUNCTION__) ;
-    return lineno ;        
-  }
-  lineno ++ ;
+/*copy the next token into s, NUL-terminated, failing if it is too long*/
 
-  nv = fscanf(f, "%s", line) ;
-  g_debug("%s: %s", __FUNCTION__, line) ;
-  if ( strcmp(line, "$ELM") ) {
-    g_debug("%s: no $ELM marker found", __FUNCTION__) ;
-    return lineno ;        
-  }
-  lineno ++ ;
+{
+  gsize n ;
+
+  msh_skip_space(b) ;
+  for ( n = 0 ; b->p + n < b->end && !g_ascii_isspace(b->p[n]) ; n ++ )
+    if ( n == len - 1 ) return FALSE ;
+  if ( n == 0 ) return FALSE ;
+  memcpy(s, b->p, n) ; s[n] = '\0' ;
+  b->p += n ;
+
+  return TRUE ;
+}
+
+static gboolean msh_binary(msh_buffer_t *b, gpointer x, gsize size)
+
+/*copy a binary value of size bytes into x, in native byte order*/
+
+{
+  guint8 *y = x, t ;
+  gsize i ;
+
+  if ( b->p + size > b->end ) return FALSE ;
+  memcpy(x, b->p, size) ;
+  b->p += size ;
+  if ( b->swap ) 
+    for ( i = 0 ; i < size/2 ; i ++ ) {
+      t = y[i] ; y[i] = y[size-1-i] ; y[size-1-i] = t ;
+    }
+
+  return TRUE ;
+}
 
-  nv = fscanf(f, "%d", &ne) ;
-  if ( nv == 0 ) {
-    g_debug("%s: error reading number of elements", __FUNCTION__) ;
-    return lineno ;
+static gboolean msh_int(msh_buffer_t *b, gint64 *i, gsize size)
+
+/*
+  an integer, in ASCII or as a binary int (size 4) or size_t (size 8)
+*/
+
+{
+  gint32 i32 ;
+  gboolean minus ;
+
+  if ( b->binary ) {
+    if ( size == sizeof(gint32) ) {
+      if ( !msh_binary(b, &i32, sizeof(gint32)) ) return FALSE ;
+      *i = i32 ;
+      return TRUE ;
+    }
+    return msh_binary(b, i, sizeof(gint64)) ;
   }
-  lineno ++ ;
 
-  for ( i = 0 ; i < ne ; i ++ ) {
-    if ( msh_read_element1(f, &j, &elem, &rp, &re, data, &nn) != 0 ) {
-      g_debug("%s: error reading element at line %u", __FUNCTION__, lineno) ;
-      return lineno ;
+  msh_skip_space(b) ;
+  if ( (minus = (b->p < b->end && *(b->p) == '-')) ) b->p ++ ;
+  if ( b->p == b->end || !g_ascii_isdigit(*(b->p)) ) return FALSE ;
+  for ( *i = 0 ; b->p < b->end && g_ascii_isdigit(*(b->p)) ; b->p ++ )
+    *i = 10*(*i) + (*(b->p) - '0') ;
+  if ( minus ) *i = -(*i) ;
+
+  return TRUE ;
+}
+
+static gboolean msh_ascii_int(msh_buffer_t *b, gint64 *i)
+
+/*section counts are written in ASCII, even in binary files*/
+
+{
+  gboolean binary = b->binary ;
+
+  b->binary = FALSE ;
+  if ( !msh_int(b, i, 0) ) { b->binary = binary ; return FALSE ; }
+  /*binary data start on the next line*/
+  if ( (b->binary = binary) ) msh_skip_line(b) ;
+
+  return TRUE ;
+}
+
+static gboolean msh_double(msh_buffer_t *b, gdouble *x)
+
+{
+  gchar s[64], *e ;
+
+  if ( b->binary ) return msh_binary(b, x, sizeof(gdouble)) ;
+
+  if ( !msh_token(b, s, 64) ) return FALSE ;
+  *x = g_ascii_strtod(s, &e) ;
+
+  return (*e == '\0') ;
+}
+
+static gboolean msh_skip_section(msh_buffer_t *b, const gchar *end)
+
+/*step over everything up to and including the marker end*/
+
+{
+  gsize n = strlen(end) ;
+
+  while ( (b->p = memchr(b->p, '$', b->end - b->p)) != NULL ) {
+    if ( b->p + n <= b->end && strncmp(b->p, end, n) == 0 ) {
+      b->p += n ;
+      return TRUE ;
     }
-    if ( msh_add_element(v, h, elem, data, nn) != 0 ) {
-      g_debug("%s: error adding element at line %u", __FUNCTION__, lineno) ;
-      return lineno ;
+    b->p ++ ;
+  }
+  b->p = b->end ;
+
+  return FALSE ;
+}
+
+static gboolean msh_node_add(msh_buffer_t *b, gint64 tag, gdouble *x)
+
+{
+  gint32 i ;
+
+  if ( tag <= 0 ) { b->err = "node tag out of range" ; return FALSE ; }
+  i = gtv_mesh_vertex_add(b->m, x[0], x[1], x[2]) ;
+  if ( b->ntags < b->m->nvmax ) {
+    b->ntags = b->m->nvmax ;
+    b->tags = g_renew(msh_tag_t, b->tags, b->ntags) ;
+  }
+  b->tags[i].tag = tag ; b->tags[i].i = i ;
+  b->max = MAX(b->max, tag) ;
+
+  return TRUE ;
+}
+
+static gint msh_tag_compare(gconstpointer a, gconstpointer b)
+
+{
+  const msh_tag_t *t1 = a, *t2 = b ;
+
+  if ( t1->tag == t2->tag ) return 0 ;
+
+  return (t1->tag < t2->tag ? -1 : 1) ;
+}
+
+static void msh_node_index(msh_buffer_t *b)
+
+/*
+  map node tags onto mesh vertices through an array if the tags are
+  reasonably dense, as they are in files written by gmsh, otherwise
+  sort them for binary search
+*/
+
+{
+  gint64 i ;
+
+  b->indexed = TRUE ;
+  if ( b->max <= 8*(gint64)(b->m->nv) + 1024 ) {
+    b->index = g_new(gint32, b->max+1) ;
+    for ( i = 0 ; i <= b->max ; i ++ ) b->index[i] = -1 ;
+    for ( i = 0 ; i < b->m->nv ; i ++ ) b->index[b->tags[i].tag] = i ;
+    return ;
+  }
+
+  qsort(b->tags, b->m->nv, sizeof(msh_tag_t), msh_tag_compare) ;
+
+  return ;
+}
+
+static gint32 msh_node(msh_buffer_t *b, gint64 tag)
+
+/*mesh vertex of a node tag, or -1 if there is no such node*/
+
+{
+  msh_tag_t key, *t ;
+
+  if ( tag <= 0 || tag > b->max ) return -1 ;
+  if ( b->index != NULL ) return b->index[tag] ;
+
+  key.tag = tag ;
+  t = bsearch(&key, b->tags, b->m->nv, sizeof(msh_tag_t), msh_tag_compare) ;
+
+  return (t == NULL ? -1 : t->i) ;
+}
+
+static gboolean msh_element_add(msh_buffer_t *b, gint type, gint64 *nodes)
+
+/*
+  add a tetrahedron to the mesh; other element types are ignored
+*/
+
+{
+  gint32 w[4] ;
+  gint i ;
+
+  if ( type != GTV_GMSH_ELEMENT_TETRAHEDRON ) return TRUE ;
+
+  for ( i = 0 ; i < 4 ; i ++ ) {
+    if ( (w[i] = msh_node(b, nodes[i])) < 0 ) {
+      b->err = "element refers to an unknown node" ; return FALSE ;
     }
-    lineno ++ ;
+  }
+  if ( w[0] == w[1] || w[0] == w[2] || w[0] == w[3] ||
+       w[1] == w[2] || w[1] == w[3] || w[2] == w[3] ) {
+    b->err = "tetrahedron has a repeated node" ; return FALSE ;
   }
 
-  g_hash_table_destroy(h) ;  
+  /*our vertex order is the opposite of gmsh's so swap w[0] and w[1]*/
+  gtv_mesh_cell_add(b->m, w[1], w[0], w[2], w[3]) ;
 
-  return GTV_SUCCESS ;
+  return TRUE ;
 }
 
+static gboolean msh_read_nodes(msh_buffer_t *b, gint64 n, gsize size)
 
-static guint msh_read_file2(FILE *f, GtvVolume *v)
+/*n nodes, each a tag followed by its coordinates (format 1 and 2)*/
 
 {
-  gchar line[256] ;
-  guint lineno = 2 ;
-  gint i, j, np, ne, nv, elem, ntags, data[32], tags[32] ;
-  gint ft, ds ;
-  gdouble version ;
-  GHashTable *h ;
-  gdouble x, y, z ;
+  gint64 i, tag ;
+  gdouble x[3] ;
 
-  if ( (nv = fscanf(f, "%lg %d %d", &version, &ft, &ds) ) != 3 ) {
-    g_debug("%s: error reading mesh format information", 
-	    __FUNCTION__) ;
-    return lineno ;
+  for ( i = 0 ; i < n ; i ++ ) {
+    if ( !msh_int(b, &tag, size) || !msh_double(b, &(x[0])) ||
+	 !msh_double(b, &(x[1])) || !msh_double(b, &(x[2])) ) {
+      b->err = "expecting node tag and coordinates" ; return FALSE ;
+    }
+    if ( !msh_node_add(b, tag, x) ) return FALSE ;
   }
-  if ( version != 2.0 && version != 2.1 && version != 2.2 ) {
-    g_debug("%s: file version (%lg) should be 2.0 or 2.1",  
-	    __FUNCTION__, version) ;
-    return lineno ;
+
+  return TRUE ;
+}
+
+static gboolean msh_read_elements1(msh_buffer_t *b)
+
+{
+  gint64 n, i, j, data[5], nodes[32] ;
+
+  if ( !msh_ascii_int(b, &n) ) {
+    b->err = "expecting number of elements" ; return FALSE ;
+  }
+
+  for ( i = 0 ; i < n ; i ++ ) {
+    /*number, type, physical region, elementary region, node count*/
+    for ( j = 0 ; j < 5 ; j ++ ) {
+      if ( !msh_int(b, &(data[j]), 0) ) {
+	b->err = "expecting element header" ; return FALSE ;
+      }
+    }
+    if ( data[4] < 0 || data[4] > 32 ) {
+      b->err = "element node count out of range" ; return FALSE ;
+    }
+    for ( j = 0 ; j < data[4] ; j ++ ) {
+      if ( !msh_int(b, &(nodes[j]), 0) ) {
+	b->err = "expecting element nodes" ; return FALSE ;
+      }
+    }
+    if ( data[1] == GTV_GMSH_ELEMENT_TETRAHEDRON && data[4] != 4 ) {
+      b->err = "tetrahedron does not have four nodes" ; return FALSE ;
+    }
+    if ( !msh_element_add(b, data[1], nodes) ) return FALSE ;
+  }
+
+  return TRUE ;
+}
+
+static gboolean msh_read_elements2(msh_buffer_t *b)
+
+{
+  gint64 n, i, j, k, nn, nf, data[3], tag, nodes[32] ;
+
+  if ( !msh_ascii_int(b, &n) ) {
+    b->err = "expecting number of elements" ; return FALSE ;
+  }
+
+  for ( i = 0 ; i < n ; ) {
+    /*binary elements come in blocks of one type with a header of
+      type, number of elements, number of tags; ASCII ones have a
+      number, type and number of tags on each line*/
+    if ( b->binary ) {
+      for ( j = 0 ; j < 3 ; j ++ ) {
+	if ( !msh_int(b, &(data[j]), sizeof(gint32)) ) {
+	  b->err = "expecting element block header" ; return FALSE ;
+	}
+      }
+      nf = data[1] ;
+    } else {
+      if ( !msh_int(b, &tag, 0) || !msh_int(b, &(data[0]), 0) || 
+	   !msh_int(b, &(data[2]), 0) ) {
+	b->err = "expecting element header" ; return FALSE ;
+      }
+      nf = 1 ;
+    }
+    if ( nf < 1 || i + nf > n || data[2] < 0 ) {
+      b->err = "invalid element block" ; return FALSE ;
+    }
+    if ( (nn = msh_element_n_nodes(data[0])) < 0 ) {
+      if ( b->binary ) {
+	b->err = "unrecognized element type" ; return FALSE ;
+      }
+      msh_skip_line(b) ; i ++ ;
+      continue ;
+    }
+    for ( k = 0 ; k < nf ; k ++ ) {
+      if ( b->binary && !msh_int(b, &tag, sizeof(gint32)) ) {
+	b->err = "expecting element number" ; return FALSE ;
+      }
+      for ( j = 0 ; j < data[2] ; j ++ ) {
+	if ( !msh_int(b, &tag, sizeof(gint32)) ) {
+	  b->err = "expecting element tags" ; return FALSE ;
+	}
+      }
+      for ( j = 0 ; j < nn ; j ++ ) {
+	if ( !msh_int(b, &(nodes[j]), sizeof(gint32)) ) {
+	  b->err = "expecting element nodes" ; return FALSE ;
+	}
+      }
+      if ( !msh_element_add(b, data[0], nodes) ) return FALSE ;
+    }
+    i += nf ;
   }
-  lineno ++ ;
 
-  g_debug("%s: file format %lg, file type %d, data size %d",  
-	  __FUNCTION__, version, ft, ds) ;
+  return TRUE ;
+}
+
+static gboolean msh_read_nodes4(msh_buffer_t *b)
 
-  nv = fscanf(f, "%s", line) ;
-  g_debug("%s: %s", __FUNCTION__, line) ;
-  if ( strcmp(line, "$EndMeshFormat") || nv == 0) {
-    g_debug("%s: no $EndMeshFormat marker found", __FUNCTION__) ;
-    return lineno ;        
+{
+  gint64 nb, n, i, j, k, data[4], tag ;
+  gdouble x[3], u ;
+  gsize start ;
+
+  if ( !msh_int(b, &nb, sizeof(gint64)) || !msh_int(b, &n, sizeof(gint64)) ||
+       !msh_int(b, &(data[0]), sizeof(gint64)) || 
+       !msh_int(b, &(data[1]), sizeof(gint64)) ) {
+    b->err = "expecting node section header" ; return FALSE ;
   }
-  lineno ++ ;
 
-  nv = fscanf(f, "%s", line) ;
-  g_debug("%s: %s", __FUNCTION__, line) ;
-  if ( strcmp(line, "$Nodes") || nv == 0) {
-    g_debug("%s: no $Nodes marker found", __FUNCTION__) ;
-    return lineno ;        
+  for ( i = 0 ; i < nb ; i ++ ) {
+    /*entity dimension, entity tag, parametric flag, number of nodes*/
+    if ( !msh_int(b, &(data[0]), sizeof(gint32)) ||
+	 !msh_int(b, &(data[1]), sizeof(gint32)) ||
+	 !msh_int(b, &(data[2]), sizeof(gint32)) ||
+	 !msh_int(b, &(data[3]), sizeof(gint64)) || data[3] < 0 ) {
+      b->err = "expecting node block header" ; return FALSE ;
+    }
+    /*all the tags of a block come before its coordinates*/
+    start = b->m->nv ;
+    for ( j = 0 ; j < data[3] ; j ++ ) {
+      if ( !msh_int(b, &tag, sizeof(gint64)) ) {
+	b->err = "expecting node tag" ; return FALSE ;
+      }
+      x[0] = x[1] = x[2] = 0.0 ;
+      if ( !msh_node_add(b, tag, x) ) return FALSE ;
+    }
+    for ( j = 0 ; j < data[3] ; j ++ ) {
+      if ( !msh_double(b, &(x[0])) || !msh_double(b, &(x[1])) ||
+	   !msh_double(b, &(x[2])) ) {
+	b->err = "expecting node coordinates" ; return FALSE ;
+      }
+      memcpy(gtv_mesh_vertex(b->m, start+j), x, 3*sizeof(gdouble)) ;
+      /*parametric coordinates are not used*/
+      for ( k = 0 ; data[2] != 0 && k < data[0] ; k ++ ) {
+	if ( !msh_double(b, &u) ) {
+	  b->err = "expecting parametric coordinates" ; return FALSE ;
+	}
+      }
+    }
   }
-  lineno ++ ;
 
-  nv = fscanf(f, "%d", &np) ;
-  if ( nv == 0 ) {
-    g_debug("%s: error reading number of vertices", __FUNCTION__) ;
-    return lineno ;
+  if ( b->m->nv != n ) {
+    b->err = "number of nodes does not match header" ; return FALSE ;
   }
 
-  lineno ++ ;
+  return TRUE ;
+}
 
-  h = g_hash_table_new(NULL, NULL) ;
-  for ( i = 0 ; i < np ; i ++ ) {
-    nv = fscanf(f, "%d %lg %lg %lg", &j, &x, &y, &z) ;
-    if ( nv != 4 ) {
-      g_debug("%s: error reading vertex at line %u", __FUNCTION__, lineno) ;
-      return lineno ;    
+static gboolean msh_read_elements4(msh_buffer_t *b)
+
+{
+  gint64 nb, n, i, j, k, nn, data[4], tag, nodes[32] ;
+
+  if ( !msh_int(b, &nb, sizeof(gint64)) || !msh_int(b, &n, sizeof(gint64)) ||
+       !msh_int(b, &(data[0]), sizeof(gint64)) || 
+       !msh_int(b, &(data[1]), sizeof(gint64)) ) {
+    b->err = "expecting element section header" ; return FALSE ;
+  }
+
+  for ( i = 0 ; i < nb ; i ++ ) {
+    /*entity dimension, entity tag, element type, number of elements*/
+    if ( !msh_int(b, &(data[0]), sizeof(gint32)) ||
+	 !msh_int(b, &(data[1]), sizeof(gint32)) ||
+	 !msh_int(b, &(data[2]), sizeof(gint32)) ||
+	 !msh_int(b, &(data[3]), sizeof(gint64)) || data[3] < 0 ) {
+      b->err = "expecting element block header" ; return FALSE ;
     }
-    if ( j <= 0 ) {
-      g_debug("%s: vertex index %d out of range at line %u", 
-	      __FUNCTION__, j, lineno) ;
-      return lineno ;    
+    if ( (nn = msh_element_n_nodes(data[2])) < 0 ) {
+      if ( b->binary ) {
+	b->err = "unrecognized element type" ; return FALSE ;
+      }
+      for ( j = 0 ; j <= data[3] ; j ++ ) msh_skip_line(b) ;
+      continue ;
+    }
+    for ( k = 0 ; k < data[3] ; k ++ ) {
+      if ( !msh_int(b, &tag, sizeof(gint64)) ) {
+	b->err = "expecting element tag" ; return FALSE ;
+      }
+      for ( j = 0 ; j < nn ; j ++ ) {
+	if ( !msh_int(b, &(nodes[j]), sizeof(gint64)) ) {
+	  b->err = "expecting element nodes" ; return FALSE ;
+	}
+      }
+      if ( !msh_element_add(b, data[2], nodes) ) return FALSE ;
     }
-    
-    g_hash_table_insert(h, GINT_TO_POINTER(j), 
-			gts_vertex_new(GTV_VOLUME(v)->vertex_class, 
-				       x, y, z)) ;
-    lineno ++ ;
-  }
-
-  g_debug("%s: %d vertices read", __FUNCTION__, np) ;
-
-  nv = fscanf(f, "%s", line) ; 
-  g_debug("%s: %s", __FUNCTION__, line) ;
-  if ( strcmp(line, "$EndNodes") || nv == 0) {
-    g_debug("%s: no $EndNodes marker found", __FUNCTION__) ;
-    return lineno ;        
-  }
-  lineno ++ ;
-
-  nv = fscanf(f, "%s", line) ;
-  g_debug("%s: %s", __FUNCTION__, line) ;
-  if ( strcmp(line, "$Elements") ) {
-    g_debug("%s: no $Elements marker found", __FUNCTION__) ;
-    return lineno ;        
-  }
-  lineno ++ ;
-
-  nv = fscanf(f, "%d", &ne) ;
-  if ( nv == 0 ) {
-    g_debug("%s: error reading number of elements", __FUNCTION__) ;
-    return lineno ;
-  } else 
-    g_debug("%s: %d elements expected", __FUNCTION__, ne) ;
-    
-  lineno ++ ;
-
-  for ( i = 0 ; i < ne ; i ++ ) {
-    if ( msh_read_element2(f, &j, &elem, tags, data, &ntags) != 0 ) {
-      g_debug("%s: error reading element at line %u", __FUNCTION__, lineno) ;
-      return lineno ;
+  }
+
+  return TRUE ;
+}
+
+static gboolean msh_read_format(msh_buffer_t *b, gint *version)
+
+/*$MeshFormat section, after the marker*/
+
+{
+  gchar s[16] ;
+  gint64 ft, ds ;
+  gint32 one ;
+
+  if ( !msh_token(b, s, 16) || !msh_int(b, &ft, 0) || !msh_int(b, &ds, 0) ) {
+    b->err = "expecting mesh format information" ; return FALSE ;
+  }
+
+  if ( strcmp(s, "2") == 0 || strncmp(s, "2.", 2) == 0 ) *version = 2 ;
+  else if ( strcmp(s, "4.1") == 0 ) *version = 4 ;
+  else {
+    b->err = "unsupported file version (should be 2.x or 4.1)" ;
+    return FALSE ;
+  }
+  if ( ds != sizeof(gdouble) ) {
+    b->err = "unsupported data size" ; return FALSE ;
+  }
+
+  if ( (b->binary = (ft == 1)) ) {
+    /*the integer 1, written in the byte order of the writer*/
+    msh_skip_line(b) ;
+    if ( !msh_binary(b, &one, sizeof(gint32)) ) {
+      b->err = "expecting byte order check" ; return FALSE ;
     }
-    g_debug("%s: line: %d; element %d; type %d", 
-	    __FUNCTION__, lineno, j, elem) ;
-    if ( msh_add_element(v, h, elem, data, ntags) != 0 ) {
-      g_debug("%s: error adding element at line %u", __FUNCTION__, lineno) ;
-      return lineno ;
+    if ( one != 1 ) {
+      b->swap = TRUE ;
+      if ( GUINT32_SWAP_LE_BE((guint32)one) != 1 ) {
+	b->err = "invalid byte order check" ; return FALSE ;
+      }
     }
-    lineno ++ ;
   }
 
-  g_hash_table_destroy(h) ;  
+  g_debug("%s: file format %s, file type %d, data size %d",
+	  __FUNCTION__, s, (gint)ft, (gint)ds) ;
 
-  return GTV_SUCCESS ;
+  if ( !msh_word(b, "$EndMeshFormat") ) {
+    b->err = "no $EndMeshFormat marker found" ; return FALSE ;
+  }
+
+  return TRUE ;
+}
+
+static gboolean msh_read_buffer(msh_buffer_t *b)
+
+{
+  gchar s[64] ;
+  gint64 n ;
+  gint version = 0 ;
+
+  /*find the start of the mesh*/
+  while ( version == 0 ) {
+    if ( !msh_token(b, s, 64) ) {
+      b->err = "unrecognized msh file format" ; return FALSE ;
+    }
+    if ( strcmp(s, "$NOD") == 0 ) version = 1 ;
+    if ( strcmp(s, "$MeshFormat") == 0 && !msh_read_format(b, &version) )
+      return FALSE ;
+  }
+
+  g_debug("%s: GMSH file format: %d", __FUNCTION__, version) ;
+
+  if ( version == 1 ) {
+    if ( !msh_ascii_int(b, &n) ) {
+      b->err = "expecting number of nodes" ; return FALSE ;
+    }
+    if ( !msh_read_nodes(b, n, 0) ) return FALSE ;
+    if ( !msh_word(b, "$ENDNOD") ) {
+      b->err = "no $ENDNOD marker found" ; return FALSE ;
+    }
+    msh_node_index(b) ;
+    if ( !msh_word(b, "$ELM") ) {
+      b->err = "no $ELM marker found" ; return FALSE ;
+    }
+    return msh_read_elements1(b) ;
+  }
+
+  /*sections other than nodes and elements are skipped*/
+  while ( msh_token(b, s, 60) ) {
+    if ( strcmp(s, "$Nodes") == 0 ) {
+      if ( b->indexed ) {
+	b->err = "more than one $Nodes section" ; return FALSE ;
+      }
+      /*binary data start on the line after the marker*/
+      if ( b->binary && version == 4 ) msh_skip_line(b) ;
+      if ( version == 2 ) {
+	if ( !msh_ascii_int(b, &n) ) {
+	  b->err = "expecting number of nodes" ; return FALSE ;
+	}
+	if ( !msh_read_nodes(b, n, sizeof(gint32)) ) return FALSE ;
+      } else {
+	if ( !msh_read_nodes4(b) ) return FALSE ;
+      }
+      if ( !msh_word(b, "$EndNodes") ) {
+	b->err = "no $EndNodes marker found" ; return FALSE ;
+      }
+      msh_node_index(b) ;
+      g_debug("%s: %d nodes read", __FUNCTION__, b->m->nv) ;
+      continue ;
+    }
+    if ( strcmp(s, "$Elements") == 0 ) {
+      if ( !b->indexed ) {
+	b->err = "$Elements section before $Nodes" ; return FALSE ;
+      }
+      if ( b->binary && version == 4 ) msh_skip_line(b) ;
+      if ( version == 2 && !msh_read_elements2(b) ) return FALSE ;
+      if ( version == 4 && !msh_read_elements4(b) ) return FALSE ;
+      if ( !msh_word(b, "$EndElements") ) {
+	b->err = "no $EndElements marker found" ; return FALSE ;
+      }
+      g_debug("%s: %d tetrahedra read", __FUNCTION__, b->m->nc) ;
+      continue ;
+    }
+    if ( s[0] != '$' ) {
+      b->err = "expecting section marker" ; return FALSE ;
+    }
+    /*$Name is closed by $EndName*/
+    memmove(&(s[4]), &(s[1]), strlen(s)) ;
+    memcpy(s, "$End", 4) ;
+    if ( !msh_skip_section(b, s) ) {
+      b->err = "unterminated section" ; return FALSE ;
+    }
+  }
+
+  msh_skip_space(b) ;
+  if ( b->p < b->end ) {
+    b->err = "section marker too long" ; return FALSE ;
+  }
+
+  return TRUE ;
+}
+
+static const gchar *msh_file_contents(FILE *f, gsize *len, gpointer *map)
+
+/*
+  the rest of f, mapped if it is a regular file and otherwise read
+  into memory; the mapping, or the memory, is returned in map for
+  release by msh_file_release
+*/
+
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+  GMappedFile *mf ;
+  glong off ;
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+  gchar *buf ;
+  gsize n, size ;
+
+#if GLIB_CHECK_VERSION(2,32,0)
+  if ( (off = ftell(f)) >= 0 &&
+       (mf = g_mapped_file_new_from_fd(fileno(f), FALSE, NULL)) != NULL ) {
+    if ( g_mapped_file_get_length(mf) >= (gsize)off ) {
+      *map = mf ; *len = g_mapped_file_get_length(mf) - off ;
+      if ( *len == 0 ) return "" ;
+      return g_mapped_file_get_contents(mf) + off ;
+    }
+    g_mapped_file_unref(mf) ;
+  }
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  size = READER_BUFFER_SIZE ; buf = g_malloc(size) ; *len = 0 ;
+  while ( (n = fread(&(buf[*len]), 1, size - *len, f)) > 0 ) {
+    *len += n ;
+    if ( *len == size ) buf = g_realloc(buf, (size *= 2)) ;
+  }
+  *map = NULL ;
+
+  return buf ;
+}
+
+static void msh_file_release(const gchar *buf, gpointer map)
+
+{
+#if GLIB_CHECK_VERSION(2,32,0)
+  if ( map != NULL ) { g_mapped_file_unref(map) ; return ; }
+#endif /*GLIB_CHECK_VERSION(2,32,0)*/
+
+  g_free((gchar *)buf) ;
+
+  return ;
 }
 
 /** 
  * Read a GMSH mesh file (.msh extension) from a file, adding its
- * elements to a ::GtvVolume.
+ * tetrahedra to a ::GtvVolume. Files in the old format 1, and in
+ * formats 2.x and 4.1, ASCII or binary, can be read. Other element
+ * types are skipped. The rest of \a f is mapped into memory if it is
+ * a regular file, and read in otherwise, and is parsed directly. Node
+ * tags are mapped onto vertices through an array if they are dense
+ * (as written by gmsh) and the cells are built from a table of their
+ * facets using ::gtv_mesh_to_volume, so the volume is not searched as
+ * it is built. On error, a message is logged and nothing is added to
+ * \a v.
  * 
  * @param f input file;
- * @param v a ::GtvVolume.
+ * @param v a ::GtvVolume;
+ * @param line if not NULL, on exit the line where a read error was
+ * found (approximate for binary files), or 0 if there was none.
  * 
- * @return ::GTV_SUCCESS on success.
+ * @return ::GTV_SUCCESS on success, ::GTV_UNKNOWN_FORMAT if the file
+ * could not be read, or the error code of ::gtv_mesh_to_volume if
+ * the elements do not make valid cells.
  */
 
-guint gtv_volume_read_gmsh(FILE *f, GtvVolume *v)
+gint gtv_volume_read_gmsh(FILE *f, GtvVolume *v, guint *line)
 
 {
-  gchar line[256] ;
-  gint gmsh_format, nf  ;
-  
+  msh_buffer_t b ;
+  gpointer map ;
+  gsize len ;
+  gint status ;
+
+  if ( line != NULL ) *line = 0 ;
   g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
   g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
   g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
 
-  gmsh_format = 0 ; nf = 1 ;
-
-  while ( gmsh_format == 0 && nf != 0 ) {
-    if ( (nf = fscanf(f, "%s", line)) != 0 ) {
-      if ( strncmp(line, "$NOD", 4) == 0 ) gmsh_format = 1 ;
-      if ( strncmp(line, "$MeshFormat", 11) == 0 ) gmsh_format = 2 ;
-    }
+  b.buf = b.p = msh_file_contents(f, &len, &map) ;
+  b.end = b.buf + len ;
+  b.binary = b.swap = b.indexed = FALSE ; b.err = NULL ;
+  b.m = gtv_mesh_new(0, 0) ;
+  b.tags = NULL ; b.ntags = 0 ; b.index = NULL ; b.max = 0 ;
+
+  if ( !msh_read_buffer(&b) ) {
+    status = GTV_UNKNOWN_FORMAT ;
+    g_warning("%s: line %u: %s", __FUNCTION__, msh_line(&b), b.err) ;
+    if ( line != NULL ) *line = msh_line(&b) ;
+  } else {
+    if ( (status = gtv_mesh_to_volume(b.m, v)) != GTV_SUCCESS )
+      g_warning("%s: elements could not be converted to cells",
+		__FUNCTION__) ;
   }
 
-  if ( gmsh_format == 0 ) {
-    g_warning("%s: unrecognized msh file format", __FUNCTION__) ;
-    return GTV_UNKNOWN_FORMAT ;
-  }
+  g_free(b.index) ; g_free(b.tags) ;
+  gtv_mesh_free(b.m) ;
+  msh_file_release(b.buf, map) ;
 
-  g_debug("%s: GMSH file format: %d", __FUNCTION__, gmsh_format) ;
+  return status ;
+}
 
-  if ( gmsh_format == 1 ) return msh_read_file1(f, v) ;
+#define GMSH_WRITE_BUFFER_SIZE (1 << 20)
 
-  if ( gmsh_format == 2 ) return msh_read_file2(f, v) ;
+/*
+  output for gmsh files, collected in a large buffer and written in
+  blocks; numbers are written in binary or in ASCII followed by a
+  separator
+*/
 
-  g_assert_not_reached() ;
+typedef struct {
+  FILE *f ;
+  gchar *buf ;
+  gsize n ;
+  gboolean binary ;
+} gmsh_writer_t ;
 
-  return GTV_SUCCESS ;
+/*index of a vertex in the file, held while the file is written*/
+#define gmsh_vertex_index(_v) GPOINTER_TO_INT(GTS_OBJECT(_v)->reserved)
+
+static void gmsh_flush(gmsh_writer_t *w)
+
+{
+  if ( w->n > 0 ) fwrite(w->buf, 1, w->n, w->f) ;
+  w->n = 0 ;
+
+  return ;
 }
 
-static void gmsh_write_vertex(GtsVertex *v, gpointer *data)
+static void gmsh_bytes(gmsh_writer_t *w, gconstpointer p, gsize n)
 
 {
-  FILE *f = (FILE *)data[0] ;
-  GHashTable *h = (GHashTable *)data[1] ;
-  gint *n = (gint *)data[2] ;
+  if ( w->n + n > GMSH_WRITE_BUFFER_SIZE ) gmsh_flush(w) ;
+  memcpy(&(w->buf[w->n]), p, n) ;
+  w->n += n ;
 
-  fprintf(f, "%d %g %g %g\n", (*n),
-	  GTS_POINT(v)->x, GTS_POINT(v)->y, GTS_POINT(v)->z) ;
+  return ;
+}
 
-  g_hash_table_insert(h, v, GINT_TO_POINTER(*n)) ;
+static void gmsh_string(gmsh_writer_t *w, const gchar *s)
 
-  (*n) ++ ;
+{
+  gmsh_bytes(w, s, strlen(s)) ;
+
+  return ;
+}
+
+static void gmsh_int(gmsh_writer_t *w, gint32 i, gchar sep)
+
+/*i is not negative*/
+
+{
+  gchar s[16] ;
+  gint n = 16 ;
+
+  if ( w->binary ) { gmsh_bytes(w, &i, sizeof(gint32)) ; return ; }
+
+  s[--n] = sep ;
+  do { s[--n] = '0' + i%10 ; i /= 10 ; } while ( i > 0 ) ;
+  gmsh_bytes(w, &(s[n]), 16-n) ;
 
   return ;
 }
 
-static void gmsh_write_cell1(GtvCell *c, gpointer *data)
+static void gmsh_double(gmsh_writer_t *w, gdouble x, gchar sep)
+
+/*
+  in ASCII, the shorter of 15 and 17 significant digits which reads
+  back as x exactly
+*/
 
 {
-  FILE *f = (FILE *)data[0] ;
-  GHashTable *h = (GHashTable *)data[1] ;
-  gint *n = (gint *)data[2] ;
-  GtsVertex *v1, *v2, *v3, *v4 ;
+  gchar s[G_ASCII_DTOSTR_BUF_SIZE+1] ;
+  gsize n ;
 
-  gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &v1, &v2, &v3, &v4) ;
+  if ( w->binary ) { gmsh_bytes(w, &x, sizeof(gdouble)) ; return ; }
+
+  g_ascii_formatd(s, G_ASCII_DTOSTR_BUF_SIZE, "%.15g", x) ;
+  if ( g_ascii_strtod(s, NULL) != x )
+    g_ascii_formatd(s, G_ASCII_DTOSTR_BUF_SIZE, "%.17g", x) ;
+  n = strlen(s) ; s[n] = sep ;
+  gmsh_bytes(w, s, n+1) ;
+
+  return ;
+}
+
+static void gmsh_write_vertex(GtsVertex *v, gpointer *data)
+
+{
+  gmsh_writer_t *w = (gmsh_writer_t *)data[0] ;
+  gint *n = (gint *)data[1] ;
 
-  fprintf(f, "%d 4 0 0 4", *n) ;
-  fprintf(f, " %d %d %d %d\n",
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v1)),
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v2)),
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v3)),
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v4))) ;
-  
   (*n) ++ ;
+  GTS_OBJECT(v)->reserved = GINT_TO_POINTER(*n) ;
+
+  gmsh_int(w, *n, ' ') ;
+  gmsh_double(w, GTS_POINT(v)->x, ' ') ;
+  gmsh_double(w, GTS_POINT(v)->y, ' ') ;
+  gmsh_double(w, GTS_POINT(v)->z, '\n') ;
+
+  return ;
+}
+
+static void gmsh_clear_vertex(GtsVertex *v, gpointer *data)
+
+{
+  GTS_OBJECT(v)->reserved = NULL ;
 
   return ;
 }
@@ -1725,25 +2701,101 @@ static void gmsh_write_cell1(GtvCell *c, gpointer *data)
 static void gmsh_write_cell(GtvCell *c, gpointer *data)
 
 {
-  FILE *f = (FILE *)data[0] ;
-  GHashTable *h = (GHashTable *)data[1] ;
-  gint *n = (gint *)data[2] ;
+  gmsh_writer_t *w = (gmsh_writer_t *)data[0] ;
+  gint *n = (gint *)data[1] ;
+  gint format = *((gint *)data[2]) ;
   GtsVertex *v1, *v2, *v3, *v4 ;
 
   gtv_tetrahedron_vertices(GTV_TETRAHEDRON(c), &v1, &v2, &v3, &v4) ;
 
-  fprintf(f, "%d 4 0", *n) ;
-  fprintf(f, " %d %d %d %d\n",
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v1)),
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v2)),
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v3)),
-	  GPOINTER_TO_INT(g_hash_table_lookup(h, v4))) ;
-  
   (*n) ++ ;
+  gmsh_int(w, *n, ' ') ;
+  /*binary elements are written in blocks under a single header*/
+  if ( format == 1 ) gmsh_string(w, "4 0 0 4 ") ;
+  else if ( !w->binary ) gmsh_string(w, "4 0 ") ;
+
+  /*our vertex order is the opposite of gmsh's so swap v1 and v2*/
+  gmsh_int(w, gmsh_vertex_index(v2), ' ') ;
+  gmsh_int(w, gmsh_vertex_index(v1), ' ') ;
+  gmsh_int(w, gmsh_vertex_index(v3), ' ') ;
+  gmsh_int(w, gmsh_vertex_index(v4), '\n') ;
 
   return ;
 }
 
+static gint volume_write_gmsh(GtvVolume *v, FILE *f, gint format,
+			      gboolean binary)
+
+/*
+  vertices are numbered from 1 in the order they are written, the
+  number being kept in the vertex reserved field until the cells have
+  been written
+*/
+
+{
+  gmsh_writer_t w ;
+  gpointer data[3] ;
+  gchar s[64] ;
+  gint32 h[3] ;
+  gint n ;
+
+  w.f = f ; w.buf = g_malloc(GMSH_WRITE_BUFFER_SIZE) ; w.n = 0 ;
+  w.binary = FALSE ;
+  data[0] = &w ; data[1] = &n ; data[2] = &format ;
+
+  if ( format == 1 ) {
+    g_snprintf(s, 64, "$NOD\n%u\n", gtv_volume_vertex_number(v)) ;
+    gmsh_string(&w, s) ;
+  } else {
+    g_snprintf(s, 64, "$MeshFormat\n2.2 %d %d\n", 
+	       (binary ? 1 : 0), (gint)sizeof(gdouble)) ;
+    gmsh_string(&w, s) ;
+    if ( binary ) {
+      /*for the reader to check the byte order*/
+      h[0] = 1 ; gmsh_bytes(&w, h, sizeof(gint32)) ; gmsh_string(&w, "\n") ;
+    }
+    g_snprintf(s, 64, "$EndMeshFormat\n$Nodes\n%u\n", 
+	       gtv_volume_vertex_number(v)) ;
+    gmsh_string(&w, s) ;
+  }
+
+  n = 0 ; w.binary = binary ;
+  gtv_volume_foreach_vertex(v, (GtsFunc)gmsh_write_vertex, data) ;
+  w.binary = FALSE ;
+  if ( binary ) gmsh_string(&w, "\n") ;
+
+  if ( format == 1 ) 
+    g_snprintf(s, 64, "$ENDNOD\n$ELM\n%u\n", gtv_volume_cell_number(v)) ;
+  else
+    g_snprintf(s, 64, "$EndNodes\n$Elements\n%u\n", 
+	       gtv_volume_cell_number(v)) ;
+  gmsh_string(&w, s) ;
+
+  if ( binary && gtv_volume_cell_number(v) > 0 ) {
+    /*element type, number of elements, number of tags*/
+    h[0] = GTV_GMSH_ELEMENT_TETRAHEDRON ; h[1] = gtv_volume_cell_number(v) ;
+    h[2] = 0 ;
+    gmsh_bytes(&w, h, 3*sizeof(gint32)) ;
+  }
+  n = 0 ; w.binary = binary ;
+  gtv_volume_foreach_cell(v, (GtsFunc)gmsh_write_cell, data) ;
+  w.binary = FALSE ;
+  if ( binary ) gmsh_string(&w, "\n") ;
+
+  gmsh_string(&w, (format == 1 ? "$ENDELM\n" : "$EndElements\n")) ;
+  gmsh_flush(&w) ;
+  g_free(w.buf) ;
+
+  gtv_volume_foreach_vertex(v, (GtsFunc)gmsh_clear_vertex, NULL) ;
+
+  if ( ferror(f) ) {
+    g_warning("%s: write error", __FUNCTION__) ;
+    return GTV_FAILURE ;
+  }
+
+  return GTV_SUCCESS ;
+}
+
 /** 
  * Write a ::GtvVolume to file as a GMSH .msh (format 1.0, deprecated)
  * file.
@@ -1751,91 +2803,59 @@ static void gmsh_write_cell(GtvCell *c, gpointer *data)
  * @param v a ::GtvVolume;
  * @param f file to which \a v is to be written.
  * 
- * @return ::GTV_SUCCESS on success.
+ * @return ::GTV_SUCCESS on success, ::GTV_FAILURE on a write error.
  */
 
 gint gtv_volume_write_gmsh1(GtvVolume *v, FILE *f)
 
 {
-  gpointer data[4] ;
-  GtvVolumeStats s ;
-  gint n ;
-
   g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
   g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
   g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
 
-  gtv_volume_stats(v, &s) ;
-
-  data[0] = f ;
-  data[1] = g_hash_table_new(NULL, NULL) ;
-  data[2] = &n ;
-
-  fprintf(f, "$NOD\n") ;
-  fprintf(f, "%d\n", s.edges_per_vertex.n) ;
-  n = 0 ;
-  gtv_volume_foreach_vertex(v, (GtsFunc)gmsh_write_vertex, data) ;
-  fprintf(f, "$ENDNOD\n") ;
-  fprintf(f, "$ELM\n") ;
-  fprintf(f, "%d\n", s.n_cells) ;
-  n = 0 ;
-  gtv_volume_foreach_cell(v, (GtsFunc)gmsh_write_cell1, data) ;
-  fprintf(f, "$ENDELM\n") ;
-
-  g_hash_table_destroy(data[1]) ;
-  
-  return GTV_SUCCESS ;
+  return volume_write_gmsh(v, f, 1, FALSE) ;
 }
 
 /** 
- * Write a ::GtvVolume to file as a GMSH .msh (format 2.0, favoured)
- * file.
+ * Write a ::GtvVolume to file as an ASCII GMSH .msh (format 2.2)
+ * file. Coordinates are written with enough digits to be read back
+ * exactly.
  * 
  * @param v a ::GtvVolume;
  * @param f file to which \a v is to be written.
  * 
- * @return ::GTV_SUCCESS on success.
+ * @return ::GTV_SUCCESS on success, ::GTV_FAILURE on a write error.
  */
 
 gint gtv_volume_write_gmsh(GtvVolume *v, FILE *f)
 
 {
-  gpointer data[4] ;
-  GtvVolumeStats s ;
-  gint n ;
-
   g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
   g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
   g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
 
-  gtv_volume_stats(v, &s) ;
-
-  data[0] = f ;
-  data[1] = g_hash_table_new(NULL, NULL) ;
-  data[2] = &n ;
-
-  fprintf(f, "$MeshFormat\n2.0 0 %lu\n$EndMeshFormat\n",
-	  sizeof(gdouble)) ;
+  return volume_write_gmsh(v, f, 2, FALSE) ;
+}
 
-  n = 0 ;
-  fprintf(f, "$Nodes\n%d\n", s.edges_per_vertex.n) ;
-  gtv_volume_foreach_vertex(v, (GtsFunc)gmsh_write_vertex, data) ;
-  fprintf(f, "$EndNodes\n") ;
+/** 
+ * Write a ::GtvVolume to file as a binary GMSH .msh (format 2.2, file
+ * type 1) file, in the byte order of the machine.
+ * 
+ * @param v a ::GtvVolume;
+ * @param f file to which \a v is to be written, opened for binary
+ * writing.
+ * 
+ * @return ::GTV_SUCCESS on success, ::GTV_FAILURE on a write error.
+ */
 
-  n = 0 ;
-  fprintf(f, "$Elements\n") ;
-  fprintf(f, "%d\n", s.n_cells) ;
-  gtv_volume_foreach_cell(v, (GtsFunc)gmsh_write_cell, data) ;
-  fprintf(f, "$EndElements\n") ;
+gint gtv_volume_write_gmsh_binary(GtvVolume *v, FILE *f)
 
-  /*   fprintf(f, "$PhysicalNames\n0\n$EndPhysicalNames\n") ; */
-  /*   fprintf(f, "$NodeData\n0\n$EndNodeData\n") ; */
-  /*   fprintf(f, "$ElementData\n0\n$EndElementData\n") ; */
-  /*   fprintf(f, "$ElementNodeData\n0\n$EndElementNodeData\n") ; */
+{
+  g_return_val_if_fail(v != NULL, GTV_NULL_ARGUMENT) ;
+  g_return_val_if_fail(GTV_IS_VOLUME(v), GTV_WRONG_TYPE) ;
+  g_return_val_if_fail(f != NULL, GTV_NULL_ARGUMENT) ;
 
-  g_hash_table_destroy(data[1]) ;
-  
-  return GTV_SUCCESS ;
+  return volume_write_gmsh(v, f, 2, TRUE) ;
 }
 
 static void bbox_foreach_vertex (GtsPoint * p, GtsBBox * bb)
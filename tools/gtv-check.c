@@ -44,7 +44,7 @@ gint main(gint argc, gchar **argv)
 {
   GtvVolume *v ;
   FILE *input ;
-  GtsFile *fid ;
+  guint line ;
   gchar ch ;
   GLogLevelFlags log_level ;
   gboolean verbose ;
@@ -85,9 +85,10 @@ gint main(gint argc, gchar **argv)
   input = stdin ;
   /* output = stdout ; */
 
-  fid = gts_file_new(input) ;
-
-  gtv_volume_read(v, fid) ;
+  if ( (line = gtv_volume_read_ascii(v, input)) != 0 ) {
+    fprintf(stderr, "%s: error in input at line %u\n", argv[0], line) ;
+    return 1 ;
+  }
 
   if ( verbose ) gtv_volume_print_stats(v, stderr) ;
 
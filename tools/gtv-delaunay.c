@@ -73,13 +73,11 @@ gint main(gint argc, gchar **argv)
 {
   GtvVolume *v ;
   GtvCell *c ;
-  GtsVertex *p = NULL, *v1, *v2, *v3, *v4 ;
-  gint i ;
+  GtsVertex *v1, *v2, *v3, *v4 ;
   GSList *j, *cells ;
   GPtrArray *vertices ;
   gdouble len ;
   FILE *input, *output ;
-  GtsFile *fid ;
   gboolean remove_hull, check_delaunay, read_volume, 
     write_volume, write_times ;
   /* gboolean delete_last_vertex ; */
@@ -88,12 +86,13 @@ gint main(gint argc, gchar **argv)
   GLogLevelFlags log_level ;
   GTimer *timer ;
   guint line ;
+  gint n_threads ;
 
-  len = 4.0 ; log_level = G_LOG_LEVEL_MESSAGE ;
+  len = 4.0 ; log_level = G_LOG_LEVEL_MESSAGE ; n_threads = 1 ;
   remove_hull = FALSE ; check_delaunay = FALSE ;
   write_volume = TRUE ; read_volume = FALSE ; write_times = FALSE ;
   /* delete_last_vertex = FALSE ; */
-  while ( (ch = getopt(argc, argv, "cdDhl:L:rt:Tw")) != EOF ) {
+  while ( (ch = getopt(argc, argv, "bcdDhj:l:L:rt:Tw")) != EOF ) {
     switch (ch) {
     default: 
     case 'h':
@@ -104,9 +103,11 @@ gint main(gint argc, gchar **argv)
 	      "list of points\n\n") ;
       fprintf(stderr, 
 	      "Options: \n"
+	      "  -b insert vertices by Bowyer-Watson cavity retriangulation\n"
 	      "  -c check that the tetrahedralization is Delaunay\n"
 	      "  -d check an existing tetrahedralized volume is Delaunay\n"
 	      "  -h print this message and exit\n"
+	      "  -j# insert vertices using # threads\n"
 	      "  -l# set the coordinate for the enclosing tetrahedron\n"
 	      "  -L# set the message logging level\n"
 	      "  -r remove the enclosing tetrahedron vertices at the end\n"
@@ -117,8 +118,10 @@ gint main(gint argc, gchar **argv)
 	      ) ;
       return 0 ;
       break ;
+    case 'b': gtv_delaunay_cavity_insertion = TRUE ; break ;
     case 'c': check_delaunay = TRUE ; break ;
     case 'd': read_volume = check_delaunay = TRUE ; break ;
+    case 'j': n_threads = atoi(optarg) ; break ;
     case 'l': len = atof(optarg) ; break ;
     case 'L': log_level = 1 << atoi(optarg) ; break ;
     case 'r': remove_hull = TRUE ; break ;
@@ -149,8 +152,11 @@ gint main(gint argc, gchar **argv)
     fprintf(stderr, "%s: reading input data: t=%lgs\n", 
 	    argv[0], g_timer_elapsed(timer, NULL)) ;
   if ( read_volume ) {
-    fid = gts_file_new(input) ;
-    gtv_volume_read(v, fid) ;
+    line = gtv_volume_read_ascii(v, input) ;
+    if ( line > 0 ) {
+      fprintf(stderr, "%s: error in input at line %u\n", argv[0], line) ;
+      return 1 ;
+    }
   } else {
     vertices = g_ptr_array_new() ;
     
@@ -173,13 +179,10 @@ gint main(gint argc, gchar **argv)
     if ( write_times ) 
       fprintf(stderr, "%s: beginning tetrahedralization: t=%lgs\n", 
 	      argv[0], g_timer_elapsed(timer, NULL)) ;
-    for ( i = 0 ; i < vertices->len ; i ++ ) {
-      p = GTS_VERTEX(g_ptr_array_index(vertices, i)) ;
-      if ( gtv_delaunay_add_vertex(v, p, NULL) == GTV_VERTEX_NOT_IN_VOLUME )
-	fprintf(stderr,
-		"vertex (%lg,%lg,%lg) not inside convex hull\n",
-		GTS_POINT(p)->x, GTS_POINT(p)->y, GTS_POINT(p)->z) ;
-    }
+    if ( gtv_delaunay_build_parallel(v, vertices, MAX(n_threads, 1))
+	 == GTV_VERTEX_NOT_IN_VOLUME )
+      fprintf(stderr,
+	      "%s: some vertices not inside convex hull\n", argv[0]) ;
 
     if ( write_times ) 
       fprintf(stderr, "%s: tetrahedralization finished: t=%lgs\n", 
@@ -43,15 +43,18 @@ gint main(gint argc, gchar **argv)
 
 {
   GtvVolume *v ;
-  GtsFile *f ;
+  guint line ;
+  gint status ;
   FILE *input, *output ;
   gchar ch ;
+  gboolean binary ;
   GLogLevelFlags log_level ;
 
   input = stdin ; output = stdout ;
   log_level = G_LOG_LEVEL_MESSAGE ;
+  binary = FALSE ;
 
-  while ( (ch = getopt(argc, argv, "hL:")) != EOF ) {
+  while ( (ch = getopt(argc, argv, "bhL:")) != EOF ) {
     switch (ch) {
     default: 
     case 'h':
@@ -60,9 +63,11 @@ gint main(gint argc, gchar **argv)
       fprintf(stderr, 
 	      "Read a gtv volume and output it as a gmsh .msh file\n\n"
 	      "Options: \n"
+	      "  -b write a binary .msh file\n"
 	      "  -L# set the message logging level\n") ;
       return 0 ;
       break ;
+      case 'b': binary = TRUE ; break ;
       case 'L': log_level = 1 << atoi(optarg) ; break ;
     }
   }  
@@ -76,11 +81,18 @@ gint main(gint argc, gchar **argv)
 		     gtv_facet_class(),
 		     gts_edge_class(),
 		     gts_vertex_class()) ;
-  f = gts_file_new(input) ;
-  
-  gtv_volume_read(v, f) ;
+  if ( (line = gtv_volume_read_ascii(v, input)) != 0 ) {
+    fprintf(stderr, "%s: error in input at line %u\n", argv[0], line) ;
+    return 1 ;
+  }
 
-  gtv_volume_write_gmsh(v, output) ;
+  if ( binary ) status = gtv_volume_write_gmsh_binary(v, output) ;
+  else status = gtv_volume_write_gmsh(v, output) ;
+
+  if ( status != GTV_SUCCESS ) {
+    fprintf(stderr, "%s: error writing output\n", argv[0]) ;
+    return 1 ;
+  }
 
   return 0 ;
 }
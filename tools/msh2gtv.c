@@ -44,6 +44,8 @@ gint main(gint argc, gchar **argv)
 {
   GtvVolume *v ;
   FILE *input, *output ;
+  guint line ;
+  gint status ;
   GLogLevelFlags log_level ;
   gchar ch ;
 
@@ -76,7 +78,14 @@ gint main(gint argc, gchar **argv)
 		     gts_edge_class(),
 		     gts_vertex_class()) ;
 
-  gtv_volume_read_gmsh(input, v) ;
+  if ( (status = gtv_volume_read_gmsh(input, v, &line)) != GTV_SUCCESS ) {
+    if ( status == GTV_UNKNOWN_FORMAT )
+      fprintf(stderr, "%s: error in input at line %u\n", argv[0], line) ;
+    else
+      fprintf(stderr, "%s: elements do not form valid cells (error %d)\n",
+	      argv[0], status) ;
+    return 1 ;
+  }
   
   gtv_volume_write(v, output) ;
 